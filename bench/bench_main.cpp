@@ -0,0 +1,38 @@
+// hftools_bench entry point. Same flags as benchmark_main, but the results
+// are also written as JSON (hftools_bench.json, or HFTOOLS_BENCH_OUT) unless
+// --benchmark_out is given, so every run can be diffed against a baseline,
+// e.g. with google benchmark's tools/compare.py.
+
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv) {
+    std::vector<char*> args(argv, argv + argc);
+
+    bool hasOut = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]).rfind("--benchmark_out=", 0) == 0)
+            hasOut = true;
+    }
+
+    std::string out = "--benchmark_out=";
+    std::string format = "--benchmark_out_format=json";
+    if (!hasOut) {
+        const char* path = std::getenv("HFTOOLS_BENCH_OUT");
+        out += path && *path ? path : "hftools_bench.json";
+        args.push_back(out.data());
+        args.push_back(format.data());
+    }
+
+    int count = static_cast<int>(args.size());
+    args.push_back(nullptr);
+
+    benchmark::Initialize(&count, args.data());
+    if (benchmark::ReportUnrecognizedArguments(count, args.data()))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,136 @@
+// HFTools_ORM.h data access layer: DBValue conversions, timestamp parsing,
+// connection pool borrow / release, and reader materialization through
+// hftools::Repository over the in-memory store. Kept apart from the ORM_v1
+// benchmarks: the two ORM headers cannot share a translation unit.
+
+#include "hftools/model/HFTools_ORM.h"
+#include "hftools/model/InMemoryOrmDatabase.h"
+#include "hftools/model/Trade.h"
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <string>
+
+using hftools::db::DBValue;
+using hftools::model::Trade;
+
+namespace {
+
+void BM_DBValue_AsInt(benchmark::State& state) {
+    const DBValue v("1234567");
+    for (auto _ : state) {
+        int x = v.as<int>();
+        benchmark::DoNotOptimize(x);
+    }
+}
+BENCHMARK(BM_DBValue_AsInt);
+
+void BM_DBValue_AsDouble(benchmark::State& state) {
+    const DBValue v("1.08512");
+    for (auto _ : state) {
+        double x = v.as<double>();
+        benchmark::DoNotOptimize(x);
+    }
+}
+BENCHMARK(BM_DBValue_AsDouble);
+
+void BM_DBValue_AsString(benchmark::State& state) {
+    const DBValue v("2024-01-28 12:00:00");
+    for (auto _ : state) {
+        std::string x = v.as<std::string>();
+        benchmark::DoNotOptimize(x);
+    }
+}
+BENCHMARK(BM_DBValue_AsString);
+
+void BM_DBValue_AsTimestamp(benchmark::State& state) {
+    const DBValue v("2024-01-28 12:00:00");
+    for (auto _ : state) {
+        auto x = v.as<hftools::utils::Timestamp>();
+        benchmark::DoNotOptimize(x);
+    }
+}
+BENCHMARK(BM_DBValue_AsTimestamp);
+
+void BM_StringToTimePoint(benchmark::State& state) {
+    const std::string text = "2024-01-28 12:00:00";
+    for (auto _ : state) {
+        auto tp = hftools::utils::stringToTimePoint(text);
+        benchmark::DoNotOptimize(tp);
+    }
+}
+BENCHMARK(BM_StringToTimePoint);
+
+void BM_Trade_AutoToJson(benchmark::State& state) {
+    const Trade t(42, 7, 3, "BUY", 100000.0, 1.08512, "2024-01-28 12:00:00");
+    for (auto _ : state) {
+        nlohmann::json j = hftools::model::autoToJson(t);
+        benchmark::DoNotOptimize(j);
+    }
+}
+BENCHMARK(BM_Trade_AutoToJson);
+
+void BM_Trade_AutoFromJson(benchmark::State& state) {
+    const nlohmann::json j = hftools::model::autoToJson(Trade(42, 7, 3, "BUY", 100000.0, 1.08512, "2024-01-28 12:00:00"));
+    for (auto _ : state) {
+        Trade t = hftools::model::autoFromJson<Trade>(j);
+        benchmark::DoNotOptimize(t);
+    }
+}
+BENCHMARK(BM_Trade_AutoFromJson);
+
+// Stand-in connection: the pool only moves the pointer around
+struct PooledThing {
+    int uses = 0;
+};
+
+// Threads share one pool of 4: beyond that, borrow() waits
+void BM_ConnectionPool_BorrowRelease(benchmark::State& state) {
+    static hftools::db::ConnectionPool<PooledThing> pool(4, [] { return std::make_unique<PooledThing>(); });
+    for (auto _ : state) {
+        hftools::db::PooledConnGuard<PooledThing> guard{ pool.borrow(), pool };
+        ++guard.conn->uses;
+    }
+}
+BENCHMARK(BM_ConnectionPool_BorrowRelease)->Threads(1)->Threads(4)->Threads(8)->UseRealTime();
+
+struct Loaded {
+    std::shared_ptr<hftools::database::InMemoryStore> store = std::make_shared<hftools::database::InMemoryStore>();
+    hftools::db::InMemoryDatabase db{ store };
+    hftools::Repository<Trade> repo{ db };
+
+    explicit Loaded(int rows) {
+        store->createTable<Trade>();
+        for (int id = 1; id <= rows; ++id) {
+            db.execute("INSERT INTO trades (id, user_id, instrument_id, side, quantity, price, timestamp) "
+                       "VALUES ($1, $2, $3, $4, $5, $6, $7)",
+                       { std::to_string(id), "7", "3", "BUY", "100000", "1.08512", "2024-01-28 12:00:00" });
+        }
+    }
+};
+
+void BM_DbRepository_GetById(benchmark::State& state) {
+    Loaded fx(1000);
+    int id = 0;
+    for (auto _ : state) {
+        auto t = fx.repo.getById(id % 1000 + 1);
+        benchmark::DoNotOptimize(t);
+        ++id;
+    }
+}
+BENCHMARK(BM_DbRepository_GetById);
+
+// SELECT of every row into one DBReader, then a pass over its values
+void BM_DBReader_Materialize(benchmark::State& state) {
+    Loaded fx(static_cast<int>(state.range(0)));
+    for (auto _ : state) {
+        auto reader = fx.db.executeQuery("SELECT * FROM trades", {});
+        double sum = 0;
+        for (size_t row = 0; row < reader.rowCount(); ++row)
+            sum += reader.value(row, 5).as<double>();
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DBReader_Materialize)->Arg(1000);
+
+} // namespace
@@ -0,0 +1,94 @@
+// Row -> entity hydration: RowHydrator against the existing json and
+// ResultSet paths, for FXInstrument2 (ORM_v1) and Trade.
+
+#include "hftools/database/ResultSet.h"
+#include "hftools/model/ORM_v1.h"
+#include "hftools/model/RowHydrator.h"
+#include "hftools/model/Trade.h"
+#include <benchmark/benchmark.h>
+#include <string_view>
+
+using hftools::model::FXInstrument2;
+using hftools::model::RowHydrator;
+using hftools::model::Trade;
+
+namespace {
+
+// One row as a driver hands it over: text cells, in table column order
+const std::string_view kRow[] = { "42", "7", "3", "BUY", "100000", "1.08512", "2024-01-28 12:00:00" };
+
+nlohmann::json jsonRow() {
+    return nlohmann::json{
+        { "id", 42 },
+        { "userId", 7 },
+        { "instrumentId", 3 },
+        { "side", "BUY" },
+        { "quantity", 100000.0 },
+        { "price", 1.08512 },
+        { "timestamp", "2024-01-28 12:00:00" }
+    };
+}
+
+void BM_FXInstrument2_FromJson(benchmark::State& state) {
+    const nlohmann::json row = jsonRow();
+    for (auto _ : state) {
+        FXInstrument2 e = FXInstrument2::fromJson(row);
+        benchmark::DoNotOptimize(e);
+    }
+}
+BENCHMARK(BM_FXInstrument2_FromJson);
+
+void BM_FXInstrument2_RowHydrator(benchmark::State& state) {
+    for (auto _ : state) {
+        FXInstrument2 e = RowHydrator<FXInstrument2>::hydrate(kRow);
+        benchmark::DoNotOptimize(e);
+    }
+}
+BENCHMARK(BM_FXInstrument2_RowHydrator);
+
+void BM_Trade_FromJson(benchmark::State& state) {
+    const nlohmann::json row = Trade(42, 7, 3, "BUY", 100000.0, 1.08512, "2024-01-28 12:00:00").toJson();
+    for (auto _ : state) {
+        Trade t = Trade::fromJson(row);
+        benchmark::DoNotOptimize(t);
+    }
+}
+BENCHMARK(BM_Trade_FromJson);
+
+void BM_Trade_ResultSetGetters(benchmark::State& state) {
+    hftools::database::ResultSet rs;
+    rs.setColumnNames({ "id", "user_id", "instrument_id", "side", "quantity", "price", "timestamp" });
+    rs.beginRow();
+    for (int i = 0; i < rs.getColumnCount(); ++i) rs.append(i, kRow[i]);
+    rs.endRow();
+    rs.next();
+
+    for (auto _ : state) {
+        Trade t(rs.getInt("id"), rs.getInt("user_id"), rs.getInt("instrument_id"), rs.getField("side"),
+                rs.getDouble("quantity"), rs.getDouble("price"), rs.getField("timestamp"));
+        benchmark::DoNotOptimize(t);
+    }
+}
+BENCHMARK(BM_Trade_ResultSetGetters);
+
+void BM_Trade_RowHydrator(benchmark::State& state) {
+    for (auto _ : state) {
+        Trade t = RowHydrator<Trade>::hydrate(kRow);
+        benchmark::DoNotOptimize(t);
+    }
+}
+BENCHMARK(BM_Trade_RowHydrator);
+
+// SELECT * order differs from the traits (created_at first): hydrate through ordinals
+void BM_Trade_RowHydratorOrdinals(benchmark::State& state) {
+    const std::string_view row[] = { "2024-01-28 12:00:01", "42", "7", "3", "BUY", "100000", "1.08512", "2024-01-28 12:00:00" };
+    const size_t ordinals[] = { 1, 2, 3, 4, 5, 6, 7 };
+    for (auto _ : state) {
+        Trade t;
+        RowHydrator<Trade>::hydrate(row, ordinals, t);
+        benchmark::DoNotOptimize(t);
+    }
+}
+BENCHMARK(BM_Trade_RowHydratorOrdinals);
+
+} // namespace
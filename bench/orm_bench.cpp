@@ -0,0 +1,226 @@
+// ORM_v1 hot paths: metadata-driven json mapping, the prepared-statement
+// builders, and Repository round trips against the in-memory store (no
+// latency, so what is measured is the ORM and the json rows, not a server).
+
+#include "hftools/model/ORM_v1.h"
+#include "hftools/model/GroupCommitWriter.h"
+#include "hftools/model/InMemoryDatabase2.h"
+#include "hftools/model/Trade.h"
+#include "hftools/utils/Instrumentation.h"
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using hftools::model::FXInstrument2;
+
+namespace {
+
+FXInstrument2 makeInstrument(int id) {
+    FXInstrument2 e;
+    e._id = id;
+    e._userId = id % 16;
+    e._instrumentId = id % 8;
+    e._side = id % 2 ? "BUY" : "SELL";
+    e._quantity = 1000.0 * (id % 100);
+    e._price = 1.08 + id * 1e-5;
+    e._timestamp = "2024-01-28 12:00:00";
+    return e;
+}
+
+std::vector<FXInstrument2> makeInstruments(int count, int firstId = 1) {
+    std::vector<FXInstrument2> v;
+    v.reserve(count);
+    for (int i = 0; i < count; ++i) v.push_back(makeInstrument(firstId + i));
+    return v;
+}
+
+void BM_AutoToJson(benchmark::State& state) {
+    const FXInstrument2 e = makeInstrument(42);
+    for (auto _ : state) {
+        nlohmann::json j = autoToJson(e);
+        benchmark::DoNotOptimize(j);
+    }
+}
+BENCHMARK(BM_AutoToJson);
+
+void BM_AutoFromJson(benchmark::State& state) {
+    const nlohmann::json j = autoToJson(makeInstrument(42));
+    for (auto _ : state) {
+        FXInstrument2 e = autoFromJson<FXInstrument2>(j);
+        benchmark::DoNotOptimize(e);
+    }
+}
+BENCHMARK(BM_AutoFromJson);
+
+void BM_BuildInsertSQL(benchmark::State& state) {
+    for (auto _ : state) {
+        std::string sql = buildInsertSQL<FXInstrument2>();
+        benchmark::DoNotOptimize(sql);
+    }
+}
+BENCHMARK(BM_BuildInsertSQL);
+
+void BM_BuildInsertParams(benchmark::State& state) {
+    const FXInstrument2 e = makeInstrument(42);
+    for (auto _ : state) {
+        auto params = buildInsertParams(e);
+        benchmark::DoNotOptimize(params);
+    }
+}
+BENCHMARK(BM_BuildInsertParams);
+
+void BM_BuildUpdateSQL(benchmark::State& state) {
+    for (auto _ : state) {
+        std::string sql = buildUpdateSQL<FXInstrument2>();
+        benchmark::DoNotOptimize(sql);
+    }
+}
+BENCHMARK(BM_BuildUpdateSQL);
+
+// Arg: rows per statement
+void BM_BuildUpsertSQL(benchmark::State& state) {
+    const auto rows = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        std::string sql = buildUpsertSQL<FXInstrument2>(SqlDialect::PostgreSQL, rows);
+        benchmark::DoNotOptimize(sql);
+    }
+}
+BENCHMARK(BM_BuildUpsertSQL)->Arg(1)->Arg(100);
+
+void BM_BuildInsertReturningIdSQL(benchmark::State& state) {
+    const auto rows = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        std::string sql = buildInsertReturningIdSQL<FXInstrument2>(SqlDialect::PostgreSQL, rows);
+        benchmark::DoNotOptimize(sql);
+    }
+}
+BENCHMARK(BM_BuildInsertReturningIdSQL)->Arg(1)->Arg(100);
+
+// Run on the caller's thread for every statement once instrumentation is installed
+void BM_FingerprintSql(benchmark::State& state) {
+    const std::string sql = buildInsertManySQL<FXInstrument2>(SqlDialect::PostgreSQL, static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        std::string fingerprint = hftools::utils::fingerprintSql(sql);
+        benchmark::DoNotOptimize(fingerprint);
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(sql.size()));
+}
+BENCHMARK(BM_FingerprintSql)->Arg(1)->Arg(1000);
+
+// Store with `rows` instruments, ids 1..rows
+struct Loaded {
+    std::shared_ptr<hftools::database::InMemoryStore> store = std::make_shared<hftools::database::InMemoryStore>();
+    InMemoryDatabase2 db{ store };
+    Repository<FXInstrument2> repo{ db };
+
+    explicit Loaded(int rows) {
+        store->createTable<FXInstrument2>();
+        repo.upsertMany(makeInstruments(rows));
+    }
+};
+
+void BM_Repository_GetById(benchmark::State& state) {
+    Loaded fx(1000);
+    int id = 0;
+    for (auto _ : state) {
+        FXInstrument2 e = fx.repo.getById(id % 1000 + 1);
+        benchmark::DoNotOptimize(e);
+        ++id;
+    }
+}
+BENCHMARK(BM_Repository_GetById);
+
+void BM_Repository_GetAll(benchmark::State& state) {
+    Loaded fx(static_cast<int>(state.range(0)));
+    for (auto _ : state) {
+        auto all = fx.repo.getAll();
+        benchmark::DoNotOptimize(all);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Repository_GetAll)->Arg(1000);
+
+// Trade's columns (user_id, instrument_id) differ from its toJson() keys:
+// writes and reads must both go through EntityTraits<Trade>
+void BM_Repository_Trade_RoundTrip(benchmark::State& state) {
+    auto store = std::make_shared<hftools::database::InMemoryStore>();
+    store->createTable<hftools::model::Trade>();
+    InMemoryDatabase2 db(store);
+    Repository<hftools::model::Trade> repo(db);
+    int id = 0;
+    for (auto _ : state) {
+        ++id;
+        const hftools::model::Trade t(id, id % 16, id % 8, "BUY", 1000.0, 1.08, "2024-01-28T12:00:00Z");
+        repo.insert(t);
+        const hftools::model::Trade back = repo.getById(id);
+        if (back.getUserId() != t.getUserId() || back.getInstrumentId() != t.getInstrumentId()
+            || back.getPrice() != t.getPrice()) {
+            state.SkipWithError("Trade did not survive the round trip");
+            break;
+        }
+    }
+}
+BENCHMARK(BM_Repository_Trade_RoundTrip);
+
+// Arg: batch size; the same keys are upserted again each iteration
+void BM_Repository_UpsertMany(benchmark::State& state) {
+    Loaded fx(0);
+    const auto batch = makeInstruments(static_cast<int>(state.range(0)));
+    for (auto _ : state) {
+        size_t n = fx.repo.upsertMany(batch);
+        benchmark::DoNotOptimize(n);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Repository_UpsertMany)->Arg(1)->Arg(100);
+
+// Concurrent single-row inserts against a store charging 100 us per
+// statement, all threads sharing one connection (a pool of one, or a server
+// whose commits serialize on the log): one autocommit INSERT per call under
+// a lock, versus one GroupCommitWriter batching whatever is waiting
+struct SlowStore {
+    std::shared_ptr<hftools::database::InMemoryStore> store =
+        std::make_shared<hftools::database::InMemoryStore>(hftools::database::InMemoryLatency{ std::chrono::microseconds(100) });
+    std::atomic<int> nextId{ 1 };
+
+    SlowStore() { store->createTable<FXInstrument2>(); }
+
+    static SlowStore& instance() {
+        static SlowStore s;
+        return s;
+    }
+};
+
+void BM_ConcurrentInsert_PerCall(benchmark::State& state) {
+    struct Shared {
+        InMemoryDatabase2 db{ SlowStore::instance().store };
+        Repository<FXInstrument2> repo{ db };
+        std::mutex mutex;
+    };
+    static Shared shared;
+    SlowStore& slow = SlowStore::instance();
+    for (auto _ : state) {
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        shared.repo.insert(makeInstrument(slow.nextId++));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ConcurrentInsert_PerCall)->Threads(1)->Threads(8)->Threads(32)->UseRealTime();
+
+void BM_ConcurrentInsert_GroupCommit(benchmark::State& state) {
+    struct Writer {
+        InMemoryDatabase2 db{ SlowStore::instance().store };
+        GroupCommitWriter<FXInstrument2> writer{ db, { 256, std::chrono::microseconds(100) } };
+    };
+    static Writer shared;
+    SlowStore& slow = SlowStore::instance();
+    for (auto _ : state) {
+        shared.writer.insert(makeInstrument(slow.nextId++)).get();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ConcurrentInsert_GroupCommit)->Threads(1)->Threads(8)->Threads(32)->UseRealTime();
+
+} // namespace
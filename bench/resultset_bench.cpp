@@ -0,0 +1,114 @@
+// ResultSet: cursor iteration with the by-name getters, text cells against
+// the typed cells the binary drivers append, and the by-ordinal view path.
+
+#include "hftools/database/ResultSet.h"
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <string>
+
+using hftools::database::ResultSet;
+
+namespace {
+
+constexpr int kRows = 1024;
+
+// Trade-shaped rows; typed = appendInt / appendDouble, as PostgreSQLConnection does
+std::unique_ptr<ResultSet> makeTrades(bool typed) {
+    auto rs = std::make_unique<ResultSet>();
+    rs->setColumnNames({ "id", "user_id", "instrument_id", "side", "quantity", "price", "timestamp" });
+    rs->reserveRows(kRows);
+    for (int i = 0; i < kRows; ++i) {
+        rs->beginRow();
+        if (typed) {
+            rs->appendInt(0, i);
+            rs->appendInt(1, i % 16);
+            rs->appendInt(2, i % 8);
+        } else {
+            rs->append(0, std::to_string(i));
+            rs->append(1, std::to_string(i % 16));
+            rs->append(2, std::to_string(i % 8));
+        }
+        rs->append(3, i % 2 ? "BUY" : "SELL");
+        if (typed) {
+            rs->appendDouble(4, 1000.0 * (i % 100));
+            rs->appendDouble(5, 1.08 + i * 1e-5);
+        } else {
+            rs->append(4, std::to_string(1000.0 * (i % 100)));
+            rs->append(5, std::to_string(1.08 + i * 1e-5));
+        }
+        rs->append(6, "2024-01-28 12:00:00");
+        rs->endRow();
+    }
+    return rs;
+}
+
+// The cursor only moves forward, so each iteration walks a fresh copy
+void iterateByName(benchmark::State& state, bool typed) {
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto rs = makeTrades(typed);
+        state.ResumeTiming();
+
+        double notional = 0;
+        int64_t ids = 0;
+        while (rs->next()) {
+            ids += rs->getInt("id") + rs->getInt("user_id") + rs->getInt("instrument_id");
+            notional += rs->getDouble("quantity") * rs->getDouble("price");
+        }
+        benchmark::DoNotOptimize(ids);
+        benchmark::DoNotOptimize(notional);
+    }
+    state.SetItemsProcessed(state.iterations() * kRows);
+}
+
+void BM_ResultSet_IterateTextCells(benchmark::State& state) { iterateByName(state, false); }
+BENCHMARK(BM_ResultSet_IterateTextCells);
+
+void BM_ResultSet_IterateTypedCells(benchmark::State& state) { iterateByName(state, true); }
+BENCHMARK(BM_ResultSet_IterateTypedCells);
+
+void BM_ResultSet_GetInt(benchmark::State& state) {
+    auto rs = makeTrades(false);
+    rs->next();
+    for (auto _ : state) {
+        int v = rs->getInt("instrument_id");
+        benchmark::DoNotOptimize(v);
+    }
+}
+BENCHMARK(BM_ResultSet_GetInt);
+
+void BM_ResultSet_GetDouble(benchmark::State& state) {
+    auto rs = makeTrades(false);
+    rs->next();
+    for (auto _ : state) {
+        double v = rs->getDouble("price");
+        benchmark::DoNotOptimize(v);
+    }
+}
+BENCHMARK(BM_ResultSet_GetDouble);
+
+// Ordinals resolved once, then no cursor and no name lookups
+void BM_ResultSet_FieldViewByOrdinal(benchmark::State& state) {
+    auto rs = makeTrades(false);
+    const int side = rs->findColumn("side");
+    const int timestamp = rs->findColumn("timestamp");
+    for (auto _ : state) {
+        size_t bytes = 0;
+        for (int row = 0; row < kRows; ++row)
+            bytes += rs->getFieldView(row, side).size() + rs->getFieldView(row, timestamp).size();
+        benchmark::DoNotOptimize(bytes);
+    }
+    state.SetItemsProcessed(state.iterations() * kRows);
+}
+BENCHMARK(BM_ResultSet_FieldViewByOrdinal);
+
+void BM_ResultSet_Build(benchmark::State& state) {
+    for (auto _ : state) {
+        auto rs = makeTrades(false);
+        benchmark::DoNotOptimize(rs);
+    }
+    state.SetItemsProcessed(state.iterations() * kRows);
+}
+BENCHMARK(BM_ResultSet_Build);
+
+} // namespace
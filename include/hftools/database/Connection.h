@@ -1,5 +1,6 @@
 #pragma once
 
+#include "hftools/utils/Instrumentation.h"
 #include <string>
 #include <memory>
 
@@ -31,6 +32,17 @@ public:
      */
     virtual int execCommand(const std::string& command);
 
+    /**
+     * @brief Load many rows into a table
+     *
+     * The default issues one INSERT per row with quoted literals; drivers
+     * with a bulk-copy protocol override it.
+     * @param table Target table
+     * @param rows Column names and values to load; NULL cells load as NULL
+     * @return Number of rows inserted
+     */
+    virtual int bulkInsert(const std::string& table, const ResultSet& rows);
+
     /**
      * @brief Check if connection is open
      * @return true if connected, false otherwise
@@ -52,10 +64,22 @@ public:
      */
     std::string getConnectionString() const { return connectionString_; }
 
+    /**
+     * @brief Report every statement of this connection to an instrumentation (null to stop)
+     *
+     * Connections start with utils::defaultInstrumentation(). Not thread-safe
+     * against statements running on this connection.
+     */
+    void setInstrumentation(std::shared_ptr<utils::QueryInstrumentation> instrumentation) {
+        instrumentation_ = std::move(instrumentation);
+    }
+    std::shared_ptr<utils::QueryInstrumentation> getInstrumentation() const { return instrumentation_; }
+
 protected:
     std::string dbType_;
     std::string connectionString_;
     bool connected_;
+    std::shared_ptr<utils::QueryInstrumentation> instrumentation_;
 };
 
 } // namespace database
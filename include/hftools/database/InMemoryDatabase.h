@@ -0,0 +1,223 @@
+#pragma once
+
+#include "IDatabase.h"
+#include "Connection.h"
+#include "hftools/model/EntityTraits.h"
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace hftools {
+namespace database {
+
+/**
+ * @brief Storage type of an in-memory column; values are coerced to it on write
+ */
+enum class InMemoryType { Int, Double, Text, Bool };
+
+struct InMemoryColumn {
+    std::string name;
+    InMemoryType type;
+};
+
+/**
+ * @brief Simulated server round trip, charged (as a sleep) to every statement
+ *
+ * The sleep happens outside the store's lock, so concurrent sessions overlap
+ * their latency the way connections to a real server do.
+ */
+struct InMemoryLatency {
+    std::chrono::microseconds perStatement{ 0 };
+    std::chrono::nanoseconds perRow{ 0 };        // per row returned or written
+};
+
+/**
+ * @brief Outcome of one statement: result rows (SELECT / RETURNING) and rows affected
+ */
+struct InMemoryResult {
+    std::vector<std::string> columns;
+    std::vector<std::vector<nlohmann::json>> rows;   // null json = SQL NULL
+    int affected = 0;
+};
+
+/**
+ * @brief Text form of a stored value, as a driver would hand it over ("t"/"f" for booleans)
+ */
+std::string inMemoryText(const nlohmann::json& value);
+
+/**
+ * @brief Deterministic in-process SQL store for benchmarks and tests
+ *
+ * Holds real tables keyed by an integer primary key (kept ordered, so scans
+ * and unordered SELECTs come back in key order) and understands the SQL the
+ * ORM builders generate:
+ * - SELECT [TOP n] * | cols FROM t [WHERE ...] [ORDER BY ...] [LIMIT n] [OFFSET m],
+ *   with =, <>, <, <=, >, >=, IN (...), = ANY($1), IS [NOT] NULL, row
+ *   comparisons (a, b) > ($1, $2), AND / OR and parentheses
+ * - INSERT INTO t (cols) VALUES (...), ... [ON CONFLICT (pk) DO NOTHING |
+ *   DO UPDATE SET c = EXCLUDED.c, ...] [RETURNING cols]; a missing primary
+ *   key is generated like SERIAL / IDENTITY
+ * - UPDATE t SET c = v, ... [WHERE ...], DELETE FROM t [WHERE ...]
+ * - BEGIN / COMMIT / ROLLBACK (see InMemorySession)
+ *
+ * Parameters are $n or ?; literals are numbers, 'strings' and NULL.
+ * Lookups on the primary key (=, IN, ANY, >, >=) use the key index instead
+ * of a scan. Parsed statements are cached by SQL text, like server-side
+ * prepared statements. Sybase batches (MERGE, DECLARE) are not supported.
+ *
+ * Thread-safe: reads share a lock, writes take it exclusively.
+ */
+class InMemoryStore {
+public:
+    explicit InMemoryStore(InMemoryLatency latency = {});
+    ~InMemoryStore();
+
+    InMemoryStore(const InMemoryStore&) = delete;
+    InMemoryStore& operator=(const InMemoryStore&) = delete;
+
+    /**
+     * @brief Create (or replace) a table
+     * @param primaryKey Name of an Int column
+     * @throws std::invalid_argument if the key column is missing or not Int
+     */
+    void createTable(const std::string& name, std::vector<InMemoryColumn> columns, const std::string& primaryKey);
+
+    /**
+     * @brief Create a table from EntityTraits<T>: name, columns, member types and key
+     */
+    template <typename T>
+    void createTable();
+
+    void setLatency(InMemoryLatency latency);
+    InMemoryLatency latency() const;
+
+    /**
+     * @brief Number of rows currently in a table
+     */
+    size_t rowCount(const std::string& table) const;
+
+    /**
+     * @brief Delete every row of every table; tables and generated-key counters are reset
+     */
+    void truncate();
+
+    /**
+     * @brief Statements executed so far, across all sessions
+     */
+    uint64_t statementCount() const;
+
+private:
+    friend class InMemorySession;
+
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+/**
+ * @brief One client of an InMemoryStore, with its own transaction state
+ *
+ * Statements are atomic. Between BEGIN and COMMIT / ROLLBACK the session
+ * keeps an undo log; ROLLBACK (or destroying the session) puts the rows it
+ * changed back. Changes are visible to other sessions immediately: there
+ * is no isolation, which is fine for single-writer benchmarks.
+ */
+class InMemorySession {
+public:
+    explicit InMemorySession(std::shared_ptr<InMemoryStore> store);
+    ~InMemorySession();
+
+    InMemorySession(const InMemorySession&) = delete;
+    InMemorySession& operator=(const InMemorySession&) = delete;
+
+    /**
+     * @throws std::invalid_argument for SQL it cannot parse
+     * @throws std::runtime_error for unknown tables / columns and key violations
+     */
+    InMemoryResult execute(const std::string& sql, const std::vector<nlohmann::json>& params = {});
+
+    bool inTransaction() const;
+
+    InMemoryStore& store() { return *store_; }
+
+private:
+    struct Transaction;   // undo log of an open transaction
+
+    void rollback();
+
+    std::shared_ptr<InMemoryStore> store_;
+    std::unique_ptr<Transaction> txn_;
+    mutable std::mutex mutex_;
+};
+
+/**
+ * @brief IDatabase over an InMemoryStore; every connection shares the store
+ */
+class InMemoryDatabase : public IDatabase {
+public:
+    explicit InMemoryDatabase(std::shared_ptr<InMemoryStore> store = std::make_shared<InMemoryStore>());
+    virtual ~InMemoryDatabase() = default;
+
+    /**
+     * @brief Open a session on the store
+     * @param connectionString Only kept for getConnectionString()
+     */
+    std::shared_ptr<Connection> openConnection(const std::string& connectionString) override;
+
+    /**
+     * @brief Get database type
+     * @return "InMemory"
+     */
+    std::string getDatabaseType() const override;
+
+    InMemoryStore& store() { return *store_; }
+
+private:
+    std::shared_ptr<InMemoryStore> store_;
+};
+
+/**
+ * @brief Connection returned by InMemoryDatabase
+ *
+ * Integer and floating-point values are handed to the ResultSet as typed
+ * cells, the way the binary-protocol drivers do.
+ */
+class InMemoryConnection : public Connection {
+public:
+    InMemoryConnection(std::shared_ptr<InMemoryStore> store, const std::string& connectionString);
+    virtual ~InMemoryConnection();
+
+    std::shared_ptr<ResultSet> execQuery(const std::string& query) override;
+    int execCommand(const std::string& command) override;
+    bool isConnected() const override;
+    void close() override;
+
+private:
+    std::unique_ptr<InMemorySession> session_;
+};
+
+template <typename T>
+void InMemoryStore::createTable() {
+    using Traits = model::EntityTraits<T>;
+    std::vector<InMemoryColumn> columns;
+    std::apply([&](const auto&... col) {
+        auto typeOf = [](const auto& c) {
+            using Field = std::decay_t<decltype(std::declval<T&>().*(c.member))>;
+            if constexpr (std::is_same_v<Field, bool>) return InMemoryType::Bool;
+            else if constexpr (std::is_integral_v<Field>) return InMemoryType::Int;
+            else if constexpr (std::is_floating_point_v<Field>) return InMemoryType::Double;
+            else return InMemoryType::Text;
+        };
+        (columns.push_back(InMemoryColumn{ std::string(col.name), typeOf(col) }), ...);
+    }, Traits::columns);
+    createTable(std::string(Traits::tableName), std::move(columns), std::string(Traits::primaryKey));
+}
+
+} // namespace database
+} // namespace hftools
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "IDatabase.h"
+#include "hftools/utils/HdrHistogram.h"
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace hftools {
+namespace database {
+
+/**
+ * @brief Statement mix driven by LoadGenerator, against the trades table
+ */
+enum class Workload {
+    InsertTrades,   // INSERT of a new trade (key generated by the database)
+    PointLookup,    // SELECT * ... WHERE id = k
+    RangeScan,      // keyset page: SELECT * ... WHERE id >= k ORDER BY id, scanRows rows
+    Mixed           // readRatio point lookups, the rest UPDATEs of one trade's price
+};
+
+/**
+ * @brief How requests are issued
+ *
+ * Closed: each worker sends its next request when the previous one returns
+ * (maximum throughput, latency = service time).
+ * FixedRate: requests are scheduled every threads / rate seconds per worker.
+ * Poisson: open-loop arrivals with exponential gaps at the same mean rate.
+ * For the scheduled modes latency is measured from the intended start, so
+ * time spent queued behind a slow request counts (no coordinated omission).
+ */
+enum class Arrival { Closed, FixedRate, Poisson };
+
+struct LoadOptions {
+    Workload workload = Workload::PointLookup;
+    Arrival arrival = Arrival::Closed;
+    int threads = 4;                                 // one connection per thread
+    double rate = 0;                                 // total requests / s (FixedRate, Poisson)
+    std::chrono::seconds duration{ 10 };
+    std::chrono::seconds warmup{ 0 };                // run, but not recorded
+    int keySpace = 10000;                            // trades loaded before the run
+    int scanRows = 100;
+    double readRatio = 0.9;                          // Mixed only
+    bool cleanup = true;                             // delete the loaded / inserted trades afterwards
+    uint64_t seed = 42;
+};
+
+/**
+ * @brief Results of one operation type (latencies in nanoseconds)
+ */
+struct OperationStats {
+    std::string name;
+    utils::HdrHistogram latency;
+    int64_t errors = 0;
+};
+
+struct LoadReport {
+    std::string databaseType;
+    LoadOptions options;
+    std::chrono::nanoseconds elapsed{ 0 };           // measured part of the run
+    std::vector<OperationStats> operations;          // only the types the workload issues
+
+    int64_t totalOperations() const;
+    int64_t totalErrors() const;
+    double throughput() const;                       // successful operations / s
+
+    /**
+     * @brief Human-readable table: throughput, then p50 / p90 / p99 / p99.9 / max per operation
+     */
+    void print(std::ostream& out) const;
+};
+
+/**
+ * @brief Concurrent load generator over an IDatabase
+ *
+ * Loads keySpace trades (user 1, instrument 1, which the sample schema
+ * provides), runs the workload from `threads` connections for `duration`,
+ * then deletes every trade above the pre-run maximum id unless cleanup is
+ * off. Point lookups, scans and updates pick keys uniformly from the loaded
+ * range. Run it against a database nobody else writes trades to.
+ */
+class LoadGenerator {
+public:
+    /**
+     * @param connectionString Passed to db->openConnection() for each thread
+     * @throws std::invalid_argument for invalid options
+     */
+    LoadGenerator(std::shared_ptr<IDatabase> db, std::string connectionString, LoadOptions options);
+
+    /**
+     * @throws std::runtime_error if the database cannot be reached or prepared
+     */
+    LoadReport run();
+
+private:
+    std::shared_ptr<IDatabase> db_;
+    std::string connectionString_;
+    LoadOptions options_;
+};
+
+Workload parseWorkload(const std::string& name);   // insert | lookup | scan | mixed
+Arrival parseArrival(const std::string& name);     // closed | fixed | poisson
+
+} // namespace database
+} // namespace hftools
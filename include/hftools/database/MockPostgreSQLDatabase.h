@@ -0,0 +1,52 @@
+#pragma once
+
+#include "IDatabase.h"
+#include "Connection.h"
+#include <memory>
+#include <string>
+
+namespace hftools {
+namespace database {
+
+/**
+ * @brief In-process stand-in for PostgreSQLDatabase
+ *
+ * Never touches the network: connections always succeed and SELECTs on
+ * users / fxinstruments / trades return a few canned rows. Select it
+ * explicitly for demos and tests that must run without a server.
+ */
+class MockPostgreSQLDatabase : public IDatabase {
+public:
+    MockPostgreSQLDatabase() = default;
+    virtual ~MockPostgreSQLDatabase() = default;
+
+    /**
+     * @brief Open a simulated connection
+     * @param connectionString Only echoed, never parsed
+     * @return Shared pointer to Connection object
+     */
+    std::shared_ptr<Connection> openConnection(const std::string& connectionString) override;
+
+    /**
+     * @brief Get database type
+     * @return "PostgreSQL (mock)"
+     */
+    std::string getDatabaseType() const override;
+};
+
+/**
+ * @brief Connection returned by MockPostgreSQLDatabase
+ */
+class MockPostgreSQLConnection : public Connection {
+public:
+    MockPostgreSQLConnection(const std::string& connectionString);
+    virtual ~MockPostgreSQLConnection();
+
+    std::shared_ptr<ResultSet> execQuery(const std::string& query) override;
+    int execCommand(const std::string& command) override;
+    bool isConnected() const override;
+    void close() override;
+};
+
+} // namespace database
+} // namespace hftools
@@ -5,11 +5,18 @@
 #include <memory>
 #include <string>
 
+// libpq handles (PGconn / PGresult), kept opaque so libpq-fe.h stays out of this header
+struct pg_conn;
+struct pg_result;
+
 namespace hftools {
 namespace database {
 
 /**
- * @brief PostgreSQL database implementation
+ * @brief PostgreSQL database implementation (libpq)
+ *
+ * Requires a build with libpq (HFTOOLS_HAS_LIBPQ); otherwise opening a
+ * connection throws. MockPostgreSQLDatabase is the server-less stand-in.
  */
 class PostgreSQLDatabase : public IDatabase {
 public:
@@ -32,20 +39,42 @@ public:
 
 /**
  * @brief PostgreSQL-specific connection
+ *
+ * The socket is non-blocking throughout: the connection is established with
+ * PQconnectStart/PQconnectPoll, and queries are sent with PQsendQueryParams
+ * asking for binary results in single-row mode, so each row is decoded
+ * straight into the ResultSet as it arrives instead of after the whole
+ * result has been buffered by libpq.
  */
 class PostgreSQLConnection : public Connection {
 public:
-    PostgreSQLConnection(const std::string& connectionString);
+    /**
+     * @param connectionString libpq conninfo, e.g. "host=localhost port=5432 dbname=mydb user=postgres"
+     * @param connectTimeoutMs Give up connecting after this long
+     * @throws std::runtime_error if the connection cannot be established
+     */
+    PostgreSQLConnection(const std::string& connectionString, int connectTimeoutMs = 10000);
     virtual ~PostgreSQLConnection();
 
+    PostgreSQLConnection(const PostgreSQLConnection&) = delete;
+    PostgreSQLConnection& operator=(const PostgreSQLConnection&) = delete;
+
+    /**
+     * @throws std::runtime_error on connection loss or a server-side error
+     */
     std::shared_ptr<ResultSet> execQuery(const std::string& query) override;
     int execCommand(const std::string& command) override;
     bool isConnected() const override;
     void close() override;
 
 private:
-    // In a real implementation, this would hold libpq connection handle
-    void* pgConn_; // PGconn* in real implementation
+    void send(const std::string& sql, bool singleRowMode);
+    pg_result* nextResult();
+    void discardResults();
+    void waitSocket(bool forWrite, int timeoutMs);
+    [[noreturn]] void fail(const std::string& what);
+
+    pg_conn* pgConn_;
 };
 
 } // namespace database
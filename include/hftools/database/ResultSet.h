@@ -1,20 +1,41 @@
 #pragma once
 
+#include <cstdint>
+#include <initializer_list>
+#include <map>
+#include <memory>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <map>
 
 namespace hftools {
 namespace database {
 
 /**
  * @brief Represents a result set from a database query
+ *
+ * Field text is copied into a per-result arena (a monotonic buffer) and each
+ * cell is a view into it, so loading a result costs a handful of block
+ * allocations instead of one per value. The arena is released in one go when
+ * the result set is destroyed.
  */
 class ResultSet {
 public:
     ResultSet();
+
+    /**
+     * @brief Create a result set whose arena draws its blocks from upstream
+     * @param upstream Memory resource backing the arena and the cell index (must outlive the result set)
+     * @param initialBytes Size of the first arena block; a good guess avoids any regrowth
+     */
+    explicit ResultSet(std::pmr::memory_resource* upstream, size_t initialBytes = 0);
+
     virtual ~ResultSet();
 
+    ResultSet(ResultSet&&) noexcept;
+    ResultSet& operator=(ResultSet&&) noexcept;
+
     /**
      * @brief Move to the next row in the result set
      * @return true if there is a next row, false otherwise
@@ -28,6 +49,13 @@ public:
      */
     virtual std::string getField(const std::string& columnName) const;
 
+    /**
+     * @brief Get a field value without copying it
+     * @param columnName Name of the column
+     * @return View into the result's arena, valid as long as the result set
+     */
+    std::string_view getFieldView(const std::string& columnName) const;
+
     /**
      * @brief Get a field value as integer
      * @param columnName Name of the column
@@ -67,14 +95,92 @@ public:
      */
     virtual std::vector<std::string> getColumnNames() const;
 
+    /**
+     * @brief Ordinal of a column, or -1 if there is no such column
+     */
+    int findColumn(std::string_view columnName) const;
+
+    /**
+     * @brief Random access to a cell, independent of the next() cursor
+     * @return View into the arena; data() is nullptr if the cell is NULL
+     */
+    std::string_view getFieldView(int row, int ordinal) const;
+
+    /**
+     * @brief Start a new row; every cell starts out NULL
+     *
+     * Drivers fill rows with beginRow(), append() per column and endRow();
+     * values go straight into the result's arena with no per-row map or key copies.
+     * Column names must be set first.
+     */
+    void beginRow();
+
+    /**
+     * @brief Set a cell of the row being built
+     * @param ordinal Column position, 0-based, in getColumnNames() order
+     * @param value Field text; copied, so it only has to live until the call returns
+     */
+    void append(int ordinal, std::string_view value);
+
+    /**
+     * @brief Set a cell from a value the driver already decoded (binary protocol)
+     *
+     * The value is kept as-is for getInt()/getDouble(), which then skip text
+     * parsing; its text form is what getField() returns.
+     */
+    void appendInt(int ordinal, int64_t value);
+    void appendDouble(int ordinal, double value);
+
+    /**
+     * @brief Finish the row being built
+     */
+    void endRow();
+
+    /**
+     * @brief beginRow(), append() of each value in column order, endRow()
+     */
+    void appendRow(std::initializer_list<std::string_view> values);
+
     // For testing/mock implementation
     void addRow(const std::map<std::string, std::string>& row);
     void setColumnNames(const std::vector<std::string>& names);
 
+    /**
+     * @brief Pre-size cell storage for rows x getColumnCount() cells
+     */
+    void reserveRows(size_t rows);
+
+    /**
+     * @brief Bytes of field text appended so far (the result payload)
+     */
+    size_t getDataSize() const { return dataBytes_; }
+
 protected:
-    std::vector<std::map<std::string, std::string>> rows_;
+    enum class CellKind : uint8_t { Text, Int, Double };
+
+    struct Cell {
+        const char* data;
+        uint32_t size;
+        bool isNull;
+        CellKind kind;
+        union {
+            int64_t intValue;
+            double doubleValue;
+        };
+    };
+
+    // Copies text into the arena and stores it in the given cell of the open row
+    Cell& setCell(int ordinal, std::string_view text);
+
+    const Cell& cell(const std::string& columnName) const;
+
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> arena_;
+    std::pmr::vector<Cell> cells_;              // row-major, getColumnCount() per row; from upstream
     std::vector<std::string> columnNames_;
+    int rowCount_;
     int currentRow_;
+    bool rowOpen_;
+    size_t dataBytes_ = 0;
 };
 
 } // namespace database
@@ -9,7 +9,10 @@ namespace hftools {
 namespace database {
 
 /**
- * @brief Sybase database implementation
+ * @brief Sybase ASE database implementation (FreeTDS DB-Library)
+ *
+ * Requires a build with DB-Library (HFTOOLS_HAS_SYBDB); otherwise opening a
+ * connection throws. MockSybaseDatabase is the server-less stand-in.
  */
 class SybaseDatabase : public IDatabase {
 public:
@@ -32,20 +35,47 @@ public:
 
 /**
  * @brief Sybase-specific connection
+ *
+ * Rows are fetched with DB-Library row buffering (DBBUFFER) and numeric and
+ * datetime columns are bound to native host variables (dbbind), so integers
+ * and floats reach the ResultSet without a text round trip. bulkInsert()
+ * uses the bulk-copy (bcp) protocol instead of INSERT statements.
  */
 class SybaseConnection : public Connection {
 public:
+    /**
+     * @param connectionString "server=myserver;database=mydb;user=sa;password=pass[;appname=...]";
+     *        server is an entry of freetds.conf / the interfaces file
+     * @throws std::runtime_error if the login fails
+     */
     SybaseConnection(const std::string& connectionString);
     virtual ~SybaseConnection();
 
+    SybaseConnection(const SybaseConnection&) = delete;
+    SybaseConnection& operator=(const SybaseConnection&) = delete;
+
+    /**
+     * @throws std::runtime_error on a server or client-library error
+     */
     std::shared_ptr<ResultSet> execQuery(const std::string& query) override;
     int execCommand(const std::string& command) override;
+
+    /**
+     * @brief Bulk-copy rows into a table
+     *
+     * bcp loads by position: the columns of rows must be the table's
+     * columns, in table order. Rows are committed in batches of 1000.
+     */
+    int bulkInsert(const std::string& table, const ResultSet& rows) override;
+
     bool isConnected() const override;
     void close() override;
 
 private:
-    // In a real implementation, this would hold Sybase connection handle
-    void* sybaseConn_; // DBPROCESS* in real implementation
+    void execute(const std::string& sql);
+    [[noreturn]] void fail(const std::string& what);
+
+    void* sybaseConn_; // DBPROCESS*, kept opaque so sybdb.h stays out of this header
 };
 
 } // namespace database
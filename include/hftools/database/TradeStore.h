@@ -0,0 +1,296 @@
+#pragma once
+
+#include "hftools/model/Trade.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hftools {
+namespace database {
+
+/**
+ * @brief Per-block zone map used to skip blocks during range scans
+ *
+ * rowCount is stored with release once the row and the bounds are written,
+ * so a reader that loads it with acquire sees complete rows.
+ */
+struct TradeZoneMap {
+    std::atomic<uint32_t> rowCount;
+    uint32_t reserved;
+    int64_t minTimestamp;
+    int64_t maxTimestamp;
+    int32_t minId;
+    int32_t maxId;
+    int32_t minInstrumentId;
+    int32_t maxInstrumentId;
+    int32_t minUserId;
+    int32_t maxUserId;
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free && sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+              "TradeZoneMap lives in the mapped file: rowCount must be a plain lock-free 32-bit word");
+
+/**
+ * @brief Read-only view over the columns of one mapped block (no copy)
+ */
+struct TradeBlockView {
+    const TradeZoneMap* zone;
+    const int64_t* timestamp;   // microseconds since epoch (UTC)
+    const double* quantity;
+    const double* price;
+    const int32_t* id;
+    const int32_t* userId;
+    const int32_t* instrumentId;
+    const char* side;           // 'B' or 'S'
+
+    size_t size() const { return zone->rowCount.load(std::memory_order_acquire); }
+};
+
+/**
+ * @brief Reference to a single row inside a mapped block
+ */
+class TradeRef {
+public:
+    TradeRef(const TradeBlockView* block, size_t row) : block_(block), row_(row) {}
+
+    int getId() const { return block_->id[row_]; }
+    int getUserId() const { return block_->userId[row_]; }
+    int getInstrumentId() const { return block_->instrumentId[row_]; }
+    std::string_view getSide() const { return block_->side[row_] == 'S' ? "SELL" : "BUY"; }
+    double getQuantity() const { return block_->quantity[row_]; }
+    double getPrice() const { return block_->price[row_]; }
+    int64_t getTimestampMicros() const { return block_->timestamp[row_]; }
+
+    /**
+     * @brief Materialize the row as a model::Trade (allocates)
+     */
+    model::Trade toTrade() const;
+
+private:
+    const TradeBlockView* block_;
+    size_t row_;
+};
+
+/**
+ * @brief Filter applied by TradeStore range scans
+ *
+ * Timestamps are microseconds since epoch; the range is [from, to).
+ * A negative instrumentId/userId means "any".
+ */
+struct TradeFilter {
+    int64_t from = std::numeric_limits<int64_t>::min();
+    int64_t to = std::numeric_limits<int64_t>::max();
+    int instrumentId = -1;
+    int userId = -1;
+
+    bool mayMatch(const TradeZoneMap& z) const {
+        return z.rowCount.load(std::memory_order_acquire) != 0 && z.maxTimestamp >= from && z.minTimestamp < to
+            && (instrumentId < 0 || (instrumentId >= z.minInstrumentId && instrumentId <= z.maxInstrumentId))
+            && (userId < 0 || (userId >= z.minUserId && userId <= z.maxUserId));
+    }
+
+    bool matches(const TradeBlockView& b, size_t i) const {
+        return b.timestamp[i] >= from && b.timestamp[i] < to
+            && (instrumentId < 0 || b.instrumentId[i] == instrumentId)
+            && (userId < 0 || b.userId[i] == userId);
+    }
+};
+
+class TradeStore;
+
+/**
+ * @brief Lazy range over the rows of a TradeStore matching a TradeFilter
+ *
+ * Iteration yields TradeRef values pointing into the mapping; nothing is
+ * copied. Blocks whose zone map cannot match the filter are skipped.
+ * A range (and its refs) is invalidated when the store grows or is refreshed.
+ */
+class TradeRange {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = TradeRef;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = TradeRef;
+
+        iterator() = default;
+        iterator(const TradeRange* range, size_t block, size_t row)
+            : range_(range), block_(block), row_(row) { settle(); }
+
+        TradeRef operator*() const { return TradeRef(&range_->blocks_[block_], row_); }
+        iterator& operator++() { ++row_; settle(); return *this; }
+        iterator operator++(int) { iterator tmp = *this; ++*this; return tmp; }
+        bool operator==(const iterator& o) const { return block_ == o.block_ && row_ == o.row_; }
+        bool operator!=(const iterator& o) const { return !(*this == o); }
+
+    private:
+        void settle() {
+            const auto& blocks = range_->blocks_;
+            while (block_ < blocks.size()) {
+                const auto& b = blocks[block_];
+                for (; row_ < b.size(); ++row_) {
+                    if (range_->filter_.matches(b, row_)) return;
+                }
+                ++block_;
+                row_ = 0;
+            }
+            row_ = 0;
+        }
+
+        const TradeRange* range_ = nullptr;
+        size_t block_ = 0;
+        size_t row_ = 0;
+    };
+
+    TradeRange(std::vector<TradeBlockView> blocks, TradeFilter filter)
+        : blocks_(std::move(blocks)), filter_(filter) {}
+
+    iterator begin() const { return iterator(this, 0, 0); }
+    iterator end() const { return iterator(this, blocks_.size(), 0); }
+
+    /**
+     * @brief Candidate blocks left after zone-map pruning (for columnar consumers)
+     */
+    const std::vector<TradeBlockView>& blocks() const { return blocks_; }
+    const TradeFilter& filter() const { return filter_; }
+
+    /**
+     * @brief Copy the matching rows out as model::Trade objects
+     */
+    std::vector<model::Trade> toVector() const;
+
+private:
+    std::vector<TradeBlockView> blocks_;
+    TradeFilter filter_;
+};
+
+/**
+ * @brief Append-only, memory-mapped columnar store for trade history
+ *
+ * The file holds fixed-capacity blocks; each block stores every Trade field
+ * as its own column array plus a zone map (min/max timestamp, id, instrument
+ * and user). Scans prune whole blocks through the zone maps and hand out
+ * views into the mapping instead of copies. It complements the `trades`
+ * table for local historical analytics; it is not a replacement for it.
+ *
+ * A single writer per file is supported. Readers in other processes can call
+ * refresh() to pick up rows appended since they opened the file.
+ */
+class TradeStore {
+public:
+    enum class OpenMode { ReadOnly, ReadWrite };
+
+    static constexpr uint32_t kDefaultBlockCapacity = 4096;
+
+    /**
+     * @brief Open (or create, in ReadWrite mode) a trade store file
+     * @param path File path
+     * @param mode ReadOnly or ReadWrite
+     * @param blockCapacity Rows per block; only used when creating the file
+     */
+    explicit TradeStore(const std::string& path, OpenMode mode = OpenMode::ReadWrite,
+                        uint32_t blockCapacity = kDefaultBlockCapacity);
+    ~TradeStore();
+
+    TradeStore(const TradeStore&) = delete;
+    TradeStore& operator=(const TradeStore&) = delete;
+
+    /**
+     * @brief Append trades at the end of the store
+     */
+    void append(const model::Trade& trade);
+    void append(const std::vector<model::Trade>& trades);
+
+    /**
+     * @brief Flush dirty pages to disk (msync / FlushViewOfFile)
+     */
+    void flush();
+
+    /**
+     * @brief Re-read the header and remap if another process appended rows
+     */
+    void refresh();
+
+    /**
+     * @brief Number of rows stored
+     */
+    size_t size() const;
+
+    /**
+     * @brief Number of non-empty blocks
+     */
+    size_t blockCount() const;
+
+    /**
+     * @brief Zero-copy view of a block
+     */
+    TradeBlockView block(size_t index) const;
+
+    // Repository-like read interface
+
+    std::optional<model::Trade> getById(int id) const;
+    std::vector<model::Trade> getAll() const;
+
+    /**
+     * @brief All trades with timestamp in [from, to)
+     */
+    TradeRange scan(int64_t from, int64_t to) const;
+
+    /**
+     * @brief Trades of one instrument with timestamp in [from, to)
+     */
+    TradeRange findByInstrument(int instrumentId, int64_t from, int64_t to) const;
+
+    /**
+     * @brief Trades of one user with timestamp in [from, to)
+     */
+    TradeRange findByUser(int userId, int64_t from, int64_t to) const;
+
+    /**
+     * @brief Rows matching an arbitrary filter
+     */
+    TradeRange find(const TradeFilter& filter) const;
+
+    /**
+     * @brief Convert "YYYY-MM-DDTHH:MM:SS[.ffffff][Z]" (or a space separator) to epoch microseconds
+     */
+    static int64_t toEpochMicros(const std::string& timestamp);
+
+    /**
+     * @brief Format epoch microseconds as "YYYY-MM-DDTHH:MM:SSZ" (fraction only when non-zero)
+     */
+    static std::string fromEpochMicros(int64_t micros);
+
+private:
+    struct FileHeader;
+
+    FileHeader* header() const;
+    size_t blockBytes() const;
+    unsigned char* blockBase(size_t index) const;
+    void ensureCapacity(size_t blocks);
+    void map(size_t bytes);
+    void unmap();
+
+    std::string path_;
+    OpenMode mode_;
+    uint32_t blockCapacity_;
+    unsigned char* data_ = nullptr;
+    size_t mappedBytes_ = 0;
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+};
+
+} // namespace database
+} // namespace hftools
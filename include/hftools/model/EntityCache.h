@@ -0,0 +1,297 @@
+#pragma once
+
+#include "ORM_v1.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+//
+// =======================
+// Read-through entity cache for Repository<T>
+// =======================
+//
+
+struct EntityCacheOptions {
+    std::chrono::milliseconds ttl = std::chrono::minutes(5); // 0 = never expires
+    size_t maxEntries = 10000;                                // across all shards
+    size_t shards = 16;                                       // rounded up to a power of two
+};
+
+struct EntityCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t expirations = 0;
+    uint64_t invalidations = 0;
+};
+
+// Sharded primary-key -> entity map. Lookups take a shared lock on one shard
+// only; eviction is FIFO per shard, and a read takes the write lock only to
+// drop an entry it found expired.
+template<typename T>
+class EntityCache {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit EntityCache(EntityCacheOptions options = {}) : options_(options) {
+        size_t n = 1;
+        while (n < options_.shards) n <<= 1;
+        shardMask_ = n - 1;
+        perShardMax_ = std::max<size_t>(1, (options_.maxEntries + n - 1) / n);
+        shards_ = std::make_unique<Shard[]>(n);
+    }
+
+    std::optional<T> get(int id) {
+        Shard& shard = shardFor(id);
+        uint64_t expiredSeq = 0;
+        {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            auto it = shard.entries.find(id);
+            if (it != shard.entries.end()) {
+                if (!expired(it->second)) {
+                    shard.hits.fetch_add(1, std::memory_order_relaxed);
+                    return it->second.value;
+                }
+                expiredSeq = it->second.sequence;
+            }
+        }
+        if (expiredSeq != 0) {
+            // Reclaim the expired entry now rather than waiting for FIFO eviction,
+            // unless another thread replaced it in between
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            auto it = shard.entries.find(id);
+            if (it != shard.entries.end() && it->second.sequence == expiredSeq) {
+                shard.entries.erase(it);
+                shard.expirations.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        shard.misses.fetch_add(1, std::memory_order_relaxed);
+        return std::nullopt;
+    }
+
+    // Snapshot to take before reading an entity from the database and to pass
+    // to put(). Any invalidate() of that key in between makes put() a no-op,
+    // so a slow reader cannot reinstall a row an update has just replaced.
+    uint64_t generation() const {
+        return generation_.load(std::memory_order_seq_cst);
+    }
+
+    // Returns false, caching nothing, if the key was invalidated after `generation`
+    // was taken; the default caches unconditionally
+    bool put(int id, T value, uint64_t generation = std::numeric_limits<uint64_t>::max()) {
+        Shard& shard = shardFor(id);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+
+        if (generation < shard.floor)
+            return false;
+        auto inv = shard.invalidatedAt.find(id);
+        if (inv != shard.invalidatedAt.end() && inv->second > generation)
+            return false;
+
+        const uint64_t seq = ++shard.sequence;
+        const Clock::time_point expires = options_.ttl.count() > 0 ? Clock::now() + options_.ttl : Clock::time_point::max();
+        auto it = shard.entries.find(id);
+        if (it != shard.entries.end()) {
+            it->second = Entry{ std::move(value), expires, seq };
+        } else {
+            shard.entries.emplace(id, Entry{ std::move(value), expires, seq });
+        }
+        shard.order.emplace_back(id, seq);
+
+        while (shard.entries.size() > perShardMax_ && !shard.order.empty()) {
+            auto [victim, victimSeq] = shard.order.front();
+            shard.order.pop_front();
+            auto v = shard.entries.find(victim);
+            if (v != shard.entries.end() && v->second.sequence == victimSeq) {
+                shard.entries.erase(v);
+                shard.evictions.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        // Drop stale order records left behind by overwrites and invalidations
+        if (shard.order.size() > 2 * shard.entries.size() + 16) {
+            std::deque<std::pair<int, uint64_t>> live;
+            for (const auto& rec : shard.order) {
+                auto e = shard.entries.find(rec.first);
+                if (e != shard.entries.end() && e->second.sequence == rec.second) live.push_back(rec);
+            }
+            shard.order.swap(live);
+        }
+        return true;
+    }
+
+    void invalidate(int id) {
+        Shard& shard = shardFor(id);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        const uint64_t gen = generation_.fetch_add(1, std::memory_order_seq_cst) + 1;
+        shard.invalidatedAt[id] = gen;
+        // Bounded bookkeeping: past the limit, forget per-key generations and
+        // refuse every put() older than now instead
+        if (shard.invalidatedAt.size() > perShardMax_) {
+            shard.invalidatedAt.clear();
+            shard.floor = gen;
+        }
+        if (shard.entries.erase(id) > 0)
+            shard.invalidations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void clear() {
+        for (size_t i = 0; i <= shardMask_; ++i) {
+            std::unique_lock<std::shared_mutex> lock(shards_[i].mutex);
+            shards_[i].entries.clear();
+            shards_[i].order.clear();
+            shards_[i].invalidatedAt.clear();
+            shards_[i].floor = generation_.fetch_add(1, std::memory_order_seq_cst) + 1;
+        }
+    }
+
+    size_t size() const {
+        size_t n = 0;
+        for (size_t i = 0; i <= shardMask_; ++i) {
+            std::shared_lock<std::shared_mutex> lock(shards_[i].mutex);
+            n += shards_[i].entries.size();
+        }
+        return n;
+    }
+
+    EntityCacheStats stats() const {
+        EntityCacheStats s;
+        for (size_t i = 0; i <= shardMask_; ++i) {
+            const Shard& shard = shards_[i];
+            s.hits += shard.hits.load(std::memory_order_relaxed);
+            s.misses += shard.misses.load(std::memory_order_relaxed);
+            s.evictions += shard.evictions.load(std::memory_order_relaxed);
+            s.expirations += shard.expirations.load(std::memory_order_relaxed);
+            s.invalidations += shard.invalidations.load(std::memory_order_relaxed);
+        }
+        return s;
+    }
+
+    const EntityCacheOptions& options() const { return options_; }
+
+private:
+    struct Entry {
+        T value;
+        Clock::time_point expires;
+        uint64_t sequence;
+    };
+
+    // One cache line per shard header so counters of different shards don't false-share
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<int, Entry> entries;
+        std::deque<std::pair<int, uint64_t>> order;
+        uint64_t sequence = 0;
+        std::unordered_map<int, uint64_t> invalidatedAt;   // generation of the last invalidate() per key
+        uint64_t floor = 0;                                // put() older than this is refused for any key
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+        std::atomic<uint64_t> evictions{0};
+        std::atomic<uint64_t> expirations{0};
+        std::atomic<uint64_t> invalidations{0};
+    };
+
+    Shard& shardFor(int id) const {
+        // Fibonacci hashing spreads consecutive SERIAL ids across shards
+        uint64_t h = static_cast<uint64_t>(static_cast<uint32_t>(id)) * 0x9E3779B97F4A7C15ull;
+        return shards_[(h >> 32) & shardMask_];
+    }
+
+    static bool expired(const Entry& e) {
+        return e.expires != Clock::time_point::max() && Clock::now() >= e.expires;
+    }
+
+    EntityCacheOptions options_;
+    size_t shardMask_ = 0;
+    size_t perShardMax_ = 0;
+    std::unique_ptr<Shard[]> shards_;
+    std::atomic<uint64_t> generation_{ 0 };
+};
+
+// Repository<T> decorator: getById is served from the cache when possible,
+// and every write through this object invalidates the affected key.
+// Writes that bypass it (other processes, raw SQL) are only picked up once
+// the TTL expires, so keep it for reference data such as instruments and users.
+template<typename T>
+class CachedRepository {
+public:
+    explicit CachedRepository(IDatabase2& db, EntityCacheOptions options = {})
+        : repo_(db), cache_(options) {}
+
+    T getById(int id) {
+        if (auto hit = cache_.get(id))
+            return *std::move(hit);
+        const uint64_t generation = cache_.generation();
+        T obj = repo_.getById(id);
+        cache_.put(id, obj, generation);
+        return obj;
+    }
+
+    // Cached ids are served locally; the misses go out as one getByIds batch
+    std::map<int, T> getByIds(const std::vector<int>& ids) {
+        std::map<int, T> result;
+        std::vector<int> missing;
+        for (int id : ids) {
+            if (result.count(id))
+                continue;
+            if (auto hit = cache_.get(id))
+                result.emplace(id, *std::move(hit));
+            else
+                missing.push_back(id);
+        }
+        if (!missing.empty()) {
+            const uint64_t generation = cache_.generation();
+            for (auto& [id, obj] : repo_.getByIds(missing)) {
+                cache_.put(id, obj, generation);
+                result.emplace(id, std::move(obj));
+            }
+        }
+        return result;
+    }
+
+    std::vector<T> getAll() {
+        const uint64_t generation = cache_.generation();
+        auto all = repo_.getAll();
+        for (const auto& obj : all)
+            cache_.put(getPrimaryKey(obj), obj, generation);
+        return all;
+    }
+
+    void insert(const T& obj) {
+        repo_.insert(obj);
+        cache_.invalidate(getPrimaryKey(obj));
+    }
+
+    void update(const T& obj) {
+        repo_.update(obj);
+        cache_.invalidate(getPrimaryKey(obj));
+    }
+
+    void remove(const T& obj) {
+        repo_.remove(obj);
+        cache_.invalidate(getPrimaryKey(obj));
+    }
+
+    void invalidate(int id) { cache_.invalidate(id); }
+    void invalidateAll() { cache_.clear(); }
+
+    EntityCacheStats stats() const { return cache_.stats(); }
+    EntityCache<T>& cache() { return cache_; }
+    Repository<T>& repository() { return repo_; }
+
+private:
+    Repository<T> repo_;
+    EntityCache<T> cache_;
+};
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "ORM_v1.h"
+
+#include <climits>
+#include <cstddef>
+#include <future>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//
+// =======================
+// Keyset-paginated streaming over Repository<T>
+// =======================
+//
+// for (const auto& trade : repo.stream(5000)) { ... }
+//
+// Walks the table in primary-key order, one page at a time
+// (WHERE id > last ORDER BY id LIMIT n), so memory stays at two pages no
+// matter how large the table is. While the caller consumes the current
+// page the next one is already being fetched on a background thread.
+//
+// The prefetch calls the IDatabase2 from that background thread, so the
+// backend must tolerate one concurrent call alongside whatever the caller
+// does with it (or the caller must leave it alone while iterating).
+//
+
+template <typename T>
+class EntityStream {
+public:
+    EntityStream(IDatabase2& db, size_t pageSize, int startAfter = INT_MIN)
+        : db_(db), pageSize_(pageSize), lastKey_(startAfter) {
+        if (pageSize_ == 0)
+            throw std::invalid_argument("EntityStream page size must be positive");
+        sql_ = buildKeysetPageSQL<T>(db_.dialect(), pageSize_);
+    }
+
+    // The prefetch task captures `this`, so the stream never moves
+    EntityStream(const EntityStream&) = delete;
+    EntityStream& operator=(const EntityStream&) = delete;
+
+    ~EntityStream() {
+        // Don't leave a fetch running against db_ after we are gone
+        if (next_.valid())
+            next_.wait();
+    }
+
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        iterator() = default;
+        explicit iterator(EntityStream* s) : stream_(s) {
+            if (stream_ && stream_->atEnd()) stream_ = nullptr;
+        }
+
+        reference operator*() const { return stream_->current_[stream_->pos_]; }
+        pointer operator->() const { return &stream_->current_[stream_->pos_]; }
+
+        iterator& operator++() {
+            stream_->advance();
+            if (stream_->atEnd()) stream_ = nullptr;
+            return *this;
+        }
+
+        bool operator==(const iterator& o) const { return stream_ == o.stream_; }
+        bool operator!=(const iterator& o) const { return stream_ != o.stream_; }
+
+    private:
+        EntityStream* stream_ = nullptr;
+    };
+
+    // Single pass: begin() may only be called once
+    iterator begin() {
+        if (started_)
+            throw std::logic_error("EntityStream is single-pass");
+        started_ = true;
+        current_ = fetchPage(lastKey_);
+        pos_ = 0;
+        ++pagesFetched_;
+        prefetchIfMore();
+        return iterator(this);
+    }
+
+    iterator end() { return iterator(); }
+
+    size_t pageSize() const { return pageSize_; }
+    size_t pagesFetched() const { return pagesFetched_; }
+
+private:
+    std::vector<T> fetchPage(int after) {
+        auto rows = db_.queryManyPrepared(sql_, { nlohmann::json(after) });
+        std::vector<T> page;
+        page.reserve(rows.size());
+        for (auto& r : rows)
+            page.push_back(autoFromJson<T>(r));
+        return page;
+    }
+
+    void prefetchIfMore() {
+        // A short page means we just read the tail of the table
+        if (current_.size() < pageSize_)
+            return;
+        lastKey_ = getPrimaryKey(current_.back());
+        next_ = std::async(std::launch::async, [this, after = lastKey_] { return fetchPage(after); });
+        ++pagesFetched_;
+    }
+
+    void advance() {
+        if (++pos_ < current_.size())
+            return;
+        current_.clear();
+        pos_ = 0;
+        if (next_.valid()) {
+            current_ = next_.get();
+            prefetchIfMore();
+        }
+    }
+
+    bool atEnd() const { return pos_ >= current_.size(); }
+
+    IDatabase2& db_;
+    size_t pageSize_;
+    int lastKey_;
+    std::string sql_;
+    std::vector<T> current_;
+    size_t pos_ = 0;
+    std::future<std::vector<T>> next_;
+    size_t pagesFetched_ = 0;
+    bool started_ = false;
+};
+
+template <typename T>
+EntityStream<T> Repository<T>::stream(size_t pageSize) {
+    return EntityStream<T>(db_, pageSize);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string_view>
+
+namespace hftools {
+namespace model {
+
+/**
+ * @brief One mapped column: database name and the member it is stored in
+ */
+template <typename T, typename FieldType>
+struct Column {
+    std::string_view name;
+    FieldType T::* member;
+};
+
+/**
+ * @brief Mapping metadata for an entity; specialize per entity with
+ * tableName, primaryKey and a columns tuple of Column<T, F>
+ */
+template <typename T>
+struct EntityTraits;
+
+} // namespace model
+} // namespace hftools
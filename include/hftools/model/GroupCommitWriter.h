@@ -0,0 +1,236 @@
+#pragma once
+
+#include "ORM_v1.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+//
+// =======================
+// Group commit over Repository<T>
+// =======================
+//
+// GroupCommitWriter<FXInstrument2> writer(db, { 256, std::chrono::microseconds(500) });
+// auto done = writer.insert(instrument);   // from any thread
+// done.get();                               // returns once the row is committed, rethrows its error
+//
+// insert() / update() / upsert() queue the entity and return at once. A
+// background thread collects what many callers submit, for up to maxDelay
+// after the oldest pending write or until maxRows are waiting, and writes the
+// whole batch in one transaction: consecutive inserts become one multi-row
+// INSERT, consecutive upserts one multi-row upsert (last write wins for a
+// repeated key), updates one statement each. Every caller's future is
+// completed when that commit lands. Writes are applied in submission order.
+//
+// If the batch fails it is rolled back and its writes are retried one by
+// one, so only the offending caller sees the error.
+//
+// Only the writer thread touches db, so give the writer its own IDatabase2
+// (connection) rather than one shared with other threads.
+//
+
+struct GroupCommitOptions {
+    size_t maxRows = 256;                                    // writes per transaction
+    std::chrono::microseconds maxDelay{ 1000 };              // longest a write waits for company
+};
+
+struct GroupCommitStats {
+    uint64_t writes = 0;          // completed, successfully or not
+    uint64_t batches = 0;         // transactions attempted
+    uint64_t failedBatches = 0;   // rolled back and retried row by row
+};
+
+template<typename T>
+class GroupCommitWriter {
+public:
+    explicit GroupCommitWriter(IDatabase2& db, GroupCommitOptions options = {})
+        : db_(db), options_(options) {
+        if (options_.maxRows == 0)
+            throw std::invalid_argument("GroupCommitWriter: maxRows must be at least 1");
+        worker_ = std::thread([this] { run(); });
+    }
+
+    // Commits everything already submitted, then stops the writer thread
+    ~GroupCommitWriter() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_one();
+        worker_.join();
+    }
+
+    GroupCommitWriter(const GroupCommitWriter&) = delete;
+    GroupCommitWriter& operator=(const GroupCommitWriter&) = delete;
+
+    std::future<void> insert(T obj) { return submit(Kind::Insert, std::move(obj)); }
+    std::future<void> update(T obj) { return submit(Kind::Update, std::move(obj)); }
+    std::future<void> upsert(T obj) { return submit(Kind::Upsert, std::move(obj)); }
+
+    // Write what is pending now, without waiting for maxDelay, and block until
+    // every write submitted before the call has completed
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        const uint64_t target = submitted_;
+        flushTarget_ = std::max(flushTarget_, target);
+        wake_.notify_one();
+        done_.wait(lock, [&] { return completed_ >= target; });
+    }
+
+    GroupCommitStats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+private:
+    enum class Kind { Insert, Update, Upsert };
+
+    struct Write {
+        Kind kind;
+        T obj;
+        std::promise<void> done;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    std::future<void> submit(Kind kind, T obj) {
+        Write write{ kind, std::move(obj), {} };
+        std::future<void> result = write.done.get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_)
+                throw std::logic_error("GroupCommitWriter: writer is shutting down");
+            if (pending_.empty())
+                oldest_ = Clock::now();
+            pending_.push_back(std::move(write));
+            ++submitted_;
+            // The writer only needs waking to start the delay or to cut a full batch
+            if (pending_.size() != 1 && pending_.size() != options_.maxRows)
+                return result;
+        }
+        wake_.notify_one();
+        return result;
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            wake_.wait(lock, [&] { return stopping_ || !pending_.empty(); });
+            if (pending_.empty())
+                return;   // stopping, nothing left
+
+            wake_.wait_until(lock, oldest_ + options_.maxDelay, [&] {
+                return stopping_ || pending_.size() >= options_.maxRows || flushTarget_ > completed_;
+            });
+
+            const size_t count = std::min(pending_.size(), options_.maxRows);
+            std::vector<Write> batch(std::make_move_iterator(pending_.begin()),
+                                     std::make_move_iterator(pending_.begin() + count));
+            // Anything left over has waited at least as long: oldest_ stays, so it goes next
+            pending_.erase(pending_.begin(), pending_.begin() + count);
+
+            lock.unlock();
+            const bool failed = commit(batch);
+            lock.lock();
+
+            stats_.writes += count;
+            ++stats_.batches;
+            if (failed) ++stats_.failedBatches;
+            completed_ += count;
+            done_.notify_all();
+        }
+    }
+
+    // Returns true if the batch had to be retried row by row
+    bool commit(std::vector<Write>& batch) {
+        if (batch.size() == 1) {
+            complete(batch[0], [&] { writeRun(batch.begin(), batch.end()); });
+            return false;
+        }
+
+        try {
+            db_.beginTransaction();
+            try {
+                for (auto run = batch.begin(); run != batch.end();) {
+                    auto end = std::find_if(run, batch.end(), [&](const Write& w) { return w.kind != run->kind; });
+                    writeRun(run, end);
+                    run = end;
+                }
+                db_.commitTransaction();
+            } catch (...) {
+                try { db_.rollbackTransaction(); } catch (...) {}
+                throw;
+            }
+        } catch (...) {
+            for (auto it = batch.begin(); it != batch.end(); ++it)
+                complete(*it, [&] { writeRun(it, std::next(it)); });
+            return true;
+        }
+
+        for (auto& write : batch)
+            write.done.set_value();
+        return false;
+    }
+
+    template <typename Fn>
+    static void complete(Write& write, Fn&& fn) {
+        try {
+            fn();
+            write.done.set_value();
+        } catch (...) {
+            write.done.set_exception(std::current_exception());
+        }
+    }
+
+    // Writes of one kind, as few statements as the parameter limit allows
+    using Iterator = typename std::vector<Write>::iterator;
+
+    void writeRun(Iterator begin, Iterator end) {
+        const SqlDialect dialect = db_.dialect();
+        const Kind kind = begin->kind;
+
+        if (kind == Kind::Update) {
+            const std::string sql = buildUpdateSQL<T>(dialect);
+            for (auto it = begin; it != end; ++it)
+                db_.executePrepared(sql, buildUpdateParams(it->obj));
+            return;
+        }
+
+        std::vector<const T*> rows;
+        rows.reserve(static_cast<size_t>(end - begin));
+        for (auto it = begin; it != end; ++it)
+            rows.push_back(&it->obj);
+        if (kind == Kind::Upsert) {
+            // One statement may not touch a row twice: the last write of a key wins
+            Repository<T>::keepLastPerKey(rows);
+            repo_.executeMultiRow(rows, &buildUpsertSQL<T>);
+        } else {
+            repo_.executeMultiRow(rows, &buildInsertManySQL<T>);
+        }
+    }
+
+    IDatabase2& db_;
+    Repository<T> repo_{ db_ };
+    const GroupCommitOptions options_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;      // writer thread
+    std::condition_variable done_;      // flush()
+    std::vector<Write> pending_;
+    Clock::time_point oldest_;
+    uint64_t submitted_ = 0;
+    uint64_t completed_ = 0;
+    uint64_t flushTarget_ = 0;
+    bool stopping_ = false;
+    GroupCommitStats stats_;
+    std::thread worker_;
+};
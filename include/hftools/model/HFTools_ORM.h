@@ -17,8 +17,27 @@
 #include <map>
 #include <set>
 #include <stdexcept>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <shared_mutex>
+#include <typeinfo>
+#include <unordered_map>
+#include <cstring>
+#include <memory_resource>
+#include <functional>
 #include <nlohmann/json.hpp>
+
+// PostgresDatabase needs libpqxx; the rest of the ORM (readers, hydration,
+// pooling, Repository) also builds without it, e.g. over an in-memory backend
+#if !defined(HFTOOLS_HAS_PQXX) && __has_include(<pqxx/pqxx>)
+#define HFTOOLS_HAS_PQXX 1
+#endif
+#ifdef HFTOOLS_HAS_PQXX
 #include <pqxx/pqxx>
+#endif
+#include "EntityTraits.h"
+#include "hftools/utils/Instrumentation.h"
 
 namespace hftools {
 
@@ -50,12 +69,6 @@ namespace utils {
 // =============================================================================
 namespace model {
 
-    template <typename T, typename FieldType>
-    struct Column {
-        std::string_view name;
-        FieldType T::* member;
-    };
-
     class BaseEntity {
     public:
         virtual ~BaseEntity() = default;
@@ -74,8 +87,6 @@ namespace model {
         for_each_impl(std::forward<Tuple>(t), std::forward<Func>(f), std::make_index_sequence<std::tuple_size_v<T>>{});
     }
 
-    template<typename T> struct EntityTraits; // Specialization required per entity
-
     template<typename T>
     inline nlohmann::json autoToJson(const T& obj) {
         nlohmann::json j;
@@ -113,43 +124,189 @@ namespace model {
 // =============================================================================
 namespace db {
 
+    // Non-owning view of one field; the text lives in the DBReader's arena
     class DBValue {
-        std::string data_;
+        std::string_view data_;
         bool isNull_;
     public:
-        explicit DBValue(std::string val, bool isNull = false) : data_(std::move(val)), isNull_(isNull) {}
-        
+        explicit DBValue(std::string_view val, bool isNull = false) : data_(val), isNull_(isNull) {}
+
+        bool isNull() const { return isNull_; }
+        std::string_view view() const { return data_; }
+
         template <typename T>
         T as() const {
             if (isNull_) return T{};
-            if constexpr (std::is_same_v<T, int>) return std::stoi(data_);
-            else if constexpr (std::is_same_v<T, double>) return std::stod(data_);
-            else if constexpr (std::is_same_v<T, std::string>) return data_;
-            else if constexpr (std::is_same_v<T, utils::Timestamp>) return utils::stringToTimePoint(data_);
+            if constexpr (std::is_arithmetic_v<T> && !std::is_same_v<T, bool>) {
+                T out{};
+                auto res = std::from_chars(data_.data(), data_.data() + data_.size(), out);
+                if (res.ec != std::errc() || res.ptr == data_.data())
+                    throw std::runtime_error("Invalid numeric value: " + std::string(data_));
+                return out;
+            }
+            else if constexpr (std::is_same_v<T, std::string>) return std::string(data_);
+            else if constexpr (std::is_same_v<T, std::string_view>) return data_;
+            else if constexpr (std::is_same_v<T, utils::Timestamp>) return utils::stringToTimePoint(std::string(data_));
             else return T{};
         }
     };
 
+    class DBReader;
+
+    // Result ordinal of every EntityTraits<T> column, in traits order
+    template <typename T>
+    struct ColumnBinding {
+        static constexpr size_t size = std::tuple_size_v<std::decay_t<decltype(hftools::model::EntityTraits<T>::columns)>>;
+        std::vector<std::string> resultColumns;   // what the binding was computed for
+        std::array<size_t, size> ordinals;
+    };
+
+    // Per-(statement, T) column bindings. A hit costs one hash lookup and a
+    // compare of the result's column names against the ones the binding was
+    // built for, so a schema change under a cached statement is still caught.
+    template <typename T>
+    class ColumnBindingCache {
+    public:
+        static std::shared_ptr<const ColumnBinding<T>> resolve(const std::string& sql, const std::vector<std::string>& columns) {
+            auto& c = instance();
+            if (!sql.empty()) {
+                std::shared_lock<std::shared_mutex> lock(c.mutex_);
+                auto it = c.bindings_.find(sql);
+                if (it != c.bindings_.end() && it->second->resultColumns == columns)
+                    return it->second;
+            }
+
+            auto binding = build(columns);
+            if (!sql.empty()) {
+                std::unique_lock<std::shared_mutex> lock(c.mutex_);
+                // Ad-hoc SQL must not grow the cache without bound
+                if (c.bindings_.size() >= kMaxStatements) c.bindings_.clear();
+                c.bindings_[sql] = binding;
+            }
+            return binding;
+        }
+
+        static constexpr size_t kMaxStatements = 1024;
+
+    private:
+        static ColumnBindingCache& instance() {
+            static ColumnBindingCache cache;
+            return cache;
+        }
+
+        static bool sameName(std::string_view a, std::string_view b) {
+            if (a.size() != b.size()) return false;
+            for (size_t i = 0; i < a.size(); ++i) {
+                if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i])))
+                    return false;
+            }
+            return true;
+        }
+
+        static std::shared_ptr<const ColumnBinding<T>> build(const std::vector<std::string>& columns) {
+            auto binding = std::make_shared<ColumnBinding<T>>();
+            binding->resultColumns = columns;
+            size_t i = 0;
+            hftools::model::for_each(hftools::model::EntityTraits<T>::columns, [&](auto&& col) {
+                size_t ordinal = columns.size();
+                for (size_t c = 0; c < columns.size(); ++c) {
+                    if (sameName(columns[c], col.name)) { ordinal = c; break; }
+                }
+                if (ordinal == columns.size())
+                    throw std::runtime_error("Result has no column '" + std::string(col.name) + "' for " +
+                                             std::string(hftools::model::EntityTraits<T>::tableName));
+                binding->ordinals[i++] = ordinal;
+            });
+            return binding;
+        }
+
+        std::shared_mutex mutex_;
+        std::unordered_map<std::string, std::shared_ptr<const ColumnBinding<T>>> bindings_;
+    };
+
+    // Non-owning view of one row of a DBReader
     class DBRow {
-        std::vector<DBValue> columns_;
+        const DBReader* reader_;
+        size_t row_;
     public:
-        explicit DBRow(std::vector<DBValue> cols) : columns_(std::move(cols)) {}
-        const DBValue& operator[](size_t i) const { return columns_.at(i); }
-        size_t size() const { return columns_.size(); }
+        DBRow(const DBReader& reader, size_t row) : reader_(&reader), row_(row) {}
+        DBValue operator[](size_t i) const;
+        size_t size() const;
     };
 
+    // Driver result held by a lazy DBReader: cells are decoded only when read
+    class DBResultSource {
+    public:
+        virtual ~DBResultSource() = default;
+        virtual size_t rowCount() const = 0;
+        virtual DBValue value(size_t row, size_t col) const = 0;
+    };
+
+    // Either owns a whole result or wraps the driver's result lazily.
+    //
+    // Materialized: field text is copied into one monotonic arena and the
+    // values form a single row-major array of views into it, so a result
+    // costs a few block allocations however many rows and columns it has.
+    // Everything is released together when the reader goes away.
+    //
+    // Lazy: the driver result (pqxx::result / PGresult) is kept alive and a
+    // cell is only turned into a DBValue when it is read, so a caller that
+    // stops after the first row never touches the rest.
     class DBReader {
         std::vector<std::string> columnNames_;
-        std::vector<DBRow> rows_;
+        std::unique_ptr<DBResultSource> source_;   // set in lazy mode
+        std::unique_ptr<std::pmr::monotonic_buffer_resource> arena_;
+        std::pmr::vector<DBValue> values_;   // from the upstream resource, so moves never dangle
         int currentRow_ = -1;
         size_t currentCol_ = 0;
 
     public:
-        DBReader(std::vector<std::string> names, std::vector<DBRow> rows) 
-            : columnNames_(std::move(names)), rows_(std::move(rows)) {}
+        // initialBytes: size of the first arena block (the total text size, if known)
+        explicit DBReader(std::vector<std::string> names, size_t initialBytes = 0,
+                          std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+            : columnNames_(std::move(names)),
+              arena_(std::make_unique<std::pmr::monotonic_buffer_resource>(initialBytes > 0 ? initialBytes : 4096, upstream)),
+              values_(upstream) {}
+
+        // Lazy mode over a driver result
+        DBReader(std::vector<std::string> names, std::unique_ptr<DBResultSource> source)
+            : columnNames_(std::move(names)), source_(std::move(source)) {}
+
+        bool isLazy() const { return source_ != nullptr; }
+
+        void reserve(size_t rows) { values_.reserve(rows * columnNames_.size()); }
+
+        // Append the next field, filling rows left to right (materialized mode only)
+        void addValue(std::string_view text, bool isNull = false) {
+            if (source_) throw std::logic_error("Cannot add values to a lazy DBReader");
+            const char* data = "";
+            if (!text.empty()) {
+                char* p = static_cast<char*>(arena_->allocate(text.size(), 1));
+                std::memcpy(p, text.data(), text.size());
+                data = p;
+            }
+            values_.emplace_back(std::string_view(data, text.size()), isNull);
+        }
+
+        size_t rowCount() const {
+            if (source_) return source_->rowCount();
+            return columnNames_.empty() ? 0 : values_.size() / columnNames_.size();
+        }
+        const std::vector<std::string>& columnNames() const { return columnNames_; }
+
+        DBValue value(size_t row, size_t col) const {
+            if (row >= rowCount()) throw std::out_of_range("DBReader row index out of range");
+            if (col >= columnNames_.size()) throw std::out_of_range("DBRow column index out of range");
+            return source_ ? source_->value(row, col) : values_[row * columnNames_.size() + col];
+        }
+
+        DBRow row(size_t i) const {
+            if (i >= rowCount()) throw std::out_of_range("DBReader row index out of range");
+            return DBRow(*this, i);
+        }
 
         bool next() {
-            if (currentRow_ + 1 < (int)rows_.size()) {
+            if (currentRow_ + 1 < (int)rowCount()) {
                 currentRow_++;
                 currentCol_ = 0;
                 return true;
@@ -157,64 +314,101 @@ namespace db {
             return false;
         }
 
+        // Reads the next field into a scalar, or the current row into an entity.
+        // Entities are hydrated by column name (case-insensitive), so extra
+        // result columns and a different column order are harmless.
         template <typename T>
-        void validate() const {
-            using Traits = hftools::model::EntityTraits<T>;
-            if (columnNames_.size() != std::tuple_size_v<decltype(Traits::columns)>)
-                throw std::runtime_error("Column count mismatch in DBReader");
-        }
-
-        template <typename T>
-        DBReader& operator>>(T& val) {
-            val = rows_[currentRow_][currentCol_++].as<T>();
+        DBReader& operator>>(T& out) {
+            if constexpr (std::is_arithmetic_v<T> || std::is_same_v<T, std::string> ||
+                          std::is_same_v<T, std::string_view> || std::is_same_v<T, utils::Timestamp>) {
+                out = value(currentRow_, currentCol_++).as<T>();
+            } else {
+                if (bindingType_ != &typeid(T)) {
+                    binding_ = ColumnBindingCache<T>::resolve(statement_, columnNames_);
+                    bindingType_ = &typeid(T);
+                }
+                hydrate(out, *static_cast<const ColumnBinding<T>*>(binding_.get()),
+                        std::make_index_sequence<ColumnBinding<T>::size>{});
+                currentCol_ = columnNames_.size();
+            }
             return *this;
         }
 
-        template <typename T>
-        friend DBReader& operator>>(DBReader& reader, T& obj) {
-            if (reader.currentRow_ == 0 && reader.currentCol_ == 0) reader.validate<T>();
-            hftools::model::for_each(hftools::model::EntityTraits<T>::columns, [&](auto&& col) {
-                reader >> (obj.*(col.member));
-            });
-            return reader;
+        // SQL text the result came from; keys the column binding cache
+        void setStatement(std::string sql) { statement_ = std::move(sql); }
+        const std::string& statement() const { return statement_; }
+
+    private:
+        template <typename T, size_t... I>
+        void hydrate(T& obj, const ColumnBinding<T>& b, std::index_sequence<I...>) {
+            const auto& cols = hftools::model::EntityTraits<T>::columns;
+            ((obj.*(std::get<I>(cols).member) =
+                  value(currentRow_, b.ordinals[I]).template as<std::decay_t<decltype(obj.*(std::get<I>(cols).member))>>()),
+             ...);
         }
+
+        std::string statement_;
+        std::shared_ptr<const void> binding_;
+        const std::type_info* bindingType_ = nullptr;
     };
 
+    inline DBValue DBRow::operator[](size_t i) const { return reader_->value(row_, i); }
+    inline size_t DBRow::size() const { return reader_->columnNames().size(); }
+
     // =============================================================================
     // 4. DB: Connection Pooling
     // =============================================================================
-    class PostgresConnectionPool {
-        std::queue<std::unique_ptr<pqxx::connection>> pool_;
+    // Fixed set of connections created up front; borrow() blocks until one is free
+    template <typename Conn>
+    class ConnectionPool {
+        std::queue<std::unique_ptr<Conn>> pool_;
         std::mutex mutex_;
         std::condition_variable cv_;
-        std::string connStr_;
 
     public:
-        PostgresConnectionPool(const std::string& str, size_t size) : connStr_(str) {
-            for (size_t i = 0; i < size; ++i) pool_.push(std::make_unique<pqxx::connection>(str));
+        ConnectionPool(size_t size, const std::function<std::unique_ptr<Conn>()>& factory) {
+            for (size_t i = 0; i < size; ++i) pool_.push(factory());
         }
 
-        auto borrow() {
+        // The wait is reported to instrumentation (if any) as onPoolWait(poolName)
+        std::unique_ptr<Conn> borrow(utils::QueryInstrumentation* instrumentation = nullptr, std::string_view poolName = {}) {
+            const auto start = instrumentation ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
             std::unique_lock<std::mutex> lock(mutex_);
             cv_.wait(lock, [this] { return !pool_.empty(); });
             auto conn = std::move(pool_.front());
             pool_.pop();
+            lock.unlock();
+            if (instrumentation) {
+                try {
+                    instrumentation->onPoolWait(poolName, std::chrono::steady_clock::now() - start);
+                } catch (...) {
+                }
+            }
             return conn;
         }
 
-        void release(std::unique_ptr<pqxx::connection> conn) {
+        void release(std::unique_ptr<Conn> conn) {
             std::lock_guard<std::mutex> lock(mutex_);
             pool_.push(std::move(conn));
             cv_.notify_one();
         }
     };
 
+    template <typename Conn>
     struct PooledConnGuard {
-        std::unique_ptr<pqxx::connection> conn;
-        PostgresConnectionPool& pool;
+        std::unique_ptr<Conn> conn;
+        ConnectionPool<Conn>& pool;
         ~PooledConnGuard() { pool.release(std::move(conn)); }
     };
 
+#ifdef HFTOOLS_HAS_PQXX
+    class PostgresConnectionPool : public ConnectionPool<pqxx::connection> {
+    public:
+        PostgresConnectionPool(const std::string& str, size_t size)
+            : ConnectionPool<pqxx::connection>(size, [&str] { return std::make_unique<pqxx::connection>(str); }) {}
+    };
+#endif
+
     // =============================================================================
     // 5. DB: Database Interfaces & Implementations
     // =============================================================================
@@ -223,38 +417,91 @@ namespace db {
         virtual ~IDatabase() = default;
         virtual DBReader executeQuery(const std::string& sql, const std::vector<std::string>& params) = 0;
         virtual void execute(const std::string& sql, const std::vector<std::string>& params) = 0;
+
+        // Statements and pool waits are reported here (null to stop); starts as
+        // utils::defaultInstrumentation(). Set it before sharing the database.
+        void setInstrumentation(std::shared_ptr<utils::QueryInstrumentation> instrumentation) {
+            instrumentation_ = std::move(instrumentation);
+        }
+        std::shared_ptr<utils::QueryInstrumentation> instrumentation() const { return instrumentation_; }
+
+    protected:
+        std::shared_ptr<utils::QueryInstrumentation> instrumentation_ = utils::defaultInstrumentation();
+    };
+
+#ifdef HFTOOLS_HAS_PQXX
+    // pqxx::result shares ownership of the PGresult, so it stays valid after
+    // the transaction commits and the connection goes back to the pool
+    class PqxxResultSource : public DBResultSource {
+        pqxx::result res_;
+    public:
+        explicit PqxxResultSource(pqxx::result res) : res_(std::move(res)) {}
+        size_t rowCount() const override { return res_.size(); }
+        DBValue value(size_t row, size_t col) const override {
+            const auto f = res_[row][col];
+            return DBValue(std::string_view(f.c_str(), f.size()), f.is_null());
+        }
     };
 
     class PostgresDatabase : public IDatabase {
+    public:
+        enum class ReadMode {
+            Lazy,        // DBReader wraps the pqxx::result, cells decoded on access
+            Materialize  // every field copied into the DBReader's arena up front
+        };
+
+    private:
         PostgresConnectionPool pool_;
+        ReadMode mode_;
+
     public:
-        PostgresDatabase(const std::string& str, size_t size) : pool_(str, size) {}
+        PostgresDatabase(const std::string& str, size_t size, ReadMode mode = ReadMode::Lazy)
+            : pool_(str, size), mode_(mode) {}
 
         DBReader executeQuery(const std::string& sql, const std::vector<std::string>& params) override {
-            PooledConnGuard guard{ pool_.borrow(), pool_ };
+            PooledConnGuard<pqxx::connection> guard{ pool_.borrow(instrumentation_.get(), "PostgreSQL"), pool_ };
+            utils::StatementTrace trace(instrumentation_.get(), "PostgreSQL", sql, &params);
             pqxx::work txn(*guard.conn);
             auto res = txn.exec_params(sql, pqxx::prepare::make_dynamic_params(params));
-            
+            txn.commit();
+
             std::vector<std::string> names;
             for (int i = 0; i < res.columns(); ++i) names.push_back(res.column_name(i));
 
-            std::vector<DBRow> rows;
-            for (const auto& r : res) {
-                std::vector<DBValue> vals;
-                for (const auto& f : r) vals.emplace_back(f.c_str(), f.is_null());
-                rows.emplace_back(std::move(vals));
+            // Lazy mode only walks the fields when someone wants the byte count
+            size_t textBytes = 0;
+            if (mode_ == ReadMode::Materialize || trace.active()) {
+                for (const auto& r : res)
+                    for (const auto& f : r) textBytes += f.size();
             }
-            txn.commit();
-            return DBReader(std::move(names), std::move(rows));
+            trace.finish(static_cast<int64_t>(res.size()), static_cast<int64_t>(textBytes));
+
+            if (mode_ == ReadMode::Lazy) {
+                DBReader reader(std::move(names), std::make_unique<PqxxResultSource>(std::move(res)));
+                reader.setStatement(sql);
+                return reader;
+            }
+
+            // Size the arena to the whole result so it is a single block
+
+            DBReader reader(std::move(names), textBytes);
+            reader.reserve(res.size());
+            for (const auto& r : res)
+                for (const auto& f : r) reader.addValue(std::string_view(f.c_str(), f.size()), f.is_null());
+            reader.setStatement(sql);
+            return reader;
         }
 
         void execute(const std::string& sql, const std::vector<std::string>& params) override {
-            PooledConnGuard guard{ pool_.borrow(), pool_ };
+            PooledConnGuard<pqxx::connection> guard{ pool_.borrow(instrumentation_.get(), "PostgreSQL"), pool_ };
+            utils::StatementTrace trace(instrumentation_.get(), "PostgreSQL", sql, &params);
             pqxx::work txn(*guard.conn);
-            txn.exec_params(sql, pqxx::prepare::make_dynamic_params(params));
+            auto res = txn.exec_params(sql, pqxx::prepare::make_dynamic_params(params));
             txn.commit();
+            trace.finish(res.affected_rows());
         }
     };
+#endif // HFTOOLS_HAS_PQXX
 }
 
 // =============================================================================
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "ORM_v1.h"
+#include "hftools/database/InMemoryDatabase.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+//
+// =======================
+// IDatabase2 over the in-memory SQL store
+// =======================
+//
+// auto store = std::make_shared<hftools::database::InMemoryStore>();
+// store->createTable<FXInstrument2>();
+// store->setLatency({ std::chrono::microseconds(200) });   // simulated round trip
+//
+// InMemoryDatabase2 db(store);
+// Repository<FXInstrument2> repo(db);
+// repo.upsertMany(instruments);
+// auto page = repo.find(Query<FXInstrument2>().where(&FXInstrument2::_price, CompareOp::Gt, 1.0));
+//
+// Runs the SQL the builders generate against real rows, so Repository,
+// Query, EntityStream, UnitOfWork and EntityCache can be measured without
+// a server. Speaks the PostgreSQL dialect; transactions go through the
+// IDatabase2 defaults (BEGIN / COMMIT / ROLLBACK statements).
+//
+
+class InMemoryDatabase2 : public IDatabase2 {
+public:
+    explicit InMemoryDatabase2(std::shared_ptr<hftools::database::InMemoryStore> store)
+        : session_(std::move(store)) {}
+
+    // First row as a json object, or an empty object when there is no row
+    nlohmann::json queryOnePrepared(
+        const std::string& sql,
+        const std::vector<nlohmann::json>& params) override {
+        auto result = session_.execute(sql, params);
+        if (result.rows.empty())
+            return nlohmann::json::object();
+        return toObject(result, 0);
+    }
+
+    std::vector<nlohmann::json> queryManyPrepared(
+        const std::string& sql,
+        const std::vector<nlohmann::json>& params) override {
+        auto result = session_.execute(sql, params);
+        std::vector<nlohmann::json> rows;
+        rows.reserve(result.rows.size());
+        for (size_t i = 0; i < result.rows.size(); ++i)
+            rows.push_back(toObject(result, i));
+        return rows;
+    }
+
+    int executePrepared(
+        const std::string& sql,
+        const std::vector<nlohmann::json>& params) override {
+        return session_.execute(sql, params).affected;
+    }
+
+    hftools::database::InMemoryStore& store() { return session_.store(); }
+
+private:
+    static nlohmann::json toObject(const hftools::database::InMemoryResult& result, size_t row) {
+        nlohmann::json obj = nlohmann::json::object();
+        for (size_t c = 0; c < result.columns.size(); ++c)
+            obj[result.columns[c]] = result.rows[row][c];
+        return obj;
+    }
+
+    hftools::database::InMemorySession session_;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "HFTools_ORM.h"
+#include "hftools/database/InMemoryDatabase.h"
+
+namespace hftools {
+namespace db {
+
+    // db::IDatabase over the in-memory SQL store, pooled like PostgresDatabase:
+    // each call borrows one of poolSize sessions, so pool contention and the
+    // DBReader materialization cost show up in benchmarks as they would
+    // against a server. Parameters arrive as text and are converted to the
+    // column types by the store.
+    class InMemoryDatabase : public IDatabase {
+        ConnectionPool<database::InMemorySession> pool_;
+
+    public:
+        explicit InMemoryDatabase(std::shared_ptr<database::InMemoryStore> store, size_t poolSize = 1)
+            : pool_(poolSize, [&store] { return std::make_unique<database::InMemorySession>(store); }) {}
+
+        DBReader executeQuery(const std::string& sql, const std::vector<std::string>& params) override {
+            utils::StatementTrace trace(instrumentation_.get(), "InMemory", sql, &params);
+            database::InMemoryResult res = run(sql, params);
+
+            std::vector<std::string> texts;
+            texts.reserve(res.rows.size() * res.columns.size());
+            size_t textBytes = 0;
+            for (const auto& r : res.rows) {
+                for (const auto& v : r) {
+                    texts.push_back(database::inMemoryText(v));
+                    textBytes += texts.back().size();
+                }
+            }
+            trace.finish(static_cast<int64_t>(res.rows.size()), static_cast<int64_t>(textBytes));
+
+            DBReader reader(std::move(res.columns), textBytes);
+            reader.reserve(res.rows.size());
+            size_t i = 0;
+            for (const auto& r : res.rows)
+                for (const auto& v : r) reader.addValue(texts[i++], v.is_null());
+            reader.setStatement(sql);
+            return reader;
+        }
+
+        void execute(const std::string& sql, const std::vector<std::string>& params) override {
+            utils::StatementTrace trace(instrumentation_.get(), "InMemory", sql, &params);
+            trace.finish(run(sql, params).affected);
+        }
+
+    private:
+        database::InMemoryResult run(const std::string& sql, const std::vector<std::string>& params) {
+            std::vector<nlohmann::json> values(params.begin(), params.end());
+            PooledConnGuard<database::InMemorySession> guard{ pool_.borrow(instrumentation_.get(), "InMemory"), pool_ };
+            return guard.conn->execute(sql, values);
+        }
+    };
+
+} // namespace db
+} // namespace hftools
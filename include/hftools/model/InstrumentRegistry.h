@@ -0,0 +1,174 @@
+#pragma once
+
+#include "hftools/model/FXInstrument.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hftools {
+
+namespace database {
+class Connection;
+class ResultSet;
+}
+
+namespace model {
+
+/**
+ * @brief Compact, fixed-size instrument record stored by InstrumentTable
+ */
+struct InstrumentRecord {
+    int32_t id;
+    char baseCurrency[4];
+    char quoteCurrency[4];
+    double tickSize;
+    char symbol[16];
+
+    std::string_view getSymbol() const { return symbol; }
+    std::string_view getBaseCurrency() const { return baseCurrency; }
+    std::string_view getQuoteCurrency() const { return quoteCurrency; }
+
+    FXInstrument toFXInstrument() const;
+};
+
+/**
+ * @brief Contiguous run of instrument ids returned by the currency indexes
+ */
+struct InstrumentIdSpan {
+    const int32_t* first;
+    const int32_t* last;
+
+    const int32_t* begin() const { return first; }
+    const int32_t* end() const { return last; }
+    size_t size() const { return static_cast<size_t>(last - first); }
+    bool empty() const { return first == last; }
+};
+
+/**
+ * @brief Immutable, read-optimized snapshot of the fxinstruments table
+ *
+ * Built once, never modified: symbol lookups go through a perfect hash
+ * (hash-and-displace), id lookups through a dense array, and currency
+ * lookups through sorted index arrays. All lookups are allocation-free.
+ */
+class InstrumentTable {
+public:
+    InstrumentTable() = default;
+
+    /**
+     * @brief Build a table from loaded instruments
+     * @throws std::invalid_argument on duplicate ids/symbols or over-long codes
+     */
+    explicit InstrumentTable(const std::vector<FXInstrument>& instruments);
+
+    /**
+     * @brief Build a table from a "SELECT id, symbol, base_currency, quote_currency, tick_size" result
+     */
+    static InstrumentTable fromResultSet(database::ResultSet& rs);
+
+    const InstrumentRecord* findBySymbol(std::string_view symbol) const;
+    const InstrumentRecord* findById(int id) const;
+    const InstrumentRecord* findByPair(std::string_view base, std::string_view quote) const;
+
+    /**
+     * @brief Id for a symbol, or -1 if unknown
+     */
+    int idForSymbol(std::string_view symbol) const;
+
+    /**
+     * @brief Ids of all instruments with the given base / quote currency, ascending
+     */
+    InstrumentIdSpan withBaseCurrency(std::string_view ccy) const;
+    InstrumentIdSpan withQuoteCurrency(std::string_view ccy) const;
+
+    size_t size() const { return records_.size(); }
+    const std::vector<InstrumentRecord>& records() const { return records_; }
+
+private:
+    static uint64_t hashSymbol(std::string_view symbol);
+    static uint64_t mix(uint64_t h, uint32_t seed);
+    static uint32_t currencyKey(std::string_view ccy);
+
+    InstrumentIdSpan currencyRange(const std::vector<uint32_t>& keys, const std::vector<int32_t>& ids,
+                                   std::string_view ccy) const;
+
+    std::vector<InstrumentRecord> records_;   // sorted by id
+
+    // id -> index into records_ (-1 for holes), offset by minId_; left empty
+    // when the ids are sparse, and findById() binary-searches records_ instead
+    int32_t minId_ = 0;
+    std::vector<int32_t> denseIndex_;
+
+    // Perfect hash: bucket seeds, then slot -> index into records_ (-1 if empty)
+    std::vector<uint32_t> seeds_;
+    std::vector<int32_t> slots_;
+    uint64_t slotMask_ = 0;
+
+    // (base << 32 | quote) -> id, sorted
+    std::vector<uint64_t> pairKeys_;
+    std::vector<int32_t> pairIds_;
+
+    std::vector<uint32_t> baseKeys_;
+    std::vector<int32_t> baseIds_;
+    std::vector<uint32_t> quoteKeys_;
+    std::vector<int32_t> quoteIds_;
+};
+
+/**
+ * @brief Publishes InstrumentTable snapshots RCU-style
+ *
+ * Readers call current(), a single acquire load, and are never blocked.
+ * publish() swaps in a new snapshot atomically; replaced snapshots are kept
+ * alive until reclaim() is called, which the owner must only do once no
+ * reader can still hold a reference obtained before the last publish()
+ * (e.g. after the next market-data cycle).
+ */
+class InstrumentRegistry {
+public:
+    InstrumentRegistry();
+    ~InstrumentRegistry();
+
+    InstrumentRegistry(const InstrumentRegistry&) = delete;
+    InstrumentRegistry& operator=(const InstrumentRegistry&) = delete;
+
+    /**
+     * @brief Current snapshot (wait-free)
+     */
+    const InstrumentTable& current() const {
+        return *current_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Atomically replace the current snapshot
+     */
+    void publish(InstrumentTable table);
+
+    /**
+     * @brief Load fxinstruments through a connection and publish the result
+     */
+    void loadFrom(database::Connection& conn);
+
+    /**
+     * @brief Free snapshots replaced by earlier publish() calls
+     * @return Number of snapshots freed
+     */
+    size_t reclaim();
+
+    /**
+     * @brief Number of replaced snapshots waiting for reclaim()
+     */
+    size_t retiredCount() const;
+
+private:
+    std::atomic<const InstrumentTable*> current_;
+    mutable std::mutex writerMutex_;
+    std::unique_ptr<const InstrumentTable> owned_;
+    std::vector<std::unique_ptr<const InstrumentTable>> retired_;
+};
+
+} // namespace model
+} // namespace hftools
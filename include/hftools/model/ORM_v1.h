@@ -6,7 +6,11 @@
 #include <vector>
 #include <type_traits>
 #include <utility>
+#include <algorithm>
+#include <map>
+#include <stdexcept>
 #include <nlohmann/json.hpp>
+#include "EntityTraits.h"
 
 //
 // =======================
@@ -17,14 +21,6 @@
 namespace hftools {
 namespace model {
 
-// Column must be defined before EntityTraits
-
-template <typename T, typename FieldType>
-struct Column {
-    std::string_view name;
-    FieldType T::* member;
-};
-
 class BaseEntity {
 public:
     BaseEntity() = default;
@@ -56,9 +52,6 @@ public:
     template<typename T> friend struct EntityTraits;
 };
 
-template<typename T>
-struct EntityTraits; // primary template
-
 template<>
 struct EntityTraits<hftools::model::FXInstrument2> {
     using Entity = hftools::model::FXInstrument2;
@@ -80,17 +73,33 @@ struct EntityTraits<hftools::model::FXInstrument2> {
 } // namespace model
 } // namespace hftools
 
+// The builders and Repository<T> below live in the global namespace
+using hftools::model::EntityTraits;
+
 //
 // =======================
 // 2. Generic DB interface (prepared only)
 // =======================
 //
 
+// SQL flavour spoken by an IDatabase2 backend
+enum class SqlDialect {
+    PostgreSQL,
+    Sybase
+};
+
+// Bind placeholder for the 1-based parameter index: $1 (PostgreSQL) or ? (Sybase)
+inline std::string sqlPlaceholder(SqlDialect dialect, int index) {
+    return dialect == SqlDialect::PostgreSQL ? "$" + std::to_string(index) : std::string("?");
+}
+
 // Generic DB interface (prepared only)
 class IDatabase2 {
 public:
     virtual ~IDatabase2() = default;
 
+    virtual SqlDialect dialect() const { return SqlDialect::PostgreSQL; }
+
     virtual nlohmann::json queryOnePrepared(
         const std::string& sql,
         const std::vector<nlohmann::json>& params) = 0;
@@ -102,6 +111,21 @@ public:
     virtual int executePrepared(
         const std::string& sql,
         const std::vector<nlohmann::json>& params) = 0;
+
+    // Transaction control. The defaults send BEGIN/COMMIT/ROLLBACK through
+    // executePrepared, which is only right for single-connection backends;
+    // pooled backends must pin one connection for the transaction and override these.
+    virtual void beginTransaction() {
+        executePrepared(dialect() == SqlDialect::Sybase ? "BEGIN TRANSACTION" : "BEGIN", {});
+    }
+
+    virtual void commitTransaction() {
+        executePrepared(dialect() == SqlDialect::Sybase ? "COMMIT TRANSACTION" : "COMMIT", {});
+    }
+
+    virtual void rollbackTransaction() {
+        executePrepared(dialect() == SqlDialect::Sybase ? "ROLLBACK TRANSACTION" : "ROLLBACK", {});
+    }
 };
 
 class MyDatabase : public IDatabase2
@@ -183,7 +207,7 @@ inline std::vector<std::string> parseInsertColumns(const std::string& sql) {
 // Implementations for MyDatabase: create simple mock responses by using EntityTraits when possible.
 
 // implement queryOnePrepared / queryManyPrepared / executePrepared
-nlohmann::json MyDatabase::queryOnePrepared(
+inline nlohmann::json MyDatabase::queryOnePrepared(
     const std::string& sql,
     const std::vector<nlohmann::json>& params)
 {
@@ -221,7 +245,7 @@ nlohmann::json MyDatabase::queryOnePrepared(
     return row;
 }
 
-std::vector<nlohmann::json> MyDatabase::queryManyPrepared(
+inline std::vector<nlohmann::json> MyDatabase::queryManyPrepared(
     const std::string& sql,
     const std::vector<nlohmann::json>& params)
 {
@@ -257,7 +281,7 @@ std::vector<nlohmann::json> MyDatabase::queryManyPrepared(
     return rows;
 }
 
-int MyDatabase::executePrepared(
+inline int MyDatabase::executePrepared(
     const std::string& sql,
     const std::vector<nlohmann::json>& params)
 {
@@ -346,7 +370,7 @@ hftools::model::FXInstrument2::fromJson(const nlohmann::json& j)
 
 // INSERT INTO table (a,b,c) VALUES ($1,$2,$3)
 template <typename T>
-std::string buildInsertSQL() {
+std::string buildInsertSQL(SqlDialect dialect = SqlDialect::PostgreSQL) {
     std::string sql = "INSERT INTO ";
     sql += EntityTraits<T>::tableName;
     sql += " (";
@@ -364,7 +388,7 @@ std::string buildInsertSQL() {
     int index = 1;
     for_each(EntityTraits<T>::columns, [&](auto /*col*/) {
         if (!first) sql += ", ";
-        sql += "$" + std::to_string(index++);
+        sql += sqlPlaceholder(dialect, index++);
         first = false;
     });
 
@@ -383,7 +407,7 @@ std::vector<nlohmann::json> buildInsertParams(const T& obj) {
 
 // UPDATE table SET a=$1,b=$2 WHERE id=$N
 template <typename T>
-std::string buildUpdateSQL() {
+std::string buildUpdateSQL(SqlDialect dialect = SqlDialect::PostgreSQL) {
     std::string sql = "UPDATE ";
     sql += EntityTraits<T>::tableName;
     sql += " SET ";
@@ -397,13 +421,13 @@ std::string buildUpdateSQL() {
 
         if (!first) sql += ", ";
         sql += col.name;
-        sql += "=$" + std::to_string(index++);
+        sql += "=" + sqlPlaceholder(dialect, index++);
         first = false;
     });
 
     sql += " WHERE ";
     sql += EntityTraits<T>::primaryKey;
-    sql += "=$" + std::to_string(index);
+    sql += "=" + sqlPlaceholder(dialect, index);
 
     return sql;
 }
@@ -429,12 +453,12 @@ std::vector<nlohmann::json> buildUpdateParams(const T& obj) {
 
 // DELETE FROM table WHERE id=$1
 template <typename T>
-std::string buildDeleteSQL() {
+std::string buildDeleteSQL(SqlDialect dialect = SqlDialect::PostgreSQL) {
     std::string sql = "DELETE FROM ";
     sql += EntityTraits<T>::tableName;
     sql += " WHERE ";
     sql += EntityTraits<T>::primaryKey;
-    sql += "=$1";
+    sql += "=" + sqlPlaceholder(dialect, 1);
     return sql;
 }
 
@@ -448,12 +472,348 @@ std::vector<nlohmann::json> buildDeleteParams(const T& obj) {
     return params;
 }
 
+template <typename T>
+constexpr size_t columnCount() {
+    return std::tuple_size_v<std::decay_t<decltype(EntityTraits<T>::columns)>>;
+}
+
+// (a,b,c) placeholder groups for rowCount rows, numbered from firstIndex:
+// ($1, $2, $3), ($4, $5, $6)
+template <typename T>
+std::string buildValuesRows(SqlDialect dialect, size_t rowCount, int firstIndex = 1) {
+    std::string sql;
+    int index = firstIndex;
+    for (size_t r = 0; r < rowCount; ++r) {
+        if (r > 0) sql += ", ";
+        sql += "(";
+        for (size_t c = 0; c < columnCount<T>(); ++c) {
+            if (c > 0) sql += ", ";
+            sql += sqlPlaceholder(dialect, index++);
+        }
+        sql += ")";
+    }
+    return sql;
+}
+
+// Plain insert of rowCount rows; parameters are buildInsertParams() of each
+// row, concatenated.
+// PostgreSQL: INSERT INTO table (id,a,b) VALUES ($1,$2,$3), ($4,$5,$6)
+// Sybase:     INSERT INTO table (id,a,b) VALUES (?,?,?) INSERT INTO table (id,a,b) VALUES (?,?,?)
+//             (ASE has no multi-row VALUES; the statements go as one batch)
+template <typename T>
+std::string buildInsertManySQL(SqlDialect dialect, size_t rowCount) {
+    if (dialect == SqlDialect::PostgreSQL) {
+        const std::string single = buildInsertSQL<T>(dialect);
+        return single.substr(0, single.rfind(" VALUES ")) + " VALUES " + buildValuesRows<T>(dialect, rowCount);
+    }
+
+    const std::string single = buildInsertSQL<T>(dialect);
+    std::string sql;
+    sql.reserve((single.size() + 1) * rowCount);
+    for (size_t r = 0; r < rowCount; ++r) {
+        if (r > 0) sql += " ";
+        sql += single;
+    }
+    return sql;
+}
+
+// Insert-or-update of rowCount rows keyed on the primary key; parameters are
+// buildInsertParams() of each row, concatenated.
+// PostgreSQL: INSERT INTO table (id,a,b) VALUES ($1,$2,$3), ...
+//             ON CONFLICT (id) DO UPDATE SET a=EXCLUDED.a, b=EXCLUDED.b
+// Sybase:     MERGE INTO table AS t
+//             USING (SELECT ? AS id, ? AS a, ? AS b UNION ALL SELECT ?, ?, ? ...) AS s
+//             ON t.id = s.id
+//             WHEN MATCHED THEN UPDATE SET a=s.a, b=s.b
+//             WHEN NOT MATCHED THEN INSERT (id,a,b) VALUES (s.id, s.a, s.b)
+template <typename T>
+std::string buildUpsertSQL(SqlDialect dialect, size_t rowCount) {
+    std::string columns;
+    std::string updates;
+    std::string sourceValues;
+    const char* source = dialect == SqlDialect::PostgreSQL ? "EXCLUDED." : "s.";
+
+    for_each(EntityTraits<T>::columns, [&](auto col) {
+        if (!columns.empty()) { columns += ", "; sourceValues += ", "; }
+        columns += col.name;
+        sourceValues += std::string(source) + std::string(col.name);
+
+        if (col.name == EntityTraits<T>::primaryKey)
+            return;
+        if (!updates.empty()) updates += ", ";
+        updates += std::string(col.name) + "=" + source + std::string(col.name);
+    });
+
+    const std::string table(EntityTraits<T>::tableName);
+    const std::string pk(EntityTraits<T>::primaryKey);
+
+    if (dialect == SqlDialect::PostgreSQL) {
+        std::string sql = "INSERT INTO " + table + " (" + columns + ") VALUES " +
+                          buildValuesRows<T>(dialect, rowCount) +
+                          " ON CONFLICT (" + pk + ") DO ";
+        // A table with nothing but its key still needs a conflict action
+        sql += updates.empty() ? "NOTHING" : "UPDATE SET " + updates;
+        return sql;
+    }
+
+    std::string rows;
+    for (size_t r = 0; r < rowCount; ++r) {
+        rows += r == 0 ? "SELECT " : " UNION ALL SELECT ";
+        bool first = true;
+        for_each(EntityTraits<T>::columns, [&](auto col) {
+            if (!first) rows += ", ";
+            rows += "?";
+            if (r == 0) rows += " AS " + std::string(col.name);
+            first = false;
+        });
+    }
+
+    std::string sql = "MERGE INTO " + table + " AS t USING (" + rows + ") AS s ON t." + pk + " = s." + pk;
+    if (!updates.empty())
+        sql += " WHEN MATCHED THEN UPDATE SET " + updates;
+    sql += " WHEN NOT MATCHED THEN INSERT (" + columns + ") VALUES (" + sourceValues + ")";
+    return sql;
+}
+
+// Column name mapped to a member pointer in EntityTraits<T> ("" if unmapped).
+// constexpr so projections can reject unmapped members at compile time.
+template <typename T, auto Member>
+constexpr std::string_view columnNameOf() {
+    std::string_view name;
+    for_each(EntityTraits<T>::columns, [&](auto col) {
+        if constexpr (std::is_same_v<decltype(col.member), decltype(Member)>) {
+            if (col.member == Member) name = col.name;
+        }
+    });
+    return name;
+}
+
+template <typename M> struct MemberOwner;
+template <typename C, typename F> struct MemberOwner<F C::*> { using type = C; };
+
+// Compile-time subset of EntityTraits<T>::columns, e.g.
+// Projection<&FXInstrument2::_id, &FXInstrument2::_price>
+template <auto... Members>
+struct Projection {
+    static_assert(sizeof...(Members) > 0, "Projection needs at least one member");
+
+    using Entity = typename MemberOwner<std::tuple_element_t<0, std::tuple<decltype(Members)...>>>::type;
+
+    static_assert((std::is_same_v<typename MemberOwner<decltype(Members)>::type, Entity> && ...),
+                  "Projection members must belong to the same entity");
+    static_assert((!columnNameOf<Entity, Members>().empty() && ...),
+                  "Projection member is not mapped in EntityTraits");
+
+    // "a, b, c"
+    static std::string columnList() {
+        std::string list;
+        ((list += (list.empty() ? "" : ", "), list += columnNameOf<Entity, Members>()), ...);
+        return list;
+    }
+
+    // Assign only the projected members; the others keep their default values
+    static void hydrate(const nlohmann::json& row, Entity& obj) {
+        (assign<Members>(row, obj), ...);
+    }
+
+private:
+    template <auto Member>
+    static void assign(const nlohmann::json& row, Entity& obj) {
+        auto it = row.find(std::string(columnNameOf<Entity, Member>()));
+        if (it != row.end() && !it->is_null())
+            it->get_to(obj.*Member);
+    }
+};
+
+// SELECT a, b FROM table [WHERE id=$1]
+template <typename P>
+std::string buildSelectProjectionSQL(bool byId, SqlDialect dialect = SqlDialect::PostgreSQL) {
+    using T = typename P::Entity;
+    std::string sql = "SELECT " + P::columnList() + " FROM ";
+    sql += EntityTraits<T>::tableName;
+    if (byId) {
+        sql += " WHERE ";
+        sql += EntityTraits<T>::primaryKey;
+        sql += "=" + sqlPlaceholder(dialect, 1);
+    }
+    return sql;
+}
+
+// "a, b, c" over every column of EntityTraits<T>
+template <typename T>
+std::string buildColumnList() {
+    std::string list;
+    for_each(EntityTraits<T>::columns, [&](auto col) {
+        if (!list.empty()) list += ", ";
+        list += col.name;
+    });
+    return list;
+}
+
+// One keyset page in primary-key order, parameter 1 = last key seen:
+// PostgreSQL: SELECT a, b FROM table WHERE id > $1 ORDER BY id LIMIT n
+// Sybase:     SELECT TOP n a, b FROM table WHERE id > ? ORDER BY id
+template <typename T>
+std::string buildKeysetPageSQL(SqlDialect dialect, size_t pageSize) {
+    std::string sql = "SELECT ";
+    if (dialect == SqlDialect::Sybase)
+        sql += "TOP " + std::to_string(pageSize) + " ";
+    sql += buildColumnList<T>();
+    sql += " FROM ";
+    sql += EntityTraits<T>::tableName;
+    sql += " WHERE ";
+    sql += EntityTraits<T>::primaryKey;
+    sql += " > " + sqlPlaceholder(dialect, 1);
+    sql += " ORDER BY ";
+    sql += EntityTraits<T>::primaryKey;
+    if (dialect == SqlDialect::PostgreSQL)
+        sql += " LIMIT " + std::to_string(pageSize);
+    return sql;
+}
+
+// PostgreSQL: SELECT * FROM table WHERE id = ANY($1)   (one array parameter)
+// Sybase:     SELECT * FROM table WHERE id IN (?, ?, ...) (count parameters)
+template <typename T>
+std::string buildSelectByIdsSQL(SqlDialect dialect, size_t count) {
+    std::string sql = "SELECT * FROM ";
+    sql += EntityTraits<T>::tableName;
+    sql += " WHERE ";
+    sql += EntityTraits<T>::primaryKey;
+
+    if (dialect == SqlDialect::PostgreSQL) {
+        sql += " = ANY($1)";
+        return sql;
+    }
+
+    sql += " IN (";
+    for (size_t i = 0; i < count; ++i) {
+        if (i > 0) sql += ", ";
+        sql += sqlPlaceholder(dialect, static_cast<int>(i + 1));
+    }
+    sql += ")";
+    return sql;
+}
+
+// Text form of an int[] parameter: {1,2,3}
+inline std::string buildIntArrayLiteral(const int* ids, size_t count) {
+    std::string literal = "{";
+    for (size_t i = 0; i < count; ++i) {
+        if (i > 0) literal += ",";
+        literal += std::to_string(ids[i]);
+    }
+    literal += "}";
+    return literal;
+}
+
+// Value of the EntityTraits<T>::primaryKey column (integer keys only)
+template<typename T>
+int getPrimaryKey(const T& obj) {
+    int id = 0;
+    for_each(EntityTraits<T>::columns, [&](auto col) {
+        using FieldType = std::remove_reference_t<decltype(obj.*(col.member))>;
+        if constexpr (std::is_arithmetic_v<FieldType>) {
+            if (col.name == EntityTraits<T>::primaryKey)
+                id = static_cast<int>(obj.*(col.member));
+        }
+    });
+    return id;
+}
+
+// Store a generated key into the EntityTraits<T>::primaryKey column
+template<typename T>
+void setPrimaryKey(T& obj, int id) {
+    for_each(EntityTraits<T>::columns, [&](auto col) {
+        using FieldType = std::remove_reference_t<decltype(obj.*(col.member))>;
+        if constexpr (std::is_arithmetic_v<FieldType>) {
+            if (col.name == EntityTraits<T>::primaryKey)
+                obj.*(col.member) = static_cast<FieldType>(id);
+        }
+    });
+}
+
+// Generated-key insert of rowCount rows: the primary key column is left out
+// so SERIAL / IDENTITY assigns it, and the new keys come back as one result
+// set, in row order, with a single column named after the primary key.
+// PostgreSQL: INSERT INTO table (a,b) VALUES ($1,$2), ($3,$4) RETURNING id
+//             (a plain multi-row INSERT returns its rows in VALUES order)
+// Sybase:     DECLARE @id1 numeric(38,0), @id2 numeric(38,0)
+//             INSERT INTO table (a,b) VALUES (?,?) SELECT @id1 = @@identity
+//             INSERT INTO table (a,b) VALUES (?,?) SELECT @id2 = @@identity
+//             SELECT @id1 AS id UNION ALL SELECT @id2
+//             (@@identity only holds the last key, so each is captured as it is assigned)
+template <typename T>
+std::string buildInsertReturningIdSQL(SqlDialect dialect, size_t rowCount) {
+    std::string columns;
+    size_t valueCount = 0;
+    for_each(EntityTraits<T>::columns, [&](auto col) {
+        if (col.name == EntityTraits<T>::primaryKey)
+            return;
+        if (!columns.empty()) columns += ", ";
+        columns += col.name;
+        ++valueCount;
+    });
+
+    auto valuesRow = [&](int firstIndex) {
+        std::string row = "(";
+        for (size_t c = 0; c < valueCount; ++c) {
+            if (c > 0) row += ", ";
+            row += sqlPlaceholder(dialect, firstIndex + static_cast<int>(c));
+        }
+        return row + ")";
+    };
+
+    const std::string insert = "INSERT INTO " + std::string(EntityTraits<T>::tableName) + " (" + columns + ") VALUES ";
+    const std::string pk(EntityTraits<T>::primaryKey);
+
+    if (dialect == SqlDialect::PostgreSQL) {
+        std::string sql = insert;
+        for (size_t r = 0; r < rowCount; ++r) {
+            if (r > 0) sql += ", ";
+            sql += valuesRow(static_cast<int>(r * valueCount) + 1);
+        }
+        return sql + " RETURNING " + pk;
+    }
+
+    std::string sql = "DECLARE ";
+    for (size_t r = 1; r <= rowCount; ++r) {
+        if (r > 1) sql += ", ";
+        sql += "@id" + std::to_string(r) + " numeric(38,0)";
+    }
+    for (size_t r = 1; r <= rowCount; ++r)
+        sql += " " + insert + valuesRow(0) + " SELECT @id" + std::to_string(r) + " = @@identity";
+    for (size_t r = 1; r <= rowCount; ++r)
+        sql += (r == 1 ? " SELECT @id1 AS " + pk : " UNION ALL SELECT @id" + std::to_string(r));
+    return sql;
+}
+
+// Parameters for buildInsertReturningIdSQL: every column except the primary key
+template<typename T>
+std::vector<nlohmann::json> buildInsertParamsWithoutKey(const T& obj) {
+    std::vector<nlohmann::json> params;
+    for_each(EntityTraits<T>::columns, [&](auto col) {
+        if (col.name != EntityTraits<T>::primaryKey)
+            params.push_back(obj.*(col.member));
+    });
+    return params;
+}
+
+// Generated key from a result row; drivers may hand numeric(38,0) back as text
+inline int generatedKeyFrom(const nlohmann::json& row, std::string_view column) {
+    const nlohmann::json& v = row.at(std::string(column));
+    if (v.is_string())
+        return std::stoi(v.get<std::string>());
+    return v.get<int>();
+}
+
 //
 // =======================
 // 8. Generic Repository<T> (prepared only)
 // =======================
 //
 
+template<typename T> class Query;        // Query.h
+template<typename T> class EntityStream; // EntityStream.h
+
 template<typename T>
 class Repository {
 public:
@@ -465,10 +825,44 @@ public:
             std::string(EntityTraits<T>::tableName) +
             " WHERE " +
             std::string(EntityTraits<T>::primaryKey) +
-            "=$1";
+            "=" + sqlPlaceholder(db_.dialect(), 1);
 
         auto row = db_.queryOnePrepared(sql, { nlohmann::json(id) });
-        return T::fromJson(row);
+        return autoFromJson<T>(row);
+    }
+
+    // One round-trip on PostgreSQL (= ANY), ceil(n / kMaxInListParams) on Sybase (IN lists).
+    // Duplicate ids are fetched once; ids with no row are simply absent from the result.
+    std::map<int, T> getByIds(const std::vector<int>& ids) {
+        std::vector<int> keys(ids);
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+        std::map<int, T> result;
+        if (keys.empty())
+            return result;
+
+        const SqlDialect dialect = db_.dialect();
+        const size_t chunk = dialect == SqlDialect::PostgreSQL ? keys.size() : kMaxInListParams;
+
+        for (size_t offset = 0; offset < keys.size(); offset += chunk) {
+            const size_t count = std::min(chunk, keys.size() - offset);
+
+            std::vector<nlohmann::json> params;
+            if (dialect == SqlDialect::PostgreSQL) {
+                params.emplace_back(buildIntArrayLiteral(keys.data() + offset, count));
+            } else {
+                params.assign(keys.begin() + offset, keys.begin() + offset + count);
+            }
+
+            auto rows = db_.queryManyPrepared(buildSelectByIdsSQL<T>(dialect, count), params);
+            for (auto& r : rows) {
+                T obj = autoFromJson<T>(r);
+                int id = getPrimaryKey(obj);
+                result.emplace(id, std::move(obj));
+            }
+        }
+        return result;
     }
 
     std::vector<T> getAll() {
@@ -480,32 +874,233 @@ public:
         std::vector<T> result;
         result.reserve(rows.size());
         for (auto& r : rows)
-            result.push_back(T::fromJson(r));
+            result.push_back(autoFromJson<T>(r));
         return result;
     }
 
+    // Projection queries: only the listed members are selected and hydrated,
+    // e.g. repo.getAllProjected<&E::_id, &E::_price, &E::_quantity>()
+    template <auto... Members>
+    T getByIdProjected(int id) {
+        using P = Projection<Members...>;
+        static_assert(std::is_same_v<typename P::Entity, T>, "Projection members must belong to T");
+
+        auto row = db_.queryOnePrepared(buildSelectProjectionSQL<P>(true, db_.dialect()), { nlohmann::json(id) });
+        T obj;
+        P::hydrate(row, obj);
+        return obj;
+    }
+
+    template <auto... Members>
+    std::vector<T> getAllProjected() {
+        using P = Projection<Members...>;
+        static_assert(std::is_same_v<typename P::Entity, T>, "Projection members must belong to T");
+
+        auto rows = db_.queryManyPrepared(buildSelectProjectionSQL<P>(false, db_.dialect()), {});
+        std::vector<T> result(rows.size());
+        for (size_t i = 0; i < rows.size(); ++i)
+            P::hydrate(rows[i], result[i]);
+        return result;
+    }
+
+    // Server-side filtering; defined in Query.h
+    std::vector<T> find(const Query<T>& query);
+
+    // Lazy keyset-paginated walk over the whole table; defined in EntityStream.h
+    EntityStream<T> stream(size_t pageSize = 1000);
+
     void insert(const T& obj) {
         db_.executePrepared(
-            buildInsertSQL<T>(),
+            buildInsertSQL<T>(db_.dialect()),
             buildInsertParams(obj)
         );
     }
 
+    // Insert without the primary key and store the generated one back into obj
+    int insertReturningId(T& obj) {
+        auto row = db_.queryOnePrepared(
+            buildInsertReturningIdSQL<T>(db_.dialect(), 1),
+            buildInsertParamsWithoutKey(obj)
+        );
+        const int id = generatedKeyFrom(row, EntityTraits<T>::primaryKey);
+        setPrimaryKey(obj, id);
+        return id;
+    }
+
+    // Bulk form: one statement (PostgreSQL) or batch (Sybase) per chunk,
+    // all chunks in one transaction. Every element gets its generated key.
+    std::vector<int> insertManyReturningIds(std::vector<T>& objs) {
+        std::vector<int> ids;
+        if (objs.empty())
+            return ids;
+        ids.reserve(objs.size());
+
+        const SqlDialect dialect = db_.dialect();
+        const size_t valueCount = columnCount<T>() - 1;
+        const size_t maxParams = dialect == SqlDialect::PostgreSQL ? kMaxPostgresParams : kMaxInListParams;
+        const size_t chunk = std::max<size_t>(1, maxParams / std::max<size_t>(1, valueCount));
+        const bool batched = objs.size() > chunk;
+
+        if (batched) db_.beginTransaction();
+        try {
+            for (size_t offset = 0; offset < objs.size(); offset += chunk) {
+                const size_t count = std::min(chunk, objs.size() - offset);
+                std::vector<nlohmann::json> params;
+                params.reserve(count * valueCount);
+                for (size_t i = offset; i < offset + count; ++i) {
+                    auto p = buildInsertParamsWithoutKey(objs[i]);
+                    params.insert(params.end(), std::make_move_iterator(p.begin()), std::make_move_iterator(p.end()));
+                }
+
+                auto rows = db_.queryManyPrepared(buildInsertReturningIdSQL<T>(dialect, count), params);
+                if (rows.size() != count)
+                    throw std::runtime_error("Generated key count does not match inserted row count");
+                for (size_t i = 0; i < count; ++i) {
+                    const int id = generatedKeyFrom(rows[i], EntityTraits<T>::primaryKey);
+                    setPrimaryKey(objs[offset + i], id);
+                    ids.push_back(id);
+                }
+            }
+            if (batched) db_.commitTransaction();
+        } catch (...) {
+            if (batched) db_.rollbackTransaction();
+            throw;
+        }
+        return ids;
+    }
+
+    // Multi-row insert with the keys already set: as few statements as the
+    // per-statement parameter limit allows, all in one transaction.
+    // Returns the number of rows written.
+    size_t insertMany(const std::vector<T>& objs) {
+        std::vector<const T*> rows;
+        rows.reserve(objs.size());
+        for (const auto& obj : objs)
+            rows.push_back(&obj);
+        if (rows.empty())
+            return 0;
+
+        inTransactionIf(rows.size() > rowsPerStatement(db_.dialect()),
+                        [&] { executeMultiRow(rows, &buildInsertManySQL<T>); });
+        return rows.size();
+    }
+
     void update(const T& obj) {
         db_.executePrepared(
-            buildUpdateSQL<T>(),
+            buildUpdateSQL<T>(db_.dialect()),
             buildUpdateParams(obj)
         );
     }
 
     void remove(const T& obj) {
         db_.executePrepared(
-            buildDeleteSQL<T>(),
+            buildDeleteSQL<T>(db_.dialect()),
             buildDeleteParams(obj)
         );
     }
 
+    // Insert, or overwrite every column of the row with the same primary key,
+    // in one statement (no read-then-write race)
+    void upsert(const T& obj) {
+        db_.executePrepared(
+            buildUpsertSQL<T>(db_.dialect(), 1),
+            buildInsertParams(obj)
+        );
+    }
+
+    // Multi-row upsert: as few statements as the per-statement parameter
+    // limit allows, all in one transaction. When a key appears more than once
+    // the last occurrence wins (one statement may not touch a row twice).
+    // Returns the number of distinct rows written.
+    size_t upsertMany(const std::vector<T>& objs) {
+        std::vector<const T*> rows;
+        rows.reserve(objs.size());
+        for (const auto& obj : objs)
+            rows.push_back(&obj);
+        keepLastPerKey(rows);
+        if (rows.empty())
+            return 0;
+
+        inTransactionIf(rows.size() > rowsPerStatement(db_.dialect()),
+                        [&] { executeMultiRow(rows, &buildUpsertSQL<T>); });
+        return rows.size();
+    }
+
+    // Writes rows with as few statements as the per-statement parameter limit
+    // allows, in the caller's transaction if any (none is opened here).
+    // sqlFor(dialect, n) is the statement for n rows whose parameters are
+    // buildInsertParams() of each row: buildInsertManySQL<T> or buildUpsertSQL<T>.
+    // Returns the number of statements executed.
+    size_t executeMultiRow(const std::vector<const T*>& rows, std::string (*sqlFor)(SqlDialect, size_t)) {
+        if (rows.empty())
+            return 0;
+
+        const SqlDialect dialect = db_.dialect();
+        const size_t chunk = rowsPerStatement(dialect);
+        const size_t fullChunk = std::min(chunk, rows.size());
+
+        // Every full chunk shares one SQL text, so the backend can reuse its plan
+        const std::string fullChunkSQL = sqlFor(dialect, fullChunk);
+
+        size_t statements = 0;
+        for (size_t offset = 0; offset < rows.size(); offset += chunk) {
+            const size_t count = std::min(chunk, rows.size() - offset);
+            std::vector<nlohmann::json> params;
+            params.reserve(count * columnCount<T>());
+            for (size_t i = offset; i < offset + count; ++i) {
+                auto p = buildInsertParams(*rows[i]);
+                params.insert(params.end(), std::make_move_iterator(p.begin()), std::make_move_iterator(p.end()));
+            }
+            db_.executePrepared(count == fullChunk ? fullChunkSQL : sqlFor(dialect, count), params);
+            ++statements;
+        }
+        return statements;
+    }
+
+    // Keeps one pointer per primary key, at its first position, pointing to
+    // the key's last occurrence
+    static void keepLastPerKey(std::vector<const T*>& rows) {
+        std::map<int, size_t> slotOf;
+        size_t kept = 0;
+        for (const T* row : rows) {
+            auto [it, inserted] = slotOf.emplace(getPrimaryKey(*row), kept);
+            if (inserted)
+                rows[kept++] = row;
+            else
+                rows[it->second] = row;
+        }
+        rows.resize(kept);
+    }
+
+    // Rows per multi-row statement for a full-row write
+    static size_t rowsPerStatement(SqlDialect dialect) {
+        const size_t maxParams = dialect == SqlDialect::PostgreSQL ? kMaxPostgresParams : kMaxInListParams;
+        return std::max<size_t>(1, maxParams / columnCount<T>());
+    }
+
+    // Sybase ASE caps parameters per statement; keep IN lists and batches well below it
+    static constexpr size_t kMaxInListParams = 250;
+
+    // Bind parameters per statement allowed by the PostgreSQL wire protocol
+    static constexpr size_t kMaxPostgresParams = 65535;
+
 private:
+    template <typename Fn>
+    void inTransactionIf(bool transactional, Fn&& fn) {
+        if (!transactional) {
+            fn();
+            return;
+        }
+        db_.beginTransaction();
+        try {
+            fn();
+            db_.commitTransaction();
+        } catch (...) {
+            db_.rollbackTransaction();
+            throw;
+        }
+    }
+
     IDatabase2& db_;
 };
 
@@ -525,5 +1120,7 @@ private:
 // auto all = repo.getAll();
 // repo.insert(e);
 // repo.update(e);
+// repo.upsert(e);
+// int newId = repo.insertReturningId(e);   // e._id is filled in
 // repo.remove(e);
 //
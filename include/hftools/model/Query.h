@@ -0,0 +1,265 @@
+#pragma once
+
+#include "ORM_v1.h"
+
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+//
+// =======================
+// Typed query builder over EntityTraits<T>
+// =======================
+//
+// Query<FXInstrument2> q;
+// q.where(&FXInstrument2::_instrumentId, CompareOp::Eq, 1)
+//  .andBetween(&FXInstrument2::_timestamp, from, to)
+//  .orderBy(&FXInstrument2::_timestamp, SortOrder::Desc)
+//  .limit(100);
+// auto rows = repo.find(q);
+//
+// Values are always bound as parameters; only column names (taken from
+// EntityTraits) and LIMIT/TOP counts are rendered into the SQL text.
+//
+
+enum class CompareOp { Eq, Ne, Lt, Le, Gt, Ge };
+enum class SortOrder { Asc, Desc };
+
+// Column name mapped to a member pointer at runtime; throws if unmapped
+template <typename T, typename F>
+std::string_view columnNameFor(F T::* member) {
+    std::string_view name;
+    for_each(EntityTraits<T>::columns, [&](auto col) {
+        if constexpr (std::is_same_v<decltype(col.member), F T::*>) {
+            if (col.member == member) name = col.name;
+        }
+    });
+    if (name.empty())
+        throw std::invalid_argument("Member is not mapped in EntityTraits");
+    return name;
+}
+
+struct QueryStatement {
+    std::string sql;
+    std::vector<nlohmann::json> params;
+};
+
+template <typename T>
+class Query {
+public:
+    template <typename F, typename V>
+    Query& where(F T::* member, CompareOp op, V&& value) {
+        return addCompare(Connective::And, member, op, std::forward<V>(value));
+    }
+
+    template <typename F, typename V>
+    Query& andWhere(F T::* member, CompareOp op, V&& value) {
+        return addCompare(Connective::And, member, op, std::forward<V>(value));
+    }
+
+    template <typename F, typename V>
+    Query& orWhere(F T::* member, CompareOp op, V&& value) {
+        return addCompare(Connective::Or, member, op, std::forward<V>(value));
+    }
+
+    // lo <= member AND member < hi (half-open, so consecutive ranges don't overlap)
+    template <typename F, typename V1, typename V2>
+    Query& andBetween(F T::* member, V1&& lo, V2&& hi) {
+        return addRange(Connective::And, member, std::forward<V1>(lo), std::forward<V2>(hi));
+    }
+
+    template <typename F, typename V1, typename V2>
+    Query& orBetween(F T::* member, V1&& lo, V2&& hi) {
+        return addRange(Connective::Or, member, std::forward<V1>(lo), std::forward<V2>(hi));
+    }
+
+    template <typename F>
+    Query& andIn(F T::* member, const std::vector<F>& values) {
+        if (values.empty())
+            throw std::invalid_argument("IN list must not be empty");
+        Term t{ Connective::And, Kind::In, { std::string(columnNameFor(member)) }, CompareOp::Eq, {} };
+        for (const auto& v : values) t.values.emplace_back(v);
+        terms_.push_back(std::move(t));
+        return *this;
+    }
+
+    template <typename F>
+    Query& orderBy(F T::* member, SortOrder order = SortOrder::Asc) {
+        order_.emplace_back(std::string(columnNameFor(member)), order);
+        return *this;
+    }
+
+    Query& limit(size_t n) { limit_ = n; return *this; }
+    Query& offset(size_t n) { offset_ = n; return *this; }
+
+    // Keyset pagination: rows strictly after `last` in `order` direction,
+    // ordered by that column. Use a unique column (usually the primary key).
+    template <typename F, typename V>
+    Query& after(F T::* member, V&& last, SortOrder order = SortOrder::Asc) {
+        addCompare(Connective::And, member, order == SortOrder::Asc ? CompareOp::Gt : CompareOp::Lt, std::forward<V>(last));
+        return orderBy(member, order);
+    }
+
+    // Keyset over (k1, k2) for non-unique leading keys, e.g. (timestamp, id)
+    template <typename F1, typename V1, typename F2, typename V2>
+    Query& after(F1 T::* k1, V1&& last1, F2 T::* k2, V2&& last2, SortOrder order = SortOrder::Asc) {
+        static_assert(std::is_convertible_v<V1, F1> && std::is_convertible_v<V2, F2>,
+                      "Keyset value type does not match the column type");
+        Term t{ Connective::And, Kind::Keyset,
+                { std::string(columnNameFor(k1)), std::string(columnNameFor(k2)) },
+                order == SortOrder::Asc ? CompareOp::Gt : CompareOp::Lt,
+                { nlohmann::json(F1(std::forward<V1>(last1))), nlohmann::json(F2(std::forward<V2>(last2))) } };
+        terms_.push_back(std::move(t));
+        orderBy(k1, order);
+        return orderBy(k2, order);
+    }
+
+    QueryStatement build(SqlDialect dialect) const {
+        QueryStatement st;
+        st.sql = "SELECT ";
+        if (limit_ && dialect == SqlDialect::Sybase)
+            st.sql += "TOP " + std::to_string(*limit_) + " ";
+        st.sql += buildColumnList<T>();
+        st.sql += " FROM ";
+        st.sql += EntityTraits<T>::tableName;
+
+        if (!terms_.empty()) {
+            std::string expr;
+            Connective previous = terms_.front().connective;
+            for (size_t i = 0; i < terms_.size(); ++i) {
+                std::string term = renderTerm(terms_[i], dialect, st.params);
+                if (i == 0) {
+                    expr = term;
+                    continue;
+                }
+                // Left-associative: a AND b OR c == (a AND b) OR c
+                if (i > 1 && terms_[i].connective != previous)
+                    expr = "(" + expr + ")";
+                expr += terms_[i].connective == Connective::And ? " AND " : " OR ";
+                expr += term;
+                previous = terms_[i].connective;
+            }
+            st.sql += " WHERE " + expr;
+        }
+
+        if (!order_.empty()) {
+            st.sql += " ORDER BY ";
+            for (size_t i = 0; i < order_.size(); ++i) {
+                if (i > 0) st.sql += ", ";
+                st.sql += order_[i].first;
+                st.sql += order_[i].second == SortOrder::Asc ? " ASC" : " DESC";
+            }
+        }
+
+        if (dialect == SqlDialect::PostgreSQL) {
+            if (limit_) st.sql += " LIMIT " + std::to_string(*limit_);
+            if (offset_) st.sql += " OFFSET " + std::to_string(*offset_);
+        } else if (offset_) {
+            throw std::invalid_argument("OFFSET is not supported on Sybase ASE; use keyset pagination (after())");
+        }
+        return st;
+    }
+
+private:
+    enum class Connective { And, Or };
+    enum class Kind { Compare, Range, In, Keyset };
+
+    struct Term {
+        Connective connective;
+        Kind kind;
+        std::vector<std::string> columns;
+        CompareOp op;
+        std::vector<nlohmann::json> values;
+    };
+
+    template <typename F, typename V>
+    Query& addCompare(Connective c, F T::* member, CompareOp op, V&& value) {
+        static_assert(std::is_convertible_v<V, F>, "Value type does not match the column type");
+        terms_.push_back(Term{ c, Kind::Compare, { std::string(columnNameFor(member)) }, op,
+                               { nlohmann::json(F(std::forward<V>(value))) } });
+        return *this;
+    }
+
+    template <typename F, typename V1, typename V2>
+    Query& addRange(Connective c, F T::* member, V1&& lo, V2&& hi) {
+        static_assert(std::is_convertible_v<V1, F> && std::is_convertible_v<V2, F>,
+                      "Range bound type does not match the column type");
+        terms_.push_back(Term{ c, Kind::Range, { std::string(columnNameFor(member)) }, CompareOp::Ge,
+                               { nlohmann::json(F(std::forward<V1>(lo))), nlohmann::json(F(std::forward<V2>(hi))) } });
+        return *this;
+    }
+
+    static const char* opText(CompareOp op) {
+        switch (op) {
+        case CompareOp::Eq: return " = ";
+        case CompareOp::Ne: return " <> ";
+        case CompareOp::Lt: return " < ";
+        case CompareOp::Le: return " <= ";
+        case CompareOp::Gt: return " > ";
+        case CompareOp::Ge: return " >= ";
+        }
+        return " = ";
+    }
+
+    static std::string bind(SqlDialect dialect, std::vector<nlohmann::json>& params, const nlohmann::json& value) {
+        params.push_back(value);
+        return sqlPlaceholder(dialect, static_cast<int>(params.size()));
+    }
+
+    static std::string renderTerm(const Term& t, SqlDialect dialect, std::vector<nlohmann::json>& params) {
+        const std::string& col = t.columns.front();
+        switch (t.kind) {
+        case Kind::Compare:
+            return col + opText(t.op) + bind(dialect, params, t.values[0]);
+        case Kind::Range: {
+            std::string lo = bind(dialect, params, t.values[0]);
+            std::string hi = bind(dialect, params, t.values[1]);
+            return "(" + col + " >= " + lo + " AND " + col + " < " + hi + ")";
+        }
+        case Kind::In: {
+            std::string sql = col + " IN (";
+            for (size_t i = 0; i < t.values.size(); ++i) {
+                if (i > 0) sql += ", ";
+                sql += bind(dialect, params, t.values[i]);
+            }
+            return sql + ")";
+        }
+        case Kind::Keyset: {
+            const std::string& col2 = t.columns[1];
+            if (dialect == SqlDialect::PostgreSQL) {
+                // Row comparison lets PostgreSQL use a (k1, k2) index directly
+                std::string a = bind(dialect, params, t.values[0]);
+                std::string b = bind(dialect, params, t.values[1]);
+                return "(" + col + ", " + col2 + ")" + opText(t.op) + "(" + a + ", " + b + ")";
+            }
+            std::string a1 = bind(dialect, params, t.values[0]);
+            std::string a2 = bind(dialect, params, t.values[0]);
+            std::string b = bind(dialect, params, t.values[1]);
+            return "(" + col + opText(t.op) + a1 + " OR (" + col + " = " + a2 + " AND " + col2 + opText(t.op) + b + "))";
+        }
+        }
+        return std::string();
+    }
+
+    std::vector<Term> terms_;
+    std::vector<std::pair<std::string, SortOrder>> order_;
+    std::optional<size_t> limit_;
+    std::optional<size_t> offset_;
+};
+
+template <typename T>
+std::vector<T> Repository<T>::find(const Query<T>& query) {
+    QueryStatement st = query.build(db_.dialect());
+    auto rows = db_.queryManyPrepared(st.sql, st.params);
+    std::vector<T> result;
+    result.reserve(rows.size());
+    for (auto& r : rows)
+        result.push_back(autoFromJson<T>(r));
+    return result;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "hftools/model/EntityTraits.h"
+#include <charconv>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace hftools {
+namespace model {
+
+/**
+ * @brief Decodes one text field into a member of type F
+ *
+ * Chosen at compile time from the member type; specialize it for any
+ * other field type an entity maps (timestamps, enums, ...).
+ */
+template <typename F, typename Enable = void>
+struct FieldDecoder;
+
+template <typename F>
+struct FieldDecoder<F, std::enable_if_t<std::is_arithmetic_v<F> && !std::is_same_v<F, bool>>> {
+    static void decode(std::string_view text, F& out) {
+        auto res = std::from_chars(text.data(), text.data() + text.size(), out);
+        if (res.ec != std::errc() || res.ptr == text.data()) {
+            throw std::runtime_error("Invalid numeric field: " + std::string(text));
+        }
+    }
+};
+
+template <>
+struct FieldDecoder<bool> {
+    static void decode(std::string_view text, bool& out) {
+        out = text == "t" || text == "1" || text == "true" || text == "TRUE";
+    }
+};
+
+template <>
+struct FieldDecoder<std::string> {
+    static void decode(std::string_view text, std::string& out) {
+        out.assign(text.data(), text.size());
+    }
+};
+
+/**
+ * @brief Straight-line row -> entity conversion generated from EntityTraits<T>
+ *
+ * hydrate() expands to one FieldDecoder call per mapped column, in column
+ * order, with the member pointer and decoder fixed at compile time: no
+ * virtual calls, no json, no per-field type switch.
+ *
+ * A row is an array of text cells (string_view), indexed either in
+ * EntityTraits<T>::columns order or through an ordinal map from each
+ * traits column to its position in the result. A cell whose data() is
+ * nullptr is SQL NULL and leaves the member untouched.
+ */
+template <typename T>
+class RowHydrator {
+public:
+    using Traits = EntityTraits<T>;
+
+    static constexpr size_t columnCount = std::tuple_size_v<std::decay_t<decltype(Traits::columns)>>;
+
+    /**
+     * @brief cells[i] holds EntityTraits<T> column i
+     */
+    static void hydrate(const std::string_view* cells, T& out) {
+        hydrateImpl(cells, nullptr, out, std::make_index_sequence<columnCount>{});
+    }
+
+    static T hydrate(const std::string_view* cells) {
+        T out{};
+        hydrate(cells, out);
+        return out;
+    }
+
+    /**
+     * @brief cells in result order; ordinals[i] is the result position of column i
+     */
+    static void hydrate(const std::string_view* cells, const size_t* ordinals, T& out) {
+        hydrateImpl(cells, ordinals, out, std::make_index_sequence<columnCount>{});
+    }
+
+private:
+    template <size_t I>
+    static void decodeColumn(const std::string_view* cells, const size_t* ordinals, T& out) {
+        constexpr auto col = std::get<I>(Traits::columns);
+        using Field = std::decay_t<decltype(out.*(col.member))>;
+        const std::string_view cell = cells[ordinals ? ordinals[I] : I];
+        if (cell.data() != nullptr) {
+            FieldDecoder<Field>::decode(cell, out.*(col.member));
+        }
+    }
+
+    template <size_t... I>
+    static void hydrateImpl(const std::string_view* cells, const size_t* ordinals, T& out, std::index_sequence<I...>) {
+        (decodeColumn<I>(cells, ordinals, out), ...);
+    }
+};
+
+} // namespace model
+} // namespace hftools
@@ -1,6 +1,8 @@
 #pragma once
 
+#include "hftools/model/EntityTraits.h"
 #include <string>
+#include <tuple>
 #include <nlohmann/json.hpp>
 
 namespace hftools {
@@ -41,6 +43,8 @@ public:
     friend void to_json(nlohmann::json& j, const Trade& t);
     friend void from_json(const nlohmann::json& j, Trade& t);
 
+    template <typename T> friend struct EntityTraits;
+
 private:
     int id_ = 0;
     int userId_ = 0;
@@ -55,5 +59,26 @@ private:
 void to_json(nlohmann::json& j, const Trade& t);
 void from_json(const nlohmann::json& j, Trade& t);
 
+/**
+ * @brief Column mapping of the trades table
+ */
+template <>
+struct EntityTraits<Trade> {
+    using Entity = Trade;
+
+    static constexpr std::string_view tableName  = "trades";
+    static constexpr std::string_view primaryKey = "id";
+
+    static constexpr auto columns = std::make_tuple(
+        Column<Entity, int>{ "id", &Entity::id_ },
+        Column<Entity, int>{ "user_id", &Entity::userId_ },
+        Column<Entity, int>{ "instrument_id", &Entity::instrumentId_ },
+        Column<Entity, std::string>{ "side", &Entity::side_ },
+        Column<Entity, double>{ "quantity", &Entity::quantity_ },
+        Column<Entity, double>{ "price", &Entity::price_ },
+        Column<Entity, std::string>{ "timestamp", &Entity::timestamp_ }
+    );
+};
+
 } // namespace model
 } // namespace hftools
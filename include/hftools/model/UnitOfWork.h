@@ -0,0 +1,261 @@
+#pragma once
+
+#include "ORM_v1.h"
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+//
+// =======================
+// Unit of work over Repository<T>
+// =======================
+//
+// UnitOfWork uow(db);
+// auto& t = uow.get<FXInstrument2>(42);   // loaded once, snapshotted
+// t._price = 1.0851;                      // plain member writes
+// uow.add(newTrade);
+// uow.flush();   // UPDATE FXInstrument2 SET price=$1 WHERE id=$2, INSERT ..., in one transaction
+//
+// Entities loaded through get()/attach() are kept in an identity map together
+// with a snapshot of their column values. flush() diffs every tracked entity
+// against its snapshot through EntityTraits<T>::columns and only writes the
+// columns that actually changed; unchanged entities produce no statement.
+//
+// Statements are grouped by table, tables in the order they were first used:
+// inserts first, then updates (ascending primary key, so concurrent flushes
+// take row locks in the same order), then deletes in reverse table order so
+// children go before their parents. An entity removed and then added again
+// under the same key is written as one upsert of the new state in place of
+// the DELETE / INSERT pair, so it cannot collide with its own old row. A failed flush is rolled back and leaves
+// the tracked state untouched, so it can be retried.
+//
+// Not thread-safe: one UnitOfWork per thread / request.
+//
+
+// UPDATE table SET <changed columns> WHERE id=$N, with its parameters
+template <typename T>
+std::pair<std::string, std::vector<nlohmann::json>>
+buildDirtyUpdate(const T& original, const T& current, SqlDialect dialect = SqlDialect::PostgreSQL) {
+    std::string sql;
+    std::vector<nlohmann::json> params;
+    int index = 1;
+
+    for_each(EntityTraits<T>::columns, [&](auto col) {
+        if (col.name == EntityTraits<T>::primaryKey)
+            return;
+        if (original.*(col.member) == current.*(col.member))
+            return;
+
+        sql += params.empty() ? "UPDATE " + std::string(EntityTraits<T>::tableName) + " SET " : ", ";
+        sql += col.name;
+        sql += "=" + sqlPlaceholder(dialect, index++);
+        params.push_back(current.*(col.member));
+    });
+
+    if (params.empty())
+        return {};
+
+    sql += " WHERE ";
+    sql += EntityTraits<T>::primaryKey;
+    sql += "=" + sqlPlaceholder(dialect, index);
+    params.push_back(getPrimaryKey(current));
+    return { std::move(sql), std::move(params) };
+}
+
+class UnitOfWork {
+public:
+    explicit UnitOfWork(IDatabase2& db) : db_(db) {}
+
+    UnitOfWork(const UnitOfWork&) = delete;
+    UnitOfWork& operator=(const UnitOfWork&) = delete;
+
+    // Tracked entity for id, loaded through Repository<T> on first access.
+    // The reference stays valid until the entity is removed or clear() is called.
+    template <typename T>
+    T& get(int id) {
+        auto& set = setFor<T>();
+        if (set.deletes.count(id))
+            throw std::invalid_argument("Entity is scheduled for deletion: " + std::to_string(id));
+        auto it = set.tracked.find(id);
+        if (it == set.tracked.end()) {
+            T loaded = Repository<T>(db_).getById(id);
+            it = set.tracked.emplace(id, Tracked<T>{ loaded, loaded }).first;
+        }
+        return it->second.current;
+    }
+
+    // Start tracking an entity loaded elsewhere (find(), stream(), ...).
+    // It is assumed to match the database; an already tracked instance wins.
+    template <typename T>
+    T& attach(const T& obj) {
+        auto& set = setFor<T>();
+        const int id = getPrimaryKey(obj);
+        auto it = set.tracked.find(id);
+        if (it == set.tracked.end())
+            it = set.tracked.emplace(id, Tracked<T>{ obj, obj }).first;
+        return it->second.current;
+    }
+
+    // Schedule an INSERT; the entity is tracked like a loaded one after flush().
+    // Adding a key with a pending DELETE replaces that row instead.
+    template <typename T>
+    void add(const T& obj) {
+        auto& set = setFor<T>();
+        const int id = getPrimaryKey(obj);
+        if (set.deletes.erase(id)) {
+            set.tracked.insert_or_assign(id, Tracked<T>{ obj, obj, true });
+            return;
+        }
+        set.inserts.push_back(obj);
+    }
+
+    // Schedule a DELETE (or cancel a pending insert of the same key)
+    template <typename T>
+    void remove(const T& obj) {
+        auto& set = setFor<T>();
+        const int id = getPrimaryKey(obj);
+        for (auto it = set.inserts.begin(); it != set.inserts.end(); ++it) {
+            if (getPrimaryKey(*it) == id) {
+                set.inserts.erase(it);
+                return;
+            }
+        }
+        set.tracked.erase(id);
+        set.deletes.insert(id);
+    }
+
+    // Write all pending changes in one transaction.
+    // Returns the number of statements executed (0 = nothing to do, no transaction).
+    size_t flush() {
+        std::vector<Statement> statements;
+        for (auto& set : sets_) set->collectInserts(db_.dialect(), statements);
+        for (auto& set : sets_) set->collectUpdates(db_.dialect(), statements);
+        for (auto it = sets_.rbegin(); it != sets_.rend(); ++it) (*it)->collectDeletes(db_.dialect(), statements);
+
+        if (statements.empty())
+            return 0;
+
+        db_.beginTransaction();
+        try {
+            for (const auto& st : statements)
+                db_.executePrepared(st.sql, st.params);
+            db_.commitTransaction();
+        } catch (...) {
+            db_.rollbackTransaction();
+            throw;
+        }
+
+        for (auto& set : sets_) set->committed();
+        return statements.size();
+    }
+
+    // True if flush() would write anything
+    bool hasChanges() const {
+        for (const auto& set : sets_)
+            if (set->hasChanges()) return true;
+        return false;
+    }
+
+    // Forget every tracked entity and pending change
+    void clear() {
+        sets_.clear();
+        index_.clear();
+    }
+
+private:
+    struct Statement {
+        std::string sql;
+        std::vector<nlohmann::json> params;
+    };
+
+    template <typename T>
+    struct Tracked {
+        T original;
+        T current;
+        bool replace = false;   // removed, then added again: flushed as an upsert of current
+    };
+
+    struct TrackedSetBase {
+        virtual ~TrackedSetBase() = default;
+        virtual void collectInserts(SqlDialect dialect, std::vector<Statement>& out) const = 0;
+        virtual void collectUpdates(SqlDialect dialect, std::vector<Statement>& out) const = 0;
+        virtual void collectDeletes(SqlDialect dialect, std::vector<Statement>& out) const = 0;
+        virtual void committed() = 0;
+        virtual bool hasChanges() const = 0;
+    };
+
+    template <typename T>
+    struct TrackedSet : TrackedSetBase {
+        std::map<int, Tracked<T>> tracked;   // ordered: updates go out in key order
+        std::vector<T> inserts;
+        std::set<int> deletes;
+
+        void collectInserts(SqlDialect dialect, std::vector<Statement>& out) const override {
+            for (const auto& obj : inserts)
+                out.push_back({ buildInsertSQL<T>(dialect), buildInsertParams(obj) });
+        }
+
+        void collectUpdates(SqlDialect dialect, std::vector<Statement>& out) const override {
+            for (const auto& [id, t] : tracked) {
+                if (t.replace) {
+                    out.push_back({ buildUpsertSQL<T>(dialect, 1), buildInsertParams(t.current) });
+                    continue;
+                }
+                auto [sql, params] = buildDirtyUpdate(t.original, t.current, dialect);
+                if (!sql.empty())
+                    out.push_back({ std::move(sql), std::move(params) });
+            }
+        }
+
+        void collectDeletes(SqlDialect dialect, std::vector<Statement>& out) const override {
+            for (int id : deletes)
+                out.push_back({ buildDeleteSQL<T>(dialect), { nlohmann::json(id) } });
+        }
+
+        void committed() override {
+            // Tracked entities are updated in place: references from get() stay valid
+            for (auto& [id, t] : tracked) {
+                t.original = t.current;
+                t.replace = false;
+            }
+            for (auto& obj : inserts) {
+                const int id = getPrimaryKey(obj);
+                tracked.insert_or_assign(id, Tracked<T>{ obj, obj });
+            }
+            inserts.clear();
+            deletes.clear();
+        }
+
+        bool hasChanges() const override {
+            if (!inserts.empty() || !deletes.empty())
+                return true;
+            for (const auto& [id, t] : tracked)
+                if (t.replace || !buildDirtyUpdate(t.original, t.current).first.empty()) return true;
+            return false;
+        }
+    };
+
+    template <typename T>
+    TrackedSet<T>& setFor() {
+        auto it = index_.find(std::type_index(typeid(T)));
+        if (it != index_.end())
+            return static_cast<TrackedSet<T>&>(*it->second);
+        auto set = std::make_unique<TrackedSet<T>>();
+        auto& ref = *set;
+        index_.emplace(std::type_index(typeid(T)), set.get());
+        sets_.push_back(std::move(set));
+        return ref;
+    }
+
+    IDatabase2& db_;
+    std::vector<std::unique_ptr<TrackedSetBase>> sets_;   // in first-use order
+    std::unordered_map<std::type_index, TrackedSetBase*> index_;
+};
@@ -0,0 +1,422 @@
+#pragma once
+
+#include "ORM_v1.h"
+#include "hftools/utils/BoundedMpscQueue.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+//
+// =======================
+// Write-behind persistence over Repository<T>
+// =======================
+//
+// WriteBehindOptions options;
+// options.backpressure = Backpressure::Spill;
+// options.spillPath = "/var/lib/hftools/trades.spill";
+// WriteBehindQueue<Trade> trades(db, options, [](const std::vector<Trade>& rows, AckStatus status, const std::string& error) {
+//     // rows are durable (Committed) or given up on (Failed, error says why)
+// });
+// trades.enqueue(trade);   // matching thread: never waits on the database
+//
+// enqueue() moves the entity into a bounded lock-free MPSC queue and returns.
+// A flusher thread takes up to batchSize entities at a time (waiting at most
+// maxDelay for a batch to fill) and writes them with Repository<T>::insertMany,
+// one multi-row INSERT per chunk in one transaction, then reports them to the
+// ack callback. Failed batches are retried maxRetries times with backoff,
+// then row by row so a single bad row does not take its batch down with it.
+//
+// When the queue is full, backpressure decides:
+//   Block - the producer waits for room
+//   Drop  - the entity is discarded and counted (enqueue returns Dropped)
+//   Spill - the entity is appended to spillPath as a json line and written
+//           later, once the queue has drained. Spilled rows survive a
+//           restart: a new queue on the same path replays them before
+//           anything else. Order between spilled and queued rows is not kept.
+//
+// Spilled rows are written back with upserts, so a replay cut short by a
+// crash can be repeated without failing on the rows it had already written.
+//
+// The ack callback runs on the flusher thread; keep it short. Only the
+// flusher touches db, so give the queue its own IDatabase2 (connection).
+// The destructor writes everything still queued or spilled before returning.
+//
+
+enum class Backpressure { Block, Drop, Spill };
+
+enum class EnqueueResult { Queued, Spilled, Dropped };
+
+enum class AckStatus { Committed, Failed };
+
+struct WriteBehindOptions {
+    size_t capacity = 65536;                        // queued entities, rounded up to a power of two
+    size_t batchSize = 1000;                        // rows per transaction
+    std::chrono::milliseconds maxDelay{ 5 };        // longest a row waits for its batch to fill
+    Backpressure backpressure = Backpressure::Block;
+    std::string spillPath;                          // required for Spill
+    int maxRetries = 3;
+    std::chrono::milliseconds retryBackoff{ 100 };  // doubled on every retry
+};
+
+struct WriteBehindStats {
+    uint64_t enqueued = 0;      // accepted into the queue
+    uint64_t spilled = 0;       // written to the spill file
+    uint64_t inherited = 0;     // read back from an earlier run's spill file
+    uint64_t dropped = 0;
+    uint64_t committed = 0;
+    uint64_t failed = 0;
+    uint64_t batches = 0;
+    uint64_t retries = 0;
+    size_t queueDepth = 0;      // approximate
+};
+
+template<typename T>
+class WriteBehindQueue {
+public:
+    using AckCallback = std::function<void(const std::vector<T>& rows, AckStatus status, const std::string& error)>;
+
+    WriteBehindQueue(IDatabase2& db, WriteBehindOptions options, AckCallback onAck = {})
+        : repo_(db), options_(std::move(options)), onAck_(std::move(onAck)), queue_(options_.capacity) {
+        if (options_.batchSize == 0)
+            throw std::invalid_argument("WriteBehindQueue: batchSize must be at least 1");
+        if (options_.backpressure == Backpressure::Spill && options_.spillPath.empty())
+            throw std::invalid_argument("WriteBehindQueue: Spill backpressure needs a spillPath");
+        if (!options_.spillPath.empty()) {
+            // Rows spilled by a previous run are written before anything else
+            inheritedPending_ = adoptLeftovers();
+        }
+        flusher_ = std::thread([this] { run(); });
+    }
+
+    ~WriteBehindQueue() {
+        stopping_.store(true, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex_);
+            wake_.notify_all();
+            room_.notify_all();
+        }
+        flusher_.join();
+    }
+
+    WriteBehindQueue(const WriteBehindQueue&) = delete;
+    WriteBehindQueue& operator=(const WriteBehindQueue&) = delete;
+
+    // Any thread. Lock-free unless the queue is full and the policy is Block or Spill.
+    EnqueueResult enqueue(T obj) {
+        if (stopping_.load(std::memory_order_acquire))
+            throw std::logic_error("WriteBehindQueue: queue is shutting down");
+
+        if (!queue_.tryPush(std::move(obj))) {
+            switch (options_.backpressure) {
+            case Backpressure::Drop:
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return EnqueueResult::Dropped;
+            case Backpressure::Spill:
+                spill(obj);
+                return EnqueueResult::Spilled;
+            case Backpressure::Block:
+                waitForRoom(obj);
+                break;
+            }
+        }
+        enqueued_.fetch_add(1, std::memory_order_relaxed);
+        if (flusherSleeping_.load(std::memory_order_seq_cst))
+            wake_.notify_one();
+        return EnqueueResult::Queued;
+    }
+
+    // Block until everything enqueued or spilled before the call has been
+    // acknowledged (rows inherited from an earlier run are not waited for)
+    void flush() {
+        const uint64_t target = enqueued_.load(std::memory_order_acquire) + spilled_.load(std::memory_order_acquire);
+        std::unique_lock<std::mutex> lock(wakeMutex_);
+        flushRequested_ = true;
+        wake_.notify_one();
+        done_.wait(lock, [&] {
+            return acked_.load(std::memory_order_acquire) >= target || stopping_.load(std::memory_order_acquire);
+        });
+    }
+
+    WriteBehindStats stats() const {
+        WriteBehindStats s;
+        s.enqueued = enqueued_.load(std::memory_order_relaxed);
+        s.spilled = spilled_.load(std::memory_order_relaxed);
+        s.inherited = inherited_.load(std::memory_order_relaxed);
+        s.dropped = dropped_.load(std::memory_order_relaxed);
+        s.committed = committed_.load(std::memory_order_relaxed);
+        s.failed = failed_.load(std::memory_order_relaxed);
+        s.batches = batches_.load(std::memory_order_relaxed);
+        s.retries = retries_.load(std::memory_order_relaxed);
+        s.queueDepth = queue_.pushed() - queue_.popped();
+        return s;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static bool fileExists(const std::string& path) {
+        std::ifstream in(path);
+        return in.good();
+    }
+
+    std::string replayPath() const { return options_.spillPath + ".replay"; }
+
+    // Where a row came from: the queue, this queue's spill file, or a spill
+    // file left by an earlier run
+    enum class Source { Queue, Spill, Inherited };
+
+    // Constructor only, before anyone can spill: gather an earlier run's
+    // spill files into the replay file. True if there is anything to replay.
+    bool adoptLeftovers() {
+        const bool replayLeft = fileExists(replayPath());
+        if (!fileExists(options_.spillPath))
+            return replayLeft;
+        if (!replayLeft) {
+            if (std::rename(options_.spillPath.c_str(), replayPath().c_str()) != 0)
+                throw std::runtime_error("WriteBehindQueue: cannot rename spill file " + options_.spillPath);
+            return true;
+        }
+        // A replay was cut short, and rows were spilled after it: replay both.
+        // The newline ends a torn last line; empty lines are skipped.
+        {
+            std::ifstream in(options_.spillPath);
+            std::ofstream out(replayPath(), std::ios::app);
+            out << '\n' << in.rdbuf();
+            out.flush();
+            if (!out)
+                throw std::runtime_error("WriteBehindQueue: cannot append to " + replayPath());
+        }
+        std::remove(options_.spillPath.c_str());
+        return true;
+    }
+
+    void spill(const T& obj) {
+        const std::string line = autoToJson(obj).dump();
+        std::lock_guard<std::mutex> lock(spillMutex_);
+        if (!spillOut_.is_open()) {
+            spillOut_.open(options_.spillPath, std::ios::app);
+            if (!spillOut_)
+                throw std::runtime_error("WriteBehindQueue: cannot open spill file " + options_.spillPath);
+        }
+        spillOut_ << line << '\n';
+        spillOut_.flush();
+        if (!spillOut_)
+            throw std::runtime_error("WriteBehindQueue: cannot write spill file " + options_.spillPath);
+        spilled_.fetch_add(1, std::memory_order_relaxed);
+        spillPending_ = true;
+    }
+
+    void waitForRoom(T& obj) {
+        std::unique_lock<std::mutex> lock(wakeMutex_);
+        ++blockedProducers_;
+        while (!queue_.tryPush(std::move(obj))) {
+            if (stopping_.load(std::memory_order_acquire)) {
+                --blockedProducers_;
+                throw std::logic_error("WriteBehindQueue: queue is shutting down");
+            }
+            wake_.notify_one();
+            room_.wait_for(lock, std::chrono::milliseconds(1));
+        }
+        --blockedProducers_;
+    }
+
+    void run() {
+        if (inheritedPending_)
+            replayFile(Source::Inherited);
+
+        std::vector<T> batch;
+        batch.reserve(options_.batchSize);
+        while (true) {
+            drainInto(batch);
+            if (batch.empty()) {
+                if (replaySpill()) continue;
+                flushRequested_.store(false, std::memory_order_release);   // everything asked for is written
+                if (stopping_.load(std::memory_order_acquire)) return;
+                idle(Clock::now() + options_.maxDelay);
+                continue;
+            }
+
+            // Give the batch up to maxDelay to fill, unless someone is waiting on it
+            const auto deadline = Clock::now() + options_.maxDelay;
+            while (batch.size() < options_.batchSize && !stopping_.load(std::memory_order_acquire) &&
+                   !flushRequested_.load(std::memory_order_acquire) && Clock::now() < deadline) {
+                idle(deadline);
+                drainInto(batch);
+            }
+
+            write(batch, Source::Queue);
+            batch.clear();
+        }
+    }
+
+    void drainInto(std::vector<T>& batch) {
+        const size_t before = batch.size();
+        T obj;
+        while (batch.size() < options_.batchSize && queue_.tryPop(obj))
+            batch.push_back(std::move(obj));
+        if (batch.size() != before && blockedProducers_.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(wakeMutex_);
+            room_.notify_all();
+        }
+    }
+
+    void idle(Clock::time_point until) {
+        std::unique_lock<std::mutex> lock(wakeMutex_);
+        flusherSleeping_.store(true, std::memory_order_seq_cst);
+        // Recheck after announcing the sleep, so a producer that missed it is not left waiting
+        if (queue_.empty() && !stopping_.load(std::memory_order_acquire))
+            wake_.wait_until(lock, until);
+        flusherSleeping_.store(false, std::memory_order_relaxed);
+    }
+
+    // Write this queue's spill file back; true if anything was read
+    bool replaySpill() {
+        if (options_.spillPath.empty())
+            return false;
+        {
+            std::lock_guard<std::mutex> lock(spillMutex_);
+            if (!spillPending_)
+                return false;
+            // New spills go to a fresh file while this one is replayed
+            if (spillOut_.is_open()) spillOut_.close();
+            if (!fileExists(replayPath()))
+                std::rename(options_.spillPath.c_str(), replayPath().c_str());
+            spillPending_ = false;
+        }
+
+        const bool any = replayFile(Source::Spill);
+
+        std::lock_guard<std::mutex> lock(spillMutex_);
+        spillPending_ = spillPending_ || fileExists(options_.spillPath);
+        return any;
+    }
+
+    // Write the replay file in batches, then delete it; true if anything was read
+    bool replayFile(Source source) {
+        std::ifstream in(replayPath());
+        std::vector<T> batch;
+        batch.reserve(options_.batchSize);
+        std::string line;
+        bool any = false;
+        while (std::getline(in, line)) {
+            if (line.empty()) continue;
+            try {
+                batch.push_back(autoFromJson<T>(nlohmann::json::parse(line)));
+            } catch (const std::exception&) {
+                continue;   // torn last line from a crash
+            }
+            any = true;
+            if (batch.size() == options_.batchSize) {
+                write(batch, source);
+                batch.clear();
+            }
+        }
+        if (!batch.empty()) write(batch, source);
+        in.close();
+        std::remove(replayPath().c_str());
+        return any;
+    }
+
+    // Queued rows are inserted; replayed rows are upserted, since some of them
+    // may have been written before a crash
+    void write(const std::vector<T>& batch, Source source) {
+        const auto store = [&](const std::vector<T>& rows) {
+            if (source == Source::Queue)
+                repo_.insertMany(rows);
+            else
+                repo_.upsertMany(rows);
+        };
+        batches_.fetch_add(1, std::memory_order_relaxed);
+        std::string error;
+        auto backoff = options_.retryBackoff;
+        for (int attempt = 0; attempt <= options_.maxRetries; ++attempt) {
+            if (attempt > 0) {
+                retries_.fetch_add(1, std::memory_order_relaxed);
+                std::this_thread::sleep_for(backoff);
+                backoff *= 2;
+            }
+            try {
+                store(batch);
+                acknowledge(batch, AckStatus::Committed, {}, source);
+                return;
+            } catch (const std::exception& e) {
+                error = e.what();
+            }
+        }
+
+        if (batch.size() == 1) {
+            acknowledge(batch, AckStatus::Failed, error, source);
+            return;
+        }
+        // Isolate the rows that cannot be written
+        for (const T& obj : batch) {
+            std::vector<T> single{ obj };
+            try {
+                store(single);
+                acknowledge(single, AckStatus::Committed, {}, source);
+            } catch (const std::exception& e) {
+                acknowledge(single, AckStatus::Failed, e.what(), source);
+            }
+        }
+    }
+
+    void acknowledge(const std::vector<T>& rows, AckStatus status, const std::string& error, Source source) {
+        (status == AckStatus::Committed ? committed_ : failed_).fetch_add(rows.size(), std::memory_order_relaxed);
+        if (onAck_) {
+            try {
+                onAck_(rows, status, error);
+            } catch (...) {
+            }
+        }
+        // flush() waits for this queue's own rows only
+        if (source == Source::Inherited) {
+            inherited_.fetch_add(rows.size(), std::memory_order_relaxed);
+            return;
+        }
+        acked_.fetch_add(rows.size(), std::memory_order_release);
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        done_.notify_all();
+    }
+
+    Repository<T> repo_;
+    const WriteBehindOptions options_;
+    const AckCallback onAck_;
+    hftools::utils::BoundedMpscQueue<T> queue_;
+
+    std::mutex wakeMutex_;
+    std::condition_variable wake_;      // flusher
+    std::condition_variable room_;      // producers blocked on a full queue
+    std::condition_variable done_;      // flush()
+    std::atomic<bool> flusherSleeping_{ false };
+    std::atomic<bool> flushRequested_{ false };
+    std::atomic<bool> stopping_{ false };
+    std::atomic<int> blockedProducers_{ 0 };
+
+    std::mutex spillMutex_;
+    std::ofstream spillOut_;
+    bool spillPending_ = false;
+    bool inheritedPending_ = false;     // set before the flusher starts
+
+    std::atomic<uint64_t> enqueued_{ 0 };
+    std::atomic<uint64_t> spilled_{ 0 };
+    std::atomic<uint64_t> inherited_{ 0 };
+    std::atomic<uint64_t> dropped_{ 0 };
+    std::atomic<uint64_t> committed_{ 0 };
+    std::atomic<uint64_t> failed_{ 0 };
+    std::atomic<uint64_t> batches_{ 0 };
+    std::atomic<uint64_t> retries_{ 0 };
+    std::atomic<uint64_t> acked_{ 0 };
+
+    std::thread flusher_;
+};
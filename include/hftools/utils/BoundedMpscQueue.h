@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+namespace hftools {
+namespace utils {
+
+/**
+ * @brief Bounded lock-free queue: any number of producers, one consumer
+ *
+ * A ring of slots, each with a sequence number telling whose turn it is
+ * (Vyukov's bounded queue). Producers claim a slot with one compare-and-swap
+ * on the tail and publish it with a release store; the consumer never
+ * touches the tail. Nothing allocates after construction, and a full queue
+ * fails tryPush() instead of blocking, leaving the policy (wait, drop,
+ * spill) to the caller.
+ *
+ * T must be default constructible and move assignable.
+ */
+template <typename T>
+class BoundedMpscQueue {
+public:
+    /**
+     * @param capacity Slots, rounded up to a power of two (at least 2)
+     * @throws std::invalid_argument for a zero capacity
+     */
+    explicit BoundedMpscQueue(size_t capacity) {
+        if (capacity == 0) {
+            throw std::invalid_argument("BoundedMpscQueue: capacity must be at least 1");
+        }
+        size_t n = 2;
+        while (n < capacity) n <<= 1;
+        mask_ = n - 1;
+        slots_ = std::make_unique<Slot[]>(n);
+        for (size_t i = 0; i < n; ++i) slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    BoundedMpscQueue(const BoundedMpscQueue&) = delete;
+    BoundedMpscQueue& operator=(const BoundedMpscQueue&) = delete;
+
+    /**
+     * @brief Any thread. Returns false, leaving value untouched, when the queue is full
+     */
+    bool tryPush(T&& value) {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots_[pos & mask_];
+            const size_t seq = slot->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+        slot->value = std::move(value);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Consumer thread only. Returns false when nothing is ready
+     */
+    bool tryPop(T& out) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        Slot& slot = slots_[head & mask_];
+        if (slot.sequence.load(std::memory_order_acquire) != head + 1) return false;
+        out = std::move(slot.value);
+        slot.sequence.store(head + mask_ + 1, std::memory_order_release);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Consumer thread only: whether tryPop() would fail
+     */
+    bool empty() const {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        return slots_[head & mask_].sequence.load(std::memory_order_acquire) != head + 1;
+    }
+
+    /**
+     * @brief Slots claimed by producers so far; with popped(), a cheap depth estimate
+     */
+    size_t pushed() const { return tail_.load(std::memory_order_acquire); }
+    size_t popped() const { return head_.load(std::memory_order_acquire); }
+
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence{ 0 };
+        T value{};
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t mask_ = 0;
+    alignas(64) std::atomic<size_t> tail_{ 0 };
+    alignas(64) std::atomic<size_t> head_{ 0 };
+};
+
+} // namespace utils
+} // namespace hftools
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace hftools {
+namespace utils {
+
+/**
+ * @brief High Dynamic Range histogram of integer values (typically latencies in ns)
+ *
+ * Values are counted in log-linear buckets: every value between lowest and
+ * highest is kept with a relative error below 10^-significantDigits, in a
+ * fixed array of counters. Recording is O(1) and allocation-free, so one
+ * histogram per thread can sit on the measured path; merge them with add().
+ *
+ * Same layout and percentile semantics as Gil Tene's HdrHistogram, so
+ * results compare with wrk2, HdrHistogram_c and friends.
+ *
+ * Not thread-safe.
+ */
+class HdrHistogram {
+public:
+    /**
+     * @param lowest Smallest distinguishable value (>= 1)
+     * @param highest Largest trackable value (>= 2 * lowest); larger values are clamped to it
+     * @param significantDigits Precision, 1 to 5
+     * @throws std::invalid_argument for an invalid range or precision
+     */
+    HdrHistogram(int64_t lowest = 1, int64_t highest = 3'600'000'000'000, int significantDigits = 3);
+
+    void record(int64_t value, int64_t count = 1);
+
+    /**
+     * @brief Record a value measured by a loop that expected one sample every expectedInterval
+     *
+     * When value exceeds the interval, the samples the stalled loop failed to
+     * issue are recorded too (value - interval, value - 2 * interval, ...),
+     * correcting for coordinated omission.
+     */
+    void recordCorrected(int64_t value, int64_t expectedInterval);
+
+    /**
+     * @brief Add the counts of another histogram
+     * @throws std::invalid_argument if the two were built with different parameters
+     */
+    void add(const HdrHistogram& other);
+
+    void reset();
+
+    int64_t count() const { return totalCount_; }
+    int64_t min() const;
+    int64_t max() const;
+    double mean() const;
+
+    /**
+     * @brief Value at or below which percentile % of the recorded values fall
+     *
+     * Reported as the highest value equivalent to the bucket (within the
+     * configured precision); 0 when empty.
+     */
+    int64_t valueAtPercentile(double percentile) const;
+
+    // Bucket layout, for recorders that keep their own (e.g. atomic) counters
+    // and fold them into a histogram built with the same parameters
+    size_t bucketCount() const { return counts_.size(); }
+    size_t bucketIndex(int64_t value) const;          // value is clamped like record()
+    void addToBucket(size_t index, int64_t count);
+
+private:
+    size_t indexOf(int64_t value) const;
+    int64_t valueFromIndex(size_t index) const;
+    int64_t lowestEquivalentValue(int64_t value) const;
+    int64_t highestEquivalentValue(int64_t value) const;
+
+    int64_t lowest_;
+    int64_t highest_;
+    int significantDigits_;
+    int unitMagnitude_;
+    int subBucketHalfCountMagnitude_;
+    int64_t subBucketCount_;
+    int64_t subBucketHalfCount_;
+    int64_t subBucketMask_;
+
+    std::vector<int64_t> counts_;
+    int64_t totalCount_ = 0;
+    int64_t minValue_;
+    int64_t maxValue_ = 0;
+};
+
+} // namespace utils
+} // namespace hftools
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hftools {
+namespace utils {
+
+/**
+ * @brief Normalized form of a SQL statement, used to group executions
+ *
+ * Literals and parameters ($1, ?, @p, :name) become ?, comments are dropped,
+ * whitespace is collapsed, and value lists collapse to one element:
+ * "SELECT * FROM t WHERE id IN (1, 2, 3)" and "... IN ($1, $2)" both give
+ * "SELECT * FROM t WHERE id IN (?)"; multi-row VALUES give one row.
+ */
+std::string fingerprintSql(std::string_view sql);
+
+/**
+ * @brief One statement execution, as reported to QueryInstrumentation
+ */
+struct StatementEvent {
+    std::string_view backend;                  // "PostgreSQL", "Sybase", ...
+    std::string_view sql;                      // as sent
+    std::string_view fingerprint;              // fingerprintSql(sql)
+    const std::vector<std::string>* params = nullptr;   // bound parameters, if any
+    std::chrono::nanoseconds duration{ 0 };    // onFinish only
+    int64_t rows = 0;                          // returned, or affected by a command
+    int64_t bytes = 0;                         // result payload (field text)
+    bool failed = false;
+};
+
+/**
+ * @brief Hooks called around every statement of an instrumented Connection or db::IDatabase
+ *
+ * Called on the executing thread, so implementations must be thread-safe
+ * and cheap. Exceptions they throw are swallowed. Events only live for the
+ * duration of the call.
+ */
+class QueryInstrumentation {
+public:
+    virtual ~QueryInstrumentation() = default;
+
+    virtual void onStart(const StatementEvent& /*event*/) {}
+    virtual void onFinish(const StatementEvent& /*event*/) {}
+
+    /**
+     * @brief Time a caller spent waiting for a pooled connection
+     */
+    virtual void onPoolWait(std::string_view /*pool*/, std::chrono::nanoseconds /*waited*/) {}
+};
+
+/**
+ * @brief Forwards every hook to several instrumentations, in order
+ */
+class InstrumentationFanout : public QueryInstrumentation {
+public:
+    explicit InstrumentationFanout(std::vector<std::shared_ptr<QueryInstrumentation>> targets);
+
+    void onStart(const StatementEvent& event) override;
+    void onFinish(const StatementEvent& event) override;
+    void onPoolWait(std::string_view pool, std::chrono::nanoseconds waited) override;
+
+private:
+    std::vector<std::shared_ptr<QueryInstrumentation>> targets_;
+};
+
+/**
+ * @brief Instrumentation picked up by connections and databases created from now on
+ *
+ * Null (the default) means no instrumentation: statements then pay a
+ * pointer test and nothing else.
+ */
+void setDefaultInstrumentation(std::shared_ptr<QueryInstrumentation> instrumentation);
+std::shared_ptr<QueryInstrumentation> defaultInstrumentation();
+
+/**
+ * @brief Reports one statement: onStart on construction, onFinish on finish() or destruction
+ *
+ * Destroyed without finish() (an exception unwound the driver code), the
+ * statement is reported as failed. With a null instrumentation it does
+ * nothing, not even read the clock.
+ */
+class StatementTrace {
+public:
+    StatementTrace(QueryInstrumentation* instrumentation, std::string_view backend, std::string_view sql,
+                   const std::vector<std::string>* params = nullptr);
+    ~StatementTrace();
+
+    StatementTrace(const StatementTrace&) = delete;
+    StatementTrace& operator=(const StatementTrace&) = delete;
+
+    /**
+     * @brief Whether anyone is listening; skip computing rows / bytes otherwise
+     */
+    bool active() const { return instrumentation_ != nullptr; }
+
+    void finish(int64_t rows, int64_t bytes = 0);
+
+private:
+    void report(bool failed);
+
+    QueryInstrumentation* instrumentation_;
+    std::string fingerprint_;
+    StatementEvent event_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace utils
+} // namespace hftools
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+/**
+ * Levels below HFTOOLS_LOG_MIN_LEVEL are compiled out of the HFTOOLS_LOG_*
+ * macros, arguments included (0 trace, 1 debug, 2 info, 3 warn, 4 error, 5 off).
+ */
+#ifndef HFTOOLS_LOG_MIN_LEVEL
+#define HFTOOLS_LOG_MIN_LEVEL 0
+#endif
+
+namespace hftools {
+namespace utils {
+
+enum class LogLevel { Trace = 0, Debug = 1, Info = 2, Warn = 3, Error = 4, Off = 5 };
+
+const char* logLevelName(LogLevel level);
+
+/**
+ * @throws std::invalid_argument for anything but trace, debug, info, warn, error or off
+ */
+LogLevel parseLogLevel(const std::string& name);
+
+/**
+ * @brief Mask credentials in connection strings and SQL
+ *
+ * Values of password / pwd / passwd / secret keys ("password=x",
+ * "Password = 'x';"), the password of URIs (postgresql://user:x@host) and
+ * string literals after PASSWORD (ALTER USER ... PASSWORD 'x') become ***.
+ */
+std::string redactCredentials(std::string_view text);
+
+struct LogRecord {
+    LogLevel level = LogLevel::Info;
+    std::chrono::system_clock::time_point time;
+    std::string message;        // already redacted when it reaches a sink
+};
+
+/**
+ * @brief Destination of log records, called from the logger thread only
+ */
+class LogSink {
+public:
+    virtual ~LogSink() = default;
+    virtual void write(const LogRecord& record) = 0;
+
+    /**
+     * @brief Called once the queue is drained, after a batch of writes
+     */
+    virtual void flush() {}
+};
+
+/**
+ * @brief "2024-01-28T10:30:00.123456Z INFO  message" lines on a stream (std::clog by default)
+ */
+class StreamSink : public LogSink {
+public:
+    explicit StreamSink(std::ostream& out);
+
+    void write(const LogRecord& record) override;
+    void flush() override;
+
+private:
+    std::ostream& out_;
+};
+
+/**
+ * @brief Process-wide asynchronous logger
+ *
+ * log() formats nothing and takes no lock: it moves the message into a
+ * bounded lock-free ring buffer and returns. A background thread drains the
+ * buffer, redacts credentials and hands the records to the sink, so the
+ * calling thread never waits on I/O. When the buffer is full the message is
+ * dropped and counted; the next record written reports how many were lost.
+ *
+ * Use the HFTOOLS_LOG_* macros rather than log(): they skip formatting when
+ * the level is disabled at run time and compile to nothing below
+ * HFTOOLS_LOG_MIN_LEVEL.
+ *
+ * The queue is drained at exit; call flush() to wait for it earlier.
+ */
+class Logger {
+public:
+    static Logger& instance();
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    void setLevel(LogLevel level);
+    LogLevel level() const;
+    bool enabled(LogLevel level) const;
+
+    /**
+     * @brief Replace the sink (null discards everything)
+     */
+    void setSink(std::shared_ptr<LogSink> sink);
+
+    void log(LogLevel level, std::string message);
+
+    /**
+     * @brief Block until everything logged so far has reached the sink
+     */
+    void flush();
+
+    /**
+     * @brief Messages lost to a full buffer since start
+     */
+    uint64_t dropped() const;
+
+private:
+    Logger();
+    ~Logger();
+
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+/**
+ * @brief Collects one message for the HFTOOLS_LOG_* macros and logs it on destruction
+ */
+class LogLine {
+public:
+    explicit LogLine(LogLevel level) : level_(level) {}
+    ~LogLine() { Logger::instance().log(level_, stream_.str()); }
+
+    LogLine(const LogLine&) = delete;
+    LogLine& operator=(const LogLine&) = delete;
+
+    std::ostream& stream() { return stream_; }
+
+private:
+    LogLevel level_;
+    std::ostringstream stream_;
+};
+
+} // namespace utils
+} // namespace hftools
+
+#define HFTOOLS_LOG(lvl, expr)                                                              \
+    do {                                                                                    \
+        if constexpr (static_cast<int>(lvl) >= HFTOOLS_LOG_MIN_LEVEL) {                     \
+            if (::hftools::utils::Logger::instance().enabled(lvl)) {                        \
+                ::hftools::utils::LogLine hftoolsLogLine_(lvl);                             \
+                hftoolsLogLine_.stream() << expr;                                           \
+            }                                                                               \
+        }                                                                                   \
+    } while (0)
+
+#define HFTOOLS_LOG_TRACE(expr) HFTOOLS_LOG(::hftools::utils::LogLevel::Trace, expr)
+#define HFTOOLS_LOG_DEBUG(expr) HFTOOLS_LOG(::hftools::utils::LogLevel::Debug, expr)
+#define HFTOOLS_LOG_INFO(expr)  HFTOOLS_LOG(::hftools::utils::LogLevel::Info, expr)
+#define HFTOOLS_LOG_WARN(expr)  HFTOOLS_LOG(::hftools::utils::LogLevel::Warn, expr)
+#define HFTOOLS_LOG_ERROR(expr) HFTOOLS_LOG(::hftools::utils::LogLevel::Error, expr)
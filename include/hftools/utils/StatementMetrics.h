@@ -0,0 +1,105 @@
+#pragma once
+
+#include "Instrumentation.h"
+#include "HdrHistogram.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace hftools {
+namespace utils {
+
+/**
+ * @brief Default QueryInstrumentation: latency histograms and totals per statement fingerprint
+ *
+ * Every thread records into its own shard of atomic counters, written only
+ * by that thread (relaxed loads and stores, no read-modify-write), so the
+ * hot path takes no lock and shares no cache line with other threads. A
+ * shard's mutex is only taken the first time a thread sees a fingerprint
+ * and while a snapshot walks the shard. Snapshots merge the shards; they
+ * may miss statements finishing concurrently, and can only hold up a
+ * thread running a fingerprint for the first time.
+ *
+ * Latencies are kept from 1 us to 1 h at two significant digits, about
+ * 27 KB of counters per fingerprint and shard. When a thread exits, its
+ * shard (counts included) is handed to the next thread that records, so
+ * memory follows the number of threads running at once, not the number of
+ * threads ever started.
+ *
+ * @code
+ * auto metrics = std::make_shared<StatementMetrics>();
+ * utils::setDefaultInstrumentation(metrics);     // before opening connections
+ * ...
+ * std::cout << metrics->toPrometheus();          // or metrics->toJson().dump(2)
+ * @endcode
+ */
+class StatementMetrics : public QueryInstrumentation {
+public:
+    StatementMetrics();
+    ~StatementMetrics() override;
+
+    StatementMetrics(const StatementMetrics&) = delete;
+    StatementMetrics& operator=(const StatementMetrics&) = delete;
+
+    void onStart(const StatementEvent& event) override;
+    void onFinish(const StatementEvent& event) override;
+    void onPoolWait(std::string_view pool, std::chrono::nanoseconds waited) override;
+
+    struct StatementSummary {
+        std::string backend;
+        std::string fingerprint;
+        int64_t count = 0;          // successful executions
+        int64_t errors = 0;
+        int64_t rows = 0;
+        int64_t bytes = 0;
+        int64_t totalNanos = 0;     // successful and failed
+        int64_t successNanos = 0;   // successful executions only, the sum matching latency
+        HdrHistogram latency;       // ns, successful executions
+    };
+
+    struct PoolSummary {
+        std::string pool;
+        int64_t waits = 0;
+        int64_t totalNanos = 0;
+        HdrHistogram wait;          // ns
+    };
+
+    /**
+     * @brief Merged view of all threads, by total time spent, highest first
+     */
+    std::vector<StatementSummary> statements() const;
+    std::vector<PoolSummary> pools() const;
+
+    /**
+     * @brief Statements started and not yet finished
+     */
+    int64_t inFlight() const;
+
+    /**
+     * @brief {"in_flight", "statements": [...], "pools": [...]}, durations in microseconds
+     */
+    nlohmann::json toJson() const;
+
+    /**
+     * @brief Prometheus text exposition format (summaries in seconds, counters)
+     */
+    std::string toPrometheus() const;
+
+private:
+    struct Series;
+    struct Shard;
+    struct Registry;
+
+    Shard& localShard();
+    static HdrHistogram makeHistogram();
+
+    const uint64_t id_;                         // tells instances apart in the thread-local shard cache
+    const HdrHistogram layout_;                 // bucket layout shared by all series
+    std::shared_ptr<Registry> registry_;        // shared with exiting threads returning their shard
+};
+
+} // namespace utils
+} // namespace hftools
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "Instrumentation.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace hftools {
+namespace utils {
+
+/**
+ * @brief Per-fingerprint statement statistics and a sample of the slowest executions
+ *
+ * A QueryInstrumentation: install it with setDefaultInstrumentation() (or
+ * setInstrumentation() on one connection / database) to enable it. Left
+ * uninstalled, statements pay a null pointer test and nothing else.
+ *
+ * Totals are kept in 16 mutex-striped maps keyed by fingerprint, so threads
+ * running different statements rarely meet on a lock. The slow sample holds
+ * the slowestSamples longest executions at or above slowThreshold, with
+ * their SQL and bound parameters; a statement faster than the current
+ * sample minimum is rejected on a relaxed atomic read, without locking.
+ *
+ * @code
+ * auto stats = std::make_shared<StatementStats>(10, std::chrono::milliseconds(5));
+ * utils::setDefaultInstrumentation(stats);
+ * ...
+ * stats->print(std::cout, 20);
+ * @endcode
+ */
+class StatementStats : public QueryInstrumentation {
+public:
+    /**
+     * @param slowestSamples Executions kept in the slow sample (0 disables it)
+     * @param slowThreshold Shortest execution considered for the sample
+     */
+    explicit StatementStats(size_t slowestSamples = 20,
+                            std::chrono::nanoseconds slowThreshold = std::chrono::nanoseconds::zero());
+
+    StatementStats(const StatementStats&) = delete;
+    StatementStats& operator=(const StatementStats&) = delete;
+
+    void onFinish(const StatementEvent& event) override;
+
+    struct FingerprintStats {
+        std::string backend;
+        std::string fingerprint;
+        int64_t calls = 0;
+        int64_t errors = 0;
+        int64_t rows = 0;
+        int64_t totalNanos = 0;
+        int64_t maxNanos = 0;
+    };
+
+    struct SlowStatement {
+        std::string backend;
+        std::string fingerprint;
+        std::string sql;                        // truncated to 4 KB
+        std::vector<std::string> params;        // each truncated to 256 bytes
+        int64_t nanos = 0;
+        int64_t rows = 0;
+        bool failed = false;
+        std::chrono::system_clock::time_point finishedAt;
+    };
+
+    /**
+     * @brief All fingerprints, by total time spent, highest first
+     */
+    std::vector<FingerprintStats> fingerprints() const;
+
+    /**
+     * @brief The slow sample, slowest first
+     */
+    std::vector<SlowStatement> slowest() const;
+
+    /**
+     * @brief Forget everything recorded so far
+     */
+    void reset();
+
+    /**
+     * @brief {"fingerprints": [...], "slowest": [...]}, durations in microseconds
+     */
+    nlohmann::json toJson() const;
+
+    /**
+     * @brief Text report: the top fingerprints by total time, then the slow sample
+     */
+    void print(std::ostream& out, size_t topFingerprints = 20) const;
+
+private:
+    struct Stripe {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, FingerprintStats> entries;
+    };
+
+    void sample(const StatementEvent& event, int64_t nanos);
+
+    static constexpr size_t kStripes = 16;
+    std::array<Stripe, kStripes> stripes_;
+
+    const size_t slowestSamples_;
+    const int64_t slowThresholdNanos_;
+    std::atomic<int64_t> admitNanos_;           // fastest duration that can still enter the sample
+    mutable std::mutex slowMutex_;
+    std::vector<SlowStatement> slow_;           // min-heap on nanos
+};
+
+/**
+ * @brief Calls a function every interval on a background thread until destroyed
+ *
+ * Used to dump StatementStats / StatementMetrics periodically; exceptions
+ * thrown by the function are swallowed.
+ */
+class PeriodicTask {
+public:
+    PeriodicTask(std::chrono::milliseconds interval, std::function<void()> task);
+    ~PeriodicTask();
+
+    PeriodicTask(const PeriodicTask&) = delete;
+    PeriodicTask& operator=(const PeriodicTask&) = delete;
+
+private:
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+} // namespace utils
+} // namespace hftools
@@ -1,12 +1,14 @@
 #include "hftools/database/Connection.h"
 #include "hftools/database/ResultSet.h"
-#include <iostream>
+#include "hftools/utils/Logger.h"
+#include <stdexcept>
 
 namespace hftools {
 namespace database {
 
 Connection::Connection(const std::string& dbType, const std::string& connectionString)
-    : dbType_(dbType), connectionString_(connectionString), connected_(false) {
+    : dbType_(dbType), connectionString_(connectionString), connected_(false),
+      instrumentation_(utils::defaultInstrumentation()) {
 }
 
 Connection::~Connection() {
@@ -16,27 +18,67 @@ Connection::~Connection() {
 }
 
 std::shared_ptr<ResultSet> Connection::execQuery(const std::string& query) {
-    std::cout << "[" << dbType_ << "] Executing query: " << query << std::endl;
+    utils::StatementTrace trace(instrumentation_.get(), dbType_, query);
+    HFTOOLS_LOG_DEBUG("[" << dbType_ << "] Executing query: " << query);
     
     // Mock implementation - return empty result set
     auto rs = std::make_shared<ResultSet>();
+    trace.finish(0);
     return rs;
 }
 
 int Connection::execCommand(const std::string& command) {
-    std::cout << "[" << dbType_ << "] Executing command: " << command << std::endl;
+    utils::StatementTrace trace(instrumentation_.get(), dbType_, command);
+    HFTOOLS_LOG_DEBUG("[" << dbType_ << "] Executing command: " << command);
     
     // Mock implementation - return 1 row affected
+    trace.finish(1);
     return 1;
 }
 
+int Connection::bulkInsert(const std::string& table, const ResultSet& rows) {
+    const std::vector<std::string> columns = rows.getColumnNames();
+    if (columns.empty()) {
+        throw std::invalid_argument("bulkInsert: result set has no columns");
+    }
+
+    std::string prefix = "INSERT INTO " + table + " (";
+    for (size_t c = 0; c < columns.size(); ++c) {
+        prefix += (c ? ", " : "") + columns[c];
+    }
+    prefix += ") VALUES (";
+
+    int inserted = 0;
+    std::string sql;
+    for (int r = 0; r < rows.getRowCount(); ++r) {
+        sql = prefix;
+        for (int c = 0; c < static_cast<int>(columns.size()); ++c) {
+            if (c) sql += ", ";
+            std::string_view value = rows.getFieldView(r, c);
+            if (value.data() == nullptr) {
+                sql += "NULL";
+                continue;
+            }
+            sql += '\'';
+            for (char ch : value) {
+                if (ch == '\'') sql += '\'';
+                sql += ch;
+            }
+            sql += '\'';
+        }
+        sql += ')';
+        inserted += execCommand(sql);
+    }
+    return inserted;
+}
+
 bool Connection::isConnected() const {
     return connected_;
 }
 
 void Connection::close() {
     if (connected_) {
-        std::cout << "[" << dbType_ << "] Closing connection" << std::endl;
+        HFTOOLS_LOG_INFO("[" << dbType_ << "] Closing connection");
         connected_ = false;
     }
 }
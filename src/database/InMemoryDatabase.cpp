@@ -0,0 +1,1332 @@
+#include "hftools/database/InMemoryDatabase.h"
+#include "hftools/database/ResultSet.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <cstdlib>
+#include <limits>
+#include <map>
+#include <optional>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+namespace hftools {
+namespace database {
+
+using nlohmann::json;
+
+namespace {
+
+using Row = std::vector<json>;
+
+std::string lower(std::string_view s) {
+    std::string out(s);
+    for (auto& c : out) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return out;
+}
+
+bool iequals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i])))
+            return false;
+    }
+    return true;
+}
+
+// =============================================================================
+// Values
+// =============================================================================
+
+std::optional<int64_t> parseInt(std::string_view s) {
+    int64_t v = 0;
+    auto res = std::from_chars(s.data(), s.data() + s.size(), v);
+    if (res.ec != std::errc() || res.ptr != s.data() + s.size() || s.empty()) return std::nullopt;
+    return v;
+}
+
+std::optional<double> parseDouble(const std::string& s) {
+    if (s.empty()) return std::nullopt;
+    char* end = nullptr;
+    double v = std::strtod(s.c_str(), &end);
+    if (*end != '\0') return std::nullopt;
+    return v;
+}
+
+std::optional<double> toNumber(const json& v) {
+    if (v.is_number()) return v.get<double>();
+    if (v.is_boolean()) return v.get<bool>() ? 1.0 : 0.0;
+    if (v.is_string()) return parseDouble(v.get_ref<const std::string&>());
+    return std::nullopt;
+}
+
+std::optional<int64_t> toKey(const json& v) {
+    if (v.is_number_integer()) return v.get<int64_t>();
+    if (v.is_number_float()) {
+        double d = v.get<double>();
+        if (d == static_cast<double>(static_cast<int64_t>(d))) return static_cast<int64_t>(d);
+        return std::nullopt;
+    }
+    if (v.is_string()) return parseInt(v.get_ref<const std::string&>());
+    return std::nullopt;
+}
+
+// -1 / 0 / 1, or nothing when SQL would say UNKNOWN (a NULL is involved)
+std::optional<int> compareValues(const json& a, const json& b) {
+    if (a.is_null() || b.is_null()) return std::nullopt;
+    auto sign = [](auto x, auto y) { return (x > y) - (x < y); };
+    if (a.is_number_integer() && b.is_number_integer())
+        return sign(a.get<int64_t>(), b.get<int64_t>());
+    if (a.is_string() && b.is_string())
+        return sign(a.get_ref<const std::string&>().compare(b.get_ref<const std::string&>()), 0);
+    // Parameters often arrive as text ("42") for numeric columns
+    auto x = toNumber(a);
+    auto y = toNumber(b);
+    if (x && y) return sign(*x, *y);
+    return sign(inMemoryText(a).compare(inMemoryText(b)), 0);
+}
+
+json coerce(const json& v, const InMemoryColumn& column) {
+    if (v.is_null()) return v;
+    auto invalid = [&]() -> json {
+        throw std::runtime_error("invalid value for column \"" + column.name + "\": " + inMemoryText(v));
+    };
+
+    switch (column.type) {
+    case InMemoryType::Int:
+        if (v.is_number_integer()) return json(v.get<int64_t>());
+        if (v.is_boolean()) return json(static_cast<int64_t>(v.get<bool>()));
+        if (auto k = toKey(v)) return json(*k);
+        return invalid();
+    case InMemoryType::Double:
+        if (auto d = toNumber(v)) return json(*d);
+        return invalid();
+    case InMemoryType::Text:
+        return v.is_string() ? v : json(inMemoryText(v));
+    case InMemoryType::Bool:
+        if (v.is_boolean()) return v;
+        if (v.is_number()) return json(v.get<double>() != 0);
+        if (v.is_string()) {
+            const auto& s = v.get_ref<const std::string&>();
+            if (iequals(s, "t") || iequals(s, "true") || s == "1") return json(true);
+            if (iequals(s, "f") || iequals(s, "false") || s == "0") return json(false);
+        }
+        return invalid();
+    }
+    return v;
+}
+
+// Elements of an array parameter: a json array or the text form {1,2,3}
+std::vector<json> arrayElements(const json& v) {
+    if (v.is_array()) return std::vector<json>(v.begin(), v.end());
+    if (!v.is_string()) return { v };
+
+    std::string_view s = v.get_ref<const std::string&>();
+    if (s.size() < 2 || s.front() != '{' || s.back() != '}')
+        throw std::invalid_argument("InMemory SQL: not an array literal: " + std::string(s));
+    s = s.substr(1, s.size() - 2);
+
+    std::vector<json> out;
+    while (!s.empty()) {
+        size_t comma = s.find(',');
+        std::string_view item = s.substr(0, comma);
+        while (!item.empty() && item.front() == ' ') item.remove_prefix(1);
+        while (!item.empty() && item.back() == ' ') item.remove_suffix(1);
+        if (item.size() >= 2 && item.front() == '"' && item.back() == '"') item = item.substr(1, item.size() - 2);
+        out.emplace_back(iequals(item, "NULL") ? json() : json(std::string(item)));
+        if (comma == std::string_view::npos) break;
+        s.remove_prefix(comma + 1);
+    }
+    return out;
+}
+
+// =============================================================================
+// Tokenizer
+// =============================================================================
+
+struct Token {
+    enum class Kind { Ident, Number, String, Param, Symbol, End };
+    Kind kind;
+    std::string text;
+    int param = -1;
+};
+
+std::vector<Token> tokenize(const std::string& sql, size_t& paramCount) {
+    std::vector<Token> tokens;
+    int nextPositional = 0;
+    size_t i = 0;
+    const size_t n = sql.size();
+    paramCount = 0;
+
+    auto fail = [&](const std::string& what) {
+        throw std::invalid_argument("InMemory SQL: " + what + " at offset " + std::to_string(i) + " in: " + sql);
+    };
+
+    while (i < n) {
+        const char c = sql[i];
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            ++i;
+        } else if (std::isalpha(static_cast<unsigned char>(c)) || c == '_' || c == '@') {
+            size_t start = i;
+            while (i < n && (std::isalnum(static_cast<unsigned char>(sql[i])) || sql[i] == '_' || sql[i] == '@')) ++i;
+            tokens.push_back({ Token::Kind::Ident, sql.substr(start, i - start) });
+        } else if (c == '"') {
+            size_t end = sql.find('"', i + 1);
+            if (end == std::string::npos) fail("unterminated quoted identifier");
+            tokens.push_back({ Token::Kind::Ident, sql.substr(i + 1, end - i - 1) });
+            i = end + 1;
+        } else if (std::isdigit(static_cast<unsigned char>(c)) || (c == '.' && i + 1 < n && std::isdigit(static_cast<unsigned char>(sql[i + 1])))) {
+            size_t start = i;
+            while (i < n && (std::isdigit(static_cast<unsigned char>(sql[i])) || sql[i] == '.')) ++i;
+            if (i < n && (sql[i] == 'e' || sql[i] == 'E')) {
+                ++i;
+                if (i < n && (sql[i] == '+' || sql[i] == '-')) ++i;
+                while (i < n && std::isdigit(static_cast<unsigned char>(sql[i]))) ++i;
+            }
+            tokens.push_back({ Token::Kind::Number, sql.substr(start, i - start) });
+        } else if (c == '\'') {
+            std::string text;
+            ++i;
+            for (;;) {
+                if (i >= n) fail("unterminated string literal");
+                if (sql[i] == '\'') {
+                    if (i + 1 < n && sql[i + 1] == '\'') {
+                        text += '\'';
+                        i += 2;
+                        continue;
+                    }
+                    ++i;
+                    break;
+                }
+                text += sql[i++];
+            }
+            tokens.push_back({ Token::Kind::String, std::move(text) });
+        } else if (c == '$' && i + 1 < n && std::isdigit(static_cast<unsigned char>(sql[i + 1]))) {
+            size_t start = ++i;
+            while (i < n && std::isdigit(static_cast<unsigned char>(sql[i]))) ++i;
+            int index = std::atoi(sql.substr(start, i - start).c_str());
+            if (index < 1) fail("bad parameter number");
+            tokens.push_back({ Token::Kind::Param, sql.substr(start - 1, i - start + 1), index - 1 });
+            paramCount = std::max(paramCount, static_cast<size_t>(index));
+        } else if (c == '?') {
+            ++i;
+            tokens.push_back({ Token::Kind::Param, "?", nextPositional++ });
+            paramCount = std::max(paramCount, static_cast<size_t>(nextPositional));
+        } else {
+            static const char* const twoChar[] = { "<=", ">=", "<>", "!=" };
+            bool matched = false;
+            for (const char* sym : twoChar) {
+                if (sql.compare(i, 2, sym) == 0) {
+                    tokens.push_back({ Token::Kind::Symbol, sym });
+                    i += 2;
+                    matched = true;
+                    break;
+                }
+            }
+            if (matched) continue;
+            if (std::string_view("(),*=<>;.-").find(c) == std::string_view::npos) fail(std::string("unexpected character '") + c + "'");
+            tokens.push_back({ Token::Kind::Symbol, std::string(1, c) });
+            ++i;
+        }
+    }
+    tokens.push_back({ Token::Kind::End, "" });
+    return tokens;
+}
+
+// =============================================================================
+// Statements
+// =============================================================================
+
+enum class Op { Eq, Ne, Lt, Le, Gt, Ge };
+
+bool holds(Op op, int c) {
+    switch (op) {
+    case Op::Eq: return c == 0;
+    case Op::Ne: return c != 0;
+    case Op::Lt: return c < 0;
+    case Op::Le: return c <= 0;
+    case Op::Gt: return c > 0;
+    case Op::Ge: return c >= 0;
+    }
+    return false;
+}
+
+struct Expr {
+    enum class Kind { Column, Excluded, Param, Literal, Row, Compare, And, Or, In, Any, IsNull };
+    Kind kind;
+    Op op = Op::Eq;
+    bool negate = false;
+    std::string name{};   // Column / Excluded, resolved into index when bound
+    int index = -1;       // column ordinal or parameter index
+    json literal{};
+    std::vector<Expr> args{};
+};
+
+struct Assignment {
+    std::string name;
+    int column = -1;
+    Expr value;
+};
+
+struct Statement {
+    enum class Kind { Select, Insert, Update, Delete, Begin, Commit, Rollback };
+    enum class OnConflict { Error, Nothing, Update };
+
+    Kind kind = Kind::Select;
+    std::string table;                              // lower case
+    size_t paramCount = 0;
+
+    // SELECT list or RETURNING list; empty names = *
+    bool hasOutput = false;
+    std::vector<std::string> outputNames;
+    std::vector<int> output;
+
+    std::optional<Expr> where;
+    std::vector<std::pair<std::string, bool>> orderNames;   // name, descending
+    std::vector<std::pair<int, bool>> order;
+    int64_t limit = -1;
+    int64_t offset = 0;
+
+    std::vector<std::string> insertNames;
+    std::vector<int> insertColumns;
+    std::vector<std::vector<Expr>> values;
+    OnConflict onConflict = OnConflict::Error;
+    std::string conflictName;
+
+    std::vector<Assignment> assignments;            // UPDATE SET / DO UPDATE SET
+};
+
+class Parser {
+public:
+    explicit Parser(const std::string& sql) : sql_(sql) {
+        tokens_ = tokenize(sql, paramCount_);
+    }
+
+    Statement parse() {
+        Statement st;
+        st.paramCount = paramCount_;
+
+        if (acceptKeyword("SELECT")) {
+            parseSelect(st);
+        } else if (acceptKeyword("INSERT")) {
+            parseInsert(st);
+        } else if (acceptKeyword("UPDATE")) {
+            parseUpdate(st);
+        } else if (acceptKeyword("DELETE")) {
+            st.kind = Statement::Kind::Delete;
+            expectKeyword("FROM");
+            st.table = lower(identifier());
+            if (acceptKeyword("WHERE")) st.where = parseOr();
+        } else if (acceptKeyword("BEGIN")) {
+            st.kind = Statement::Kind::Begin;
+            acceptKeyword("TRANSACTION") || acceptKeyword("TRAN") || acceptKeyword("WORK");
+        } else if (acceptKeyword("START")) {
+            st.kind = Statement::Kind::Begin;
+            expectKeyword("TRANSACTION");
+        } else if (acceptKeyword("COMMIT")) {
+            st.kind = Statement::Kind::Commit;
+            acceptKeyword("TRANSACTION") || acceptKeyword("TRAN") || acceptKeyword("WORK");
+        } else if (acceptKeyword("ROLLBACK")) {
+            st.kind = Statement::Kind::Rollback;
+            acceptKeyword("TRANSACTION") || acceptKeyword("TRAN") || acceptKeyword("WORK");
+        } else {
+            error("unsupported statement");
+        }
+
+        acceptSymbol(";");
+        if (peek().kind != Token::Kind::End) error("unexpected '" + peek().text + "'");
+        return st;
+    }
+
+private:
+    const Token& peek(size_t ahead = 0) const {
+        return tokens_[std::min(pos_ + ahead, tokens_.size() - 1)];
+    }
+
+    Token next() {
+        Token t = peek();
+        if (pos_ < tokens_.size() - 1) ++pos_;
+        return t;
+    }
+
+    bool isKeyword(const Token& t, const char* kw) const {
+        return t.kind == Token::Kind::Ident && iequals(t.text, kw);
+    }
+
+    bool acceptKeyword(const char* kw) {
+        if (!isKeyword(peek(), kw)) return false;
+        ++pos_;
+        return true;
+    }
+
+    void expectKeyword(const char* kw) {
+        if (!acceptKeyword(kw)) error(std::string("expected ") + kw);
+    }
+
+    bool isSymbol(const Token& t, const char* sym) const {
+        return t.kind == Token::Kind::Symbol && t.text == sym;
+    }
+
+    bool acceptSymbol(const char* sym) {
+        if (!isSymbol(peek(), sym)) return false;
+        ++pos_;
+        return true;
+    }
+
+    void expectSymbol(const char* sym) {
+        if (!acceptSymbol(sym)) error(std::string("expected '") + sym + "'");
+    }
+
+    std::string identifier() {
+        if (peek().kind != Token::Kind::Ident) error("expected an identifier");
+        return next().text;
+    }
+
+    int64_t count() {
+        if (peek().kind != Token::Kind::Number) error("expected a number");
+        auto v = parseInt(next().text);
+        if (!v || *v < 0) error("expected a non-negative integer");
+        return *v;
+    }
+
+    [[noreturn]] void error(const std::string& what) const {
+        throw std::invalid_argument("InMemory SQL: " + what + " in: " + sql_);
+    }
+
+    // * or name[, name...]
+    void parseOutputList(Statement& st) {
+        st.hasOutput = true;
+        if (acceptSymbol("*")) return;
+        do {
+            st.outputNames.push_back(identifier());
+        } while (acceptSymbol(","));
+    }
+
+    void parseSelect(Statement& st) {
+        st.kind = Statement::Kind::Select;
+        if (acceptKeyword("TOP")) st.limit = count();
+        parseOutputList(st);
+        expectKeyword("FROM");
+        st.table = lower(identifier());
+        if (acceptKeyword("WHERE")) st.where = parseOr();
+        if (acceptKeyword("ORDER")) {
+            expectKeyword("BY");
+            do {
+                std::string name = identifier();
+                bool desc = false;
+                if (acceptKeyword("DESC")) desc = true;
+                else acceptKeyword("ASC");
+                st.orderNames.emplace_back(std::move(name), desc);
+            } while (acceptSymbol(","));
+        }
+        if (acceptKeyword("LIMIT")) st.limit = count();
+        if (acceptKeyword("OFFSET")) st.offset = count();
+    }
+
+    void parseAssignments(Statement& st) {
+        do {
+            Assignment a;
+            a.name = identifier();
+            expectSymbol("=");
+            a.value = parseOperand();
+            st.assignments.push_back(std::move(a));
+        } while (acceptSymbol(","));
+    }
+
+    void parseInsert(Statement& st) {
+        st.kind = Statement::Kind::Insert;
+        expectKeyword("INTO");
+        st.table = lower(identifier());
+        expectSymbol("(");
+        do {
+            st.insertNames.push_back(identifier());
+        } while (acceptSymbol(","));
+        expectSymbol(")");
+        expectKeyword("VALUES");
+        do {
+            expectSymbol("(");
+            std::vector<Expr> row;
+            do {
+                row.push_back(parseOperand());
+            } while (acceptSymbol(","));
+            expectSymbol(")");
+            if (row.size() != st.insertNames.size()) error("VALUES row does not match the column list");
+            st.values.push_back(std::move(row));
+        } while (acceptSymbol(","));
+
+        if (acceptKeyword("ON")) {
+            expectKeyword("CONFLICT");
+            expectSymbol("(");
+            st.conflictName = identifier();
+            expectSymbol(")");
+            expectKeyword("DO");
+            if (acceptKeyword("NOTHING")) {
+                st.onConflict = Statement::OnConflict::Nothing;
+            } else {
+                expectKeyword("UPDATE");
+                expectKeyword("SET");
+                st.onConflict = Statement::OnConflict::Update;
+                parseAssignments(st);
+            }
+        }
+        if (acceptKeyword("RETURNING")) parseOutputList(st);
+    }
+
+    void parseUpdate(Statement& st) {
+        st.kind = Statement::Kind::Update;
+        st.table = lower(identifier());
+        expectKeyword("SET");
+        parseAssignments(st);
+        if (acceptKeyword("WHERE")) st.where = parseOr();
+    }
+
+    Expr parseOr() {
+        Expr e = parseAnd();
+        while (acceptKeyword("OR")) {
+            Expr o{ Expr::Kind::Or };
+            o.args.push_back(std::move(e));
+            o.args.push_back(parseAnd());
+            e = std::move(o);
+        }
+        return e;
+    }
+
+    Expr parseAnd() {
+        Expr e = parsePredicate();
+        while (acceptKeyword("AND")) {
+            Expr a{ Expr::Kind::And };
+            a.args.push_back(std::move(e));
+            a.args.push_back(parsePredicate());
+            e = std::move(a);
+        }
+        return e;
+    }
+
+    bool atComparison() const {
+        const Token& t = peek();
+        return t.kind == Token::Kind::Symbol &&
+               (t.text == "=" || t.text == "<>" || t.text == "!=" || t.text == "<" ||
+                t.text == "<=" || t.text == ">" || t.text == ">=");
+    }
+
+    Op comparison() {
+        const std::string sym = next().text;
+        if (sym == "=") return Op::Eq;
+        if (sym == "<>" || sym == "!=") return Op::Ne;
+        if (sym == "<") return Op::Lt;
+        if (sym == "<=") return Op::Le;
+        if (sym == ">") return Op::Gt;
+        return Op::Ge;
+    }
+
+    // (a, b, ...) after the opening parenthesis
+    Expr parseRowTail(Expr first) {
+        Expr row{ Expr::Kind::Row };
+        row.args.push_back(std::move(first));
+        while (acceptSymbol(",")) row.args.push_back(parseOperand());
+        expectSymbol(")");
+        return row;
+    }
+
+    Expr parsePredicate() {
+        Expr lhs;
+        if (acceptSymbol("(")) {
+            // (a, b) > (...) is a row comparison; anything else is a grouped condition
+            if (isSymbol(peek(1), ",")) {
+                lhs = parseRowTail(parseOperand());
+            } else {
+                Expr inner = parseOr();
+                expectSymbol(")");
+                return inner;
+            }
+        } else {
+            lhs = parseOperand();
+        }
+
+        if (acceptKeyword("IS")) {
+            Expr e{ Expr::Kind::IsNull };
+            e.negate = acceptKeyword("NOT");
+            expectKeyword("NULL");
+            e.args.push_back(std::move(lhs));
+            return e;
+        }
+
+        const bool notIn = isKeyword(peek(), "NOT") && isKeyword(peek(1), "IN");
+        if (notIn) ++pos_;
+        if (acceptKeyword("IN")) {
+            Expr e{ Expr::Kind::In };
+            e.negate = notIn;
+            e.args.push_back(std::move(lhs));
+            expectSymbol("(");
+            do {
+                e.args.push_back(parseOperand());
+            } while (acceptSymbol(","));
+            expectSymbol(")");
+            return e;
+        }
+
+        if (!atComparison()) error("expected a comparison");
+        Expr e{ Expr::Kind::Compare };
+        e.op = comparison();
+        e.args.push_back(std::move(lhs));
+
+        if (acceptKeyword("ANY")) {
+            if (e.op != Op::Eq) error("only = ANY(...) is supported");
+            e.kind = Expr::Kind::Any;
+            expectSymbol("(");
+            e.args.push_back(parseOperand());
+            expectSymbol(")");
+            return e;
+        }
+
+        if (acceptSymbol("(")) {
+            e.args.push_back(parseRowTail(parseOperand()));
+        } else {
+            e.args.push_back(parseOperand());
+        }
+        if ((e.args[0].kind == Expr::Kind::Row) != (e.args[1].kind == Expr::Kind::Row) ||
+            (e.args[0].kind == Expr::Kind::Row && e.args[0].args.size() != e.args[1].args.size())) {
+            error("row comparison needs rows of the same size on both sides");
+        }
+        return e;
+    }
+
+    Expr parseOperand() {
+        const Token& t = peek();
+        switch (t.kind) {
+        case Token::Kind::Param: {
+            Expr e{ Expr::Kind::Param };
+            e.index = next().param;
+            return e;
+        }
+        case Token::Kind::Number:
+            return numberLiteral(next().text, false);
+        case Token::Kind::String: {
+            Expr e{ Expr::Kind::Literal };
+            e.literal = next().text;
+            return e;
+        }
+        case Token::Kind::Symbol:
+            if (t.text == "-" && peek(1).kind == Token::Kind::Number) {
+                ++pos_;
+                return numberLiteral(next().text, true);
+            }
+            error("expected a value");
+        case Token::Kind::Ident: {
+            if (acceptKeyword("NULL")) return Expr{ Expr::Kind::Literal };
+            if (isKeyword(t, "TRUE") || isKeyword(t, "FALSE")) {
+                Expr e{ Expr::Kind::Literal };
+                e.literal = iequals(next().text, "TRUE");
+                return e;
+            }
+            std::string name = next().text;
+            if (acceptSymbol(".")) {
+                // EXCLUDED.col in ON CONFLICT; any other qualifier is just dropped
+                Expr e{ iequals(name, "EXCLUDED") ? Expr::Kind::Excluded : Expr::Kind::Column };
+                e.name = identifier();
+                return e;
+            }
+            Expr e{ Expr::Kind::Column };
+            e.name = std::move(name);
+            return e;
+        }
+        case Token::Kind::End:
+            break;
+        }
+        error("expected a value");
+    }
+
+    Expr numberLiteral(const std::string& text, bool negative) {
+        Expr e{ Expr::Kind::Literal };
+        if (auto i = parseInt(text)) {
+            e.literal = negative ? -*i : *i;
+        } else {
+            double d = std::strtod(text.c_str(), nullptr);
+            e.literal = negative ? -d : d;
+        }
+        return e;
+    }
+
+    std::string sql_;
+    std::vector<Token> tokens_;
+    size_t pos_ = 0;
+    size_t paramCount_ = 0;
+};
+
+// =============================================================================
+// Tables
+// =============================================================================
+
+struct Table {
+    std::string name;
+    std::vector<InMemoryColumn> columns;
+    std::unordered_map<std::string, int> ordinals;   // lower-case name -> position
+    int pk = -1;
+    std::map<int64_t, Row> rows;
+    int64_t nextId = 1;
+
+    int column(const std::string& columnName) const {
+        auto it = ordinals.find(lower(columnName));
+        if (it == ordinals.end())
+            throw std::runtime_error("column \"" + columnName + "\" of relation \"" + name + "\" does not exist");
+        return it->second;
+    }
+};
+
+void bindExpr(Expr& e, const Table& t) {
+    if (e.kind == Expr::Kind::Column || e.kind == Expr::Kind::Excluded) e.index = t.column(e.name);
+    for (auto& a : e.args) bindExpr(a, t);
+}
+
+void bindOutput(Statement& st, const Table& t) {
+    st.output.clear();
+    if (st.outputNames.empty()) {
+        for (size_t i = 0; i < t.columns.size(); ++i) st.output.push_back(static_cast<int>(i));
+        return;
+    }
+    for (const auto& n : st.outputNames) st.output.push_back(t.column(n));
+}
+
+void bindStatement(Statement& st, const Table& t) {
+    if (st.hasOutput) bindOutput(st, t);
+    if (st.where) bindExpr(*st.where, t);
+    for (const auto& [name, desc] : st.orderNames) st.order.emplace_back(t.column(name), desc);
+    for (const auto& n : st.insertNames) st.insertColumns.push_back(t.column(n));
+    for (auto& row : st.values)
+        for (auto& v : row) bindExpr(v, t);
+    for (auto& a : st.assignments) {
+        a.column = t.column(a.name);
+        bindExpr(a.value, t);
+    }
+    if (!st.conflictName.empty() && t.column(st.conflictName) != t.pk)
+        throw std::invalid_argument("InMemory SQL: ON CONFLICT is only supported on the primary key");
+}
+
+// Where a value comes from while a statement runs
+struct Scope {
+    const std::vector<json>& params;
+    const Row* row = nullptr;
+    const Row* excluded = nullptr;
+};
+
+const json& valueOf(const Expr& e, const Scope& s) {
+    switch (e.kind) {
+    case Expr::Kind::Literal:
+        return e.literal;
+    case Expr::Kind::Param:
+        return s.params[e.index];
+    case Expr::Kind::Column:
+        if (!s.row) throw std::invalid_argument("InMemory SQL: column \"" + e.name + "\" is not allowed here");
+        return (*s.row)[e.index];
+    case Expr::Kind::Excluded:
+        if (!s.excluded) throw std::invalid_argument("InMemory SQL: EXCLUDED is only allowed in ON CONFLICT");
+        return (*s.excluded)[e.index];
+    default:
+        throw std::invalid_argument("InMemory SQL: a condition is not a value");
+    }
+}
+
+bool test(const Expr& e, const Scope& s) {
+    switch (e.kind) {
+    case Expr::Kind::And:
+        return test(e.args[0], s) && test(e.args[1], s);
+    case Expr::Kind::Or:
+        return test(e.args[0], s) || test(e.args[1], s);
+    case Expr::Kind::Compare: {
+        const Expr& l = e.args[0];
+        const Expr& r = e.args[1];
+        if (l.kind != Expr::Kind::Row) {
+            auto c = compareValues(valueOf(l, s), valueOf(r, s));
+            return c && holds(e.op, *c);
+        }
+        // Lexicographic: the first unequal pair decides
+        for (size_t i = 0; i < l.args.size(); ++i) {
+            auto c = compareValues(valueOf(l.args[i], s), valueOf(r.args[i], s));
+            if (!c) return false;
+            if (*c != 0) return holds(e.op, *c);
+        }
+        return holds(e.op, 0);
+    }
+    case Expr::Kind::In: {
+        const json& v = valueOf(e.args[0], s);
+        if (v.is_null()) return false;
+        bool found = false;
+        for (size_t i = 1; i < e.args.size() && !found; ++i) {
+            auto c = compareValues(v, valueOf(e.args[i], s));
+            found = c && *c == 0;
+        }
+        return found != e.negate;
+    }
+    case Expr::Kind::Any: {
+        const json& v = valueOf(e.args[0], s);
+        for (const auto& item : arrayElements(valueOf(e.args[1], s))) {
+            auto c = compareValues(v, item);
+            if (c && *c == 0) return true;
+        }
+        return false;
+    }
+    case Expr::Kind::IsNull:
+        return valueOf(e.args[0], s).is_null() != e.negate;
+    default:
+        throw std::invalid_argument("InMemory SQL: a value is not a condition");
+    }
+}
+
+// Rows worth testing against WHERE: a key lookup when the condition pins the
+// primary key, otherwise the whole table
+struct KeyScan {
+    enum class Kind { All, Keys, From } kind = Kind::All;
+    std::vector<int64_t> keys;   // sorted, unique
+    int64_t from = 0;
+    bool inclusive = true;
+};
+
+bool isValue(const Expr& e) {
+    return e.kind == Expr::Kind::Param || e.kind == Expr::Kind::Literal;
+}
+
+KeyScan planScan(const Expr* where, const Table& t, const Scope& s) {
+    KeyScan scan;
+    if (!where) return scan;
+
+    auto onKey = [&](const Expr& e) { return e.kind == Expr::Kind::Column && e.index == t.pk; };
+    auto keysFrom = [&](const std::vector<json>& values) {
+        KeyScan k;
+        k.kind = KeyScan::Kind::Keys;
+        for (const auto& v : values) {
+            if (v.is_null()) continue;
+            auto key = toKey(v);
+            if (!key) return KeyScan{};   // not an integer: let the scan compare it
+            k.keys.push_back(*key);
+        }
+        std::sort(k.keys.begin(), k.keys.end());
+        k.keys.erase(std::unique(k.keys.begin(), k.keys.end()), k.keys.end());
+        return k;
+    };
+
+    switch (where->kind) {
+    case Expr::Kind::And:
+        for (const auto& a : where->args) {
+            scan = planScan(&a, t, s);
+            if (scan.kind != KeyScan::Kind::All) return scan;
+        }
+        return scan;
+    case Expr::Kind::Compare:
+        if (onKey(where->args[0]) && isValue(where->args[1])) {
+            const json& v = valueOf(where->args[1], s);
+            if (where->op == Op::Eq) return keysFrom({ v });
+            if (where->op == Op::Gt || where->op == Op::Ge) {
+                auto key = toKey(v);
+                if (!key) return scan;
+                scan.kind = KeyScan::Kind::From;
+                scan.from = *key;
+                scan.inclusive = where->op == Op::Ge;
+            }
+        }
+        return scan;
+    case Expr::Kind::In:
+        if (!where->negate && onKey(where->args[0]) &&
+            std::all_of(where->args.begin() + 1, where->args.end(), isValue)) {
+            std::vector<json> values;
+            for (size_t i = 1; i < where->args.size(); ++i) values.push_back(valueOf(where->args[i], s));
+            return keysFrom(values);
+        }
+        return scan;
+    case Expr::Kind::Any:
+        if (onKey(where->args[0]) && isValue(where->args[1]))
+            return keysFrom(arrayElements(valueOf(where->args[1], s)));
+        return scan;
+    default:
+        return scan;
+    }
+}
+
+// Calls fn(key, row) for matching rows in key order until it returns false
+template <typename TableT, typename Fn>
+void forEachMatch(TableT& t, const Statement& st, const std::vector<json>& params, Fn fn) {
+    Scope scope{ params };
+    const KeyScan scan = planScan(st.where ? &*st.where : nullptr, t, scope);
+
+    auto visit = [&](int64_t key, auto& row) {
+        scope.row = &row;
+        if (st.where && !test(*st.where, scope)) return true;
+        return fn(key, row);
+    };
+
+    switch (scan.kind) {
+    case KeyScan::Kind::Keys:
+        for (int64_t key : scan.keys) {
+            auto it = t.rows.find(key);
+            if (it != t.rows.end() && !visit(it->first, it->second)) return;
+        }
+        return;
+    case KeyScan::Kind::From: {
+        auto it = scan.inclusive ? t.rows.lower_bound(scan.from) : t.rows.upper_bound(scan.from);
+        for (; it != t.rows.end(); ++it)
+            if (!visit(it->first, it->second)) return;
+        return;
+    }
+    case KeyScan::Kind::All:
+        for (auto it = t.rows.begin(); it != t.rows.end(); ++it)
+            if (!visit(it->first, it->second)) return;
+        return;
+    }
+}
+
+Row project(const Row& row, const std::vector<int>& columns) {
+    Row out;
+    out.reserve(columns.size());
+    for (int c : columns) out.push_back(row[c]);
+    return out;
+}
+
+std::vector<std::string> outputColumns(const Statement& st, const Table& t) {
+    std::vector<std::string> names;
+    for (int c : st.output) names.push_back(t.columns[c].name);
+    return names;
+}
+
+// A row change, kept so a failed statement or a rolled-back transaction can undo it
+struct Change {
+    std::string table;
+    int64_t key;
+    std::optional<Row> before;   // empty: the row did not exist
+};
+
+struct Prepared {
+    Statement statement;
+    uint64_t schemaVersion;
+};
+
+const size_t kMaxCachedStatements = 1024;
+
+} // namespace
+
+// =============================================================================
+// InMemoryStore
+// =============================================================================
+
+struct InMemoryStore::Impl {
+    mutable std::shared_mutex mutex;
+    std::unordered_map<std::string, Table> tables;   // by lower-case name
+    uint64_t schemaVersion = 0;
+    InMemoryLatency latency;
+    std::atomic<uint64_t> statements{ 0 };
+
+    std::mutex cacheMutex;
+    std::unordered_map<std::string, std::shared_ptr<const Prepared>> cache;
+
+    Table& table(const std::string& name) {
+        auto it = tables.find(name);
+        if (it == tables.end()) throw std::runtime_error("relation \"" + name + "\" does not exist");
+        return it->second;
+    }
+
+    // Parsed and bound statement for sql, from the cache when the schema hasn't changed
+    std::shared_ptr<const Prepared> prepare(const std::string& sql) {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        {
+            std::lock_guard<std::mutex> cacheLock(cacheMutex);
+            auto it = cache.find(sql);
+            if (it != cache.end() && it->second->schemaVersion == schemaVersion) return it->second;
+        }
+
+        auto prepared = std::make_shared<Prepared>();
+        prepared->statement = Parser(sql).parse();
+        prepared->schemaVersion = schemaVersion;
+        Statement& st = prepared->statement;
+        if (!st.table.empty()) bindStatement(st, table(st.table));
+
+        std::lock_guard<std::mutex> cacheLock(cacheMutex);
+        if (cache.size() >= kMaxCachedStatements) cache.clear();
+        cache[sql] = prepared;
+        return prepared;
+    }
+
+    InMemoryResult select(const Statement& st, const std::vector<json>& params) {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        const Table& t = table(st.table);
+
+        // Key order is free: stop as soon as the page is full
+        const bool keyOrder = st.order.empty() || (st.order.size() == 1 && st.order[0].first == t.pk && !st.order[0].second);
+        const size_t wanted = st.limit >= 0 ? static_cast<size_t>(st.offset + st.limit) : std::numeric_limits<size_t>::max();
+
+        std::vector<const Row*> matched;
+        forEachMatch(t, st, params, [&](int64_t, const Row& row) {
+            matched.push_back(&row);
+            return !keyOrder || matched.size() < wanted;
+        });
+
+        if (!keyOrder) {
+            std::stable_sort(matched.begin(), matched.end(), [&](const Row* a, const Row* b) {
+                for (const auto& [col, desc] : st.order) {
+                    const json& x = (*a)[col];
+                    const json& y = (*b)[col];
+                    if (x.is_null() != y.is_null()) return y.is_null();   // NULLs last
+                    auto c = compareValues(x, y);
+                    if (c && *c != 0) return desc ? *c > 0 : *c < 0;
+                }
+                return false;
+            });
+        }
+
+        InMemoryResult result;
+        result.columns = outputColumns(st, t);
+        const size_t begin = std::min(matched.size(), static_cast<size_t>(st.offset));
+        const size_t end = std::min(matched.size(), wanted);
+        result.rows.reserve(end - begin);
+        for (size_t i = begin; i < end; ++i) result.rows.push_back(project(*matched[i], st.output));
+        return result;
+    }
+
+    InMemoryResult write(const Statement& st, const std::vector<json>& params, std::vector<Change>* txn) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        Table& t = table(st.table);
+        std::vector<Change> changes;
+        InMemoryResult result;
+        if (st.hasOutput) result.columns = outputColumns(st, t);
+
+        try {
+            switch (st.kind) {
+            case Statement::Kind::Insert:
+                insert(t, st, params, changes, result);
+                break;
+            case Statement::Kind::Update:
+                update(t, st, params, changes, result);
+                break;
+            case Statement::Kind::Delete:
+                remove(t, st, params, changes, result);
+                break;
+            default:
+                break;
+            }
+        } catch (...) {
+            undo(changes);   // statements are all-or-nothing
+            throw;
+        }
+
+        if (txn) txn->insert(txn->end(), std::make_move_iterator(changes.begin()), std::make_move_iterator(changes.end()));
+        return result;
+    }
+
+    void insert(Table& t, const Statement& st, const std::vector<json>& params, std::vector<Change>& changes, InMemoryResult& result) {
+        Scope scope{ params };
+        for (const auto& values : st.values) {
+            Row row(t.columns.size());
+            for (size_t i = 0; i < values.size(); ++i) {
+                const int c = st.insertColumns[i];
+                row[c] = coerce(valueOf(values[i], scope), t.columns[c]);
+            }
+
+            int64_t key;
+            if (row[t.pk].is_null()) {
+                key = t.nextId++;   // SERIAL / IDENTITY
+                row[t.pk] = key;
+            } else {
+                key = row[t.pk].get<int64_t>();
+                t.nextId = std::max(t.nextId, key + 1);
+            }
+
+            auto it = t.rows.find(key);
+            if (it == t.rows.end()) {
+                changes.push_back({ lower(t.name), key, std::nullopt });
+                it = t.rows.emplace(key, std::move(row)).first;
+            } else if (st.onConflict == Statement::OnConflict::Error) {
+                throw std::runtime_error("duplicate key value violates unique constraint: " + t.name + "." +
+                                         t.columns[t.pk].name + " = " + std::to_string(key));
+            } else if (st.onConflict == Statement::OnConflict::Nothing) {
+                continue;
+            } else {
+                changes.push_back({ lower(t.name), key, it->second });
+                Scope conflict{ params, &changes.back().before.value(), &row };
+                assign(t, st, conflict, it->second);
+            }
+
+            ++result.affected;
+            if (st.hasOutput) result.rows.push_back(project(it->second, st.output));
+        }
+    }
+
+    void update(Table& t, const Statement& st, const std::vector<json>& params, std::vector<Change>& changes, InMemoryResult& result) {
+        std::vector<int64_t> keys;
+        forEachMatch(t, st, params, [&](int64_t key, const Row&) {
+            keys.push_back(key);
+            return true;
+        });
+
+        for (int64_t key : keys) {
+            Row& row = t.rows.at(key);
+            changes.push_back({ lower(t.name), key, row });
+            Scope scope{ params, &changes.back().before.value() };
+            Row updated = row;
+            assign(t, st, scope, updated);
+
+            const json& newKey = updated[t.pk];
+            if (newKey.is_null()) throw std::runtime_error("null value in column \"" + t.columns[t.pk].name + "\"");
+            const int64_t k = newKey.get<int64_t>();
+            if (k == key) {
+                row = std::move(updated);
+            } else {
+                if (t.rows.count(k))
+                    throw std::runtime_error("duplicate key value violates unique constraint: " + t.name + "." +
+                                             t.columns[t.pk].name + " = " + std::to_string(k));
+                t.rows.erase(key);
+                changes.push_back({ lower(t.name), k, std::nullopt });
+                t.rows.emplace(k, std::move(updated));
+            }
+            ++result.affected;
+        }
+    }
+
+    void remove(Table& t, const Statement& st, const std::vector<json>& params, std::vector<Change>& changes, InMemoryResult& result) {
+        std::vector<int64_t> keys;
+        forEachMatch(t, st, params, [&](int64_t key, const Row&) {
+            keys.push_back(key);
+            return true;
+        });
+        for (int64_t key : keys) {
+            auto it = t.rows.find(key);
+            changes.push_back({ lower(t.name), key, std::move(it->second) });
+            t.rows.erase(it);
+            ++result.affected;
+        }
+    }
+
+    static void assign(const Table& t, const Statement& st, const Scope& scope, Row& row) {
+        // Every right-hand side sees the row as it was before the statement
+        for (const auto& a : st.assignments) row[a.column] = coerce(valueOf(a.value, scope), t.columns[a.column]);
+    }
+
+    // Caller holds the lock exclusively
+    void undo(std::vector<Change>& changes) {
+        for (auto it = changes.rbegin(); it != changes.rend(); ++it) {
+            auto table = tables.find(it->table);
+            if (table == tables.end()) continue;
+            if (it->before) table->second.rows[it->key] = std::move(*it->before);
+            else table->second.rows.erase(it->key);
+        }
+        changes.clear();
+    }
+};
+
+InMemoryStore::InMemoryStore(InMemoryLatency latency)
+    : impl_(std::make_unique<Impl>()) {
+    impl_->latency = latency;
+}
+
+InMemoryStore::~InMemoryStore() = default;
+
+void InMemoryStore::createTable(const std::string& name, std::vector<InMemoryColumn> columns, const std::string& primaryKey) {
+    Table t;
+    t.name = name;
+    t.columns = std::move(columns);
+    for (size_t i = 0; i < t.columns.size(); ++i) {
+        if (!t.ordinals.emplace(lower(t.columns[i].name), static_cast<int>(i)).second)
+            throw std::invalid_argument("Duplicate column " + t.columns[i].name + " in table " + name);
+    }
+    auto it = t.ordinals.find(lower(primaryKey));
+    if (it == t.ordinals.end() || t.columns[it->second].type != InMemoryType::Int)
+        throw std::invalid_argument("Primary key of table " + name + " must be an Int column: " + primaryKey);
+    t.pk = it->second;
+
+    std::unique_lock<std::shared_mutex> lock(impl_->mutex);
+    impl_->tables[lower(name)] = std::move(t);
+    ++impl_->schemaVersion;
+}
+
+void InMemoryStore::setLatency(InMemoryLatency latency) {
+    std::unique_lock<std::shared_mutex> lock(impl_->mutex);
+    impl_->latency = latency;
+}
+
+InMemoryLatency InMemoryStore::latency() const {
+    std::shared_lock<std::shared_mutex> lock(impl_->mutex);
+    return impl_->latency;
+}
+
+size_t InMemoryStore::rowCount(const std::string& table) const {
+    std::shared_lock<std::shared_mutex> lock(impl_->mutex);
+    return impl_->table(lower(table)).rows.size();
+}
+
+void InMemoryStore::truncate() {
+    std::unique_lock<std::shared_mutex> lock(impl_->mutex);
+    for (auto& [name, t] : impl_->tables) {
+        t.rows.clear();
+        t.nextId = 1;
+    }
+}
+
+uint64_t InMemoryStore::statementCount() const {
+    return impl_->statements.load(std::memory_order_relaxed);
+}
+
+// =============================================================================
+// InMemorySession
+// =============================================================================
+
+struct InMemorySession::Transaction {
+    std::vector<Change> changes;
+};
+
+InMemorySession::InMemorySession(std::shared_ptr<InMemoryStore> store)
+    : store_(std::move(store)) {
+    if (!store_) throw std::invalid_argument("InMemorySession needs a store");
+}
+
+InMemorySession::~InMemorySession() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    rollback();
+}
+
+bool InMemorySession::inTransaction() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return txn_ != nullptr;
+}
+
+void InMemorySession::rollback() {
+    if (!txn_) return;
+    std::unique_lock<std::shared_mutex> lock(store_->impl_->mutex);
+    store_->impl_->undo(txn_->changes);
+    txn_.reset();
+}
+
+InMemoryResult InMemorySession::execute(const std::string& sql, const std::vector<json>& params) {
+    auto& impl = *store_->impl_;
+    auto prepared = impl.prepare(sql);
+    const Statement& st = prepared->statement;
+    if (params.size() < st.paramCount) {
+        throw std::invalid_argument("InMemory SQL: statement expects " + std::to_string(st.paramCount) +
+                                    " parameters, got " + std::to_string(params.size()));
+    }
+    impl.statements.fetch_add(1, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    InMemoryResult result;
+    switch (st.kind) {
+    case Statement::Kind::Begin:
+        if (txn_) throw std::logic_error("A transaction is already in progress");
+        txn_ = std::make_unique<Transaction>();
+        break;
+    case Statement::Kind::Commit:
+        txn_.reset();
+        break;
+    case Statement::Kind::Rollback:
+        rollback();
+        break;
+    case Statement::Kind::Select:
+        result = impl.select(st, params);
+        break;
+    default:
+        result = impl.write(st, params, txn_ ? &txn_->changes : nullptr);
+        break;
+    }
+
+    // The simulated round trip, outside the store lock
+    const InMemoryLatency latency = store_->latency();
+    const auto delay = latency.perStatement + latency.perRow * static_cast<int64_t>(result.rows.size() + result.affected);
+    if (delay.count() > 0) std::this_thread::sleep_for(delay);
+    return result;
+}
+
+std::string inMemoryText(const json& value) {
+    switch (value.type()) {
+    case json::value_t::null:
+        return std::string();
+    case json::value_t::string:
+        return value.get<std::string>();
+    case json::value_t::boolean:
+        return value.get<bool>() ? "t" : "f";
+    case json::value_t::number_integer:
+        return std::to_string(value.get<int64_t>());
+    case json::value_t::number_unsigned:
+        return std::to_string(value.get<uint64_t>());
+    case json::value_t::number_float: {
+        char buf[32];
+        auto res = std::to_chars(buf, buf + sizeof(buf), value.get<double>());
+        return std::string(buf, res.ptr);
+    }
+    default:
+        return value.dump();
+    }
+}
+
+// =============================================================================
+// InMemoryDatabase / InMemoryConnection
+// =============================================================================
+
+InMemoryDatabase::InMemoryDatabase(std::shared_ptr<InMemoryStore> store)
+    : store_(std::move(store)) {
+    if (!store_) throw std::invalid_argument("InMemoryDatabase needs a store");
+}
+
+std::shared_ptr<Connection> InMemoryDatabase::openConnection(const std::string& connectionString) {
+    return std::make_shared<InMemoryConnection>(store_, connectionString);
+}
+
+std::string InMemoryDatabase::getDatabaseType() const {
+    return "InMemory";
+}
+
+InMemoryConnection::InMemoryConnection(std::shared_ptr<InMemoryStore> store, const std::string& connectionString)
+    : Connection("InMemory", connectionString), session_(std::make_unique<InMemorySession>(std::move(store))) {
+    connected_ = true;
+}
+
+InMemoryConnection::~InMemoryConnection() {
+    close();
+}
+
+std::shared_ptr<ResultSet> InMemoryConnection::execQuery(const std::string& query) {
+    if (!connected_) {
+        throw std::runtime_error("Not connected to database");
+    }
+
+    utils::StatementTrace trace(instrumentation_.get(), dbType_, query);
+    InMemoryResult result = session_->execute(query);
+    auto rs = std::make_shared<ResultSet>();
+    rs->setColumnNames(result.columns);
+    rs->reserveRows(result.rows.size());
+    for (const auto& row : result.rows) {
+        rs->beginRow();
+        for (size_t c = 0; c < row.size(); ++c) {
+            const json& v = row[c];
+            const int ordinal = static_cast<int>(c);
+            if (v.is_null()) continue;
+            if (v.is_number_integer()) rs->appendInt(ordinal, v.get<int64_t>());
+            else if (v.is_number_float()) rs->appendDouble(ordinal, v.get<double>());
+            else rs->append(ordinal, inMemoryText(v));
+        }
+        rs->endRow();
+    }
+    trace.finish(rs->getRowCount(), static_cast<int64_t>(rs->getDataSize()));
+    return rs;
+}
+
+int InMemoryConnection::execCommand(const std::string& command) {
+    if (!connected_) {
+        throw std::runtime_error("Not connected to database");
+    }
+    utils::StatementTrace trace(instrumentation_.get(), dbType_, command);
+    const int affected = session_->execute(command).affected;
+    trace.finish(affected);
+    return affected;
+}
+
+bool InMemoryConnection::isConnected() const {
+    return connected_;
+}
+
+void InMemoryConnection::close() {
+    if (connected_) {
+        session_.reset();   // rolls back an open transaction
+        connected_ = false;
+    }
+}
+
+} // namespace database
+} // namespace hftools
@@ -0,0 +1,289 @@
+#include "hftools/database/LoadGenerator.h"
+#include "hftools/database/Connection.h"
+#include "hftools/database/ResultSet.h"
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <ostream>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+namespace hftools {
+namespace database {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+enum Op { OpInsert, OpLookup, OpScan, OpUpdate, OpCount };
+const char* const kOpNames[OpCount] = { "insert", "lookup", "scan", "update" };
+
+std::string insertTradeSQL(std::mt19937_64& rng) {
+    std::uniform_int_distribution<int> side(0, 1);
+    std::uniform_real_distribution<double> price(1.05, 1.12);
+    return "INSERT INTO trades (user_id, instrument_id, side, quantity, price, timestamp) VALUES (1, 1, '"
+           + std::string(side(rng) ? "BUY" : "SELL") + "', 100000, " + std::to_string(price(rng))
+           + ", '2024-01-28 12:00:00')";
+}
+
+// Highest trade id, 0 for an empty table
+int readMaxId(Connection& conn, bool sybase) {
+    auto rs = conn.execQuery(sybase ? "SELECT TOP 1 id FROM trades ORDER BY id DESC"
+                                    : "SELECT id FROM trades ORDER BY id DESC LIMIT 1");
+    if (!rs || !rs->next() || rs->isNull("id")) return 0;
+    return rs->getInt("id");
+}
+
+std::shared_ptr<Connection> connect(IDatabase& db, const std::string& connectionString) {
+    auto conn = db.openConnection(connectionString);
+    if (!conn || !conn->isConnected()) {
+        throw std::runtime_error("Load generator: could not connect to " + db.getDatabaseType());
+    }
+    return conn;
+}
+
+// sleep_until alone overshoots by tens of microseconds: sleep most of the
+// way, then spin
+void waitUntil(Clock::time_point t) {
+    constexpr auto spin = std::chrono::microseconds(100);
+    auto now = Clock::now();
+    if (t - now > spin) std::this_thread::sleep_until(t - spin);
+    while (Clock::now() < t) std::this_thread::yield();
+}
+
+struct WorkerStats {
+    std::vector<utils::HdrHistogram> latency = std::vector<utils::HdrHistogram>(OpCount);
+    int64_t errors[OpCount] = {};
+    Clock::time_point finished;
+};
+
+} // namespace
+
+Workload parseWorkload(const std::string& name) {
+    if (name == "insert") return Workload::InsertTrades;
+    if (name == "lookup") return Workload::PointLookup;
+    if (name == "scan") return Workload::RangeScan;
+    if (name == "mixed") return Workload::Mixed;
+    throw std::invalid_argument("Unknown workload: " + name + " (expected insert, lookup, scan or mixed)");
+}
+
+Arrival parseArrival(const std::string& name) {
+    if (name == "closed") return Arrival::Closed;
+    if (name == "fixed") return Arrival::FixedRate;
+    if (name == "poisson") return Arrival::Poisson;
+    throw std::invalid_argument("Unknown arrival mode: " + name + " (expected closed, fixed or poisson)");
+}
+
+LoadGenerator::LoadGenerator(std::shared_ptr<IDatabase> db, std::string connectionString, LoadOptions options)
+    : db_(std::move(db)), connectionString_(std::move(connectionString)), options_(options) {
+    if (!db_) {
+        throw std::invalid_argument("Load generator: no database");
+    }
+    if (options_.threads < 1) {
+        throw std::invalid_argument("Load generator: threads must be >= 1");
+    }
+    if (options_.duration.count() <= 0) {
+        throw std::invalid_argument("Load generator: duration must be positive");
+    }
+    if (options_.arrival != Arrival::Closed && options_.rate <= 0) {
+        throw std::invalid_argument("Load generator: fixed-rate and Poisson arrivals need a rate");
+    }
+    if (options_.keySpace < 0 || options_.scanRows < 1) {
+        throw std::invalid_argument("Load generator: key space must be >= 0 and scan rows >= 1");
+    }
+    if (options_.readRatio < 0 || options_.readRatio > 1) {
+        throw std::invalid_argument("Load generator: read ratio must be between 0 and 1");
+    }
+    if (options_.workload != Workload::InsertTrades && options_.keySpace == 0) {
+        throw std::invalid_argument("Load generator: lookups, scans and updates need a key space");
+    }
+}
+
+LoadReport LoadGenerator::run() {
+    const std::string dbType = db_->getDatabaseType();
+    const bool sybase = dbType.find("Sybase") != std::string::npos;
+    auto setup = connect(*db_, connectionString_);
+
+    // Load the key range the readers and updaters pick from
+    const int baseline = readMaxId(*setup, sybase);
+    std::mt19937_64 loadRng(options_.seed);
+    for (int i = 0; i < options_.keySpace; ++i) {
+        setup->execCommand(insertTradeSQL(loadRng));
+    }
+    const int firstKey = baseline + 1;
+    const int lastKey = options_.keySpace > 0 ? readMaxId(*setup, sybase) : baseline;
+    if (options_.keySpace > 0 && lastKey < firstKey) {
+        throw std::runtime_error("Load generator: loaded trades are not visible");
+    }
+
+    std::vector<std::shared_ptr<Connection>> connections;
+    for (int t = 0; t < options_.threads; ++t) {
+        connections.push_back(connect(*db_, connectionString_));
+    }
+
+    const std::string scanSQL = sybase ? "SELECT TOP " + std::to_string(options_.scanRows) + " * FROM trades WHERE id >= "
+                                       : "SELECT * FROM trades WHERE id >= ";
+    const std::string scanSuffix = sybase ? " ORDER BY id" : " ORDER BY id LIMIT " + std::to_string(options_.scanRows);
+
+    // Threads start together, shortly after they are all spawned
+    const Clock::time_point start = Clock::now() + std::chrono::milliseconds(10);
+    const Clock::time_point measureFrom = start + options_.warmup;
+    const Clock::time_point end = measureFrom + options_.duration;
+    const double perThreadRate = options_.rate / options_.threads;
+    const auto interval = perThreadRate > 0
+        ? std::chrono::nanoseconds(static_cast<int64_t>(1e9 / perThreadRate))
+        : std::chrono::nanoseconds(0);
+
+    std::vector<WorkerStats> stats(options_.threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < options_.threads; ++t) {
+        workers.emplace_back([&, t] {
+            Connection& conn = *connections[t];
+            WorkerStats& ws = stats[t];
+            std::mt19937_64 rng(options_.seed + 1 + t);
+            std::uniform_int_distribution<int> key(firstKey, std::max(firstKey, lastKey));
+            std::uniform_real_distribution<double> unit(0.0, 1.0);
+            std::exponential_distribution<double> gap(perThreadRate > 0 ? perThreadRate : 1.0);
+
+            // Stagger the schedules so the threads do not fire in lockstep
+            Clock::time_point next = start + interval * t / options_.threads;
+            waitUntil(start);
+
+            for (;;) {
+                Clock::time_point issued;
+                if (options_.arrival == Arrival::Closed) {
+                    issued = Clock::now();
+                } else {
+                    issued = next;
+                    if (options_.arrival == Arrival::FixedRate) {
+                        next += interval;
+                    } else {
+                        next += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(gap(rng)));
+                    }
+                    waitUntil(issued);
+                }
+                if (issued >= end) break;
+
+                Op op;
+                switch (options_.workload) {
+                case Workload::InsertTrades: op = OpInsert; break;
+                case Workload::PointLookup: op = OpLookup; break;
+                case Workload::RangeScan: op = OpScan; break;
+                default: op = unit(rng) < options_.readRatio ? OpLookup : OpUpdate; break;
+                }
+
+                bool ok = true;
+                try {
+                    switch (op) {
+                    case OpInsert:
+                        conn.execCommand(insertTradeSQL(rng));
+                        break;
+                    case OpLookup:
+                        conn.execQuery("SELECT * FROM trades WHERE id = " + std::to_string(key(rng)));
+                        break;
+                    case OpScan:
+                        conn.execQuery(scanSQL + std::to_string(key(rng)) + scanSuffix);
+                        break;
+                    default:
+                        conn.execCommand("UPDATE trades SET price = " + std::to_string(1.05 + unit(rng) * 0.07)
+                                         + " WHERE id = " + std::to_string(key(rng)));
+                        break;
+                    }
+                } catch (const std::exception&) {
+                    ok = false;
+                }
+
+                // Latency runs from the intended start, so queueing behind a slow call counts
+                const Clock::time_point done = Clock::now();
+                if (issued < measureFrom) continue;
+                if (ok) {
+                    ws.latency[op].record(std::chrono::duration_cast<std::chrono::nanoseconds>(done - issued).count());
+                } else {
+                    ++ws.errors[op];
+                }
+            }
+            ws.finished = Clock::now();
+        });
+    }
+    for (auto& w : workers) w.join();
+    for (auto& c : connections) c->close();
+
+    LoadReport report;
+    report.databaseType = dbType;
+    report.options = options_;
+    Clock::time_point finished = end;
+    for (const auto& ws : stats) finished = std::max(finished, ws.finished);
+    report.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(finished - measureFrom);
+
+    for (int op = 0; op < OpCount; ++op) {
+        OperationStats total{ kOpNames[op], utils::HdrHistogram(), 0 };
+        for (const auto& ws : stats) {
+            total.latency.add(ws.latency[op]);
+            total.errors += ws.errors[op];
+        }
+        if (total.latency.count() > 0 || total.errors > 0) {
+            report.operations.push_back(std::move(total));
+        }
+    }
+
+    if (options_.cleanup) {
+        setup->execCommand("DELETE FROM trades WHERE id > " + std::to_string(baseline));
+    }
+    setup->close();
+    return report;
+}
+
+int64_t LoadReport::totalOperations() const {
+    int64_t n = 0;
+    for (const auto& op : operations) n += op.latency.count();
+    return n;
+}
+
+int64_t LoadReport::totalErrors() const {
+    int64_t n = 0;
+    for (const auto& op : operations) n += op.errors;
+    return n;
+}
+
+double LoadReport::throughput() const {
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+    return seconds > 0 ? static_cast<double>(totalOperations()) / seconds : 0.0;
+}
+
+void LoadReport::print(std::ostream& out) const {
+    static const char* const workloads[] = { "insert", "lookup", "scan", "mixed" };
+    static const char* const arrivals[] = { "closed loop", "fixed rate", "poisson" };
+
+    out << "Load test: " << workloads[static_cast<int>(options.workload)] << " on " << databaseType << "\n"
+        << "  " << options.threads << " threads, " << arrivals[static_cast<int>(options.arrival)];
+    if (options.arrival != Arrival::Closed) out << " at " << options.rate << " req/s";
+    out << ", " << options.duration.count() << " s";
+    if (options.warmup.count() > 0) out << " after " << options.warmup.count() << " s warmup";
+    out << ", " << options.keySpace << " trades loaded\n";
+
+    out << std::fixed << std::setprecision(1)
+        << "  throughput " << throughput() << " ops/s (" << totalOperations() << " ops, "
+        << totalErrors() << " errors in " << std::chrono::duration<double>(elapsed).count() << " s)\n\n";
+
+    auto us = [](double ns) { return ns / 1000.0; };
+    out << "  " << std::left << std::setw(10) << "operation" << std::right
+        << std::setw(12) << "count" << std::setw(9) << "errors"
+        << std::setw(11) << "mean us" << std::setw(11) << "p50 us" << std::setw(11) << "p90 us"
+        << std::setw(11) << "p99 us" << std::setw(11) << "p99.9 us" << std::setw(11) << "max us" << "\n";
+    for (const auto& op : operations) {
+        const auto& h = op.latency;
+        out << "  " << std::left << std::setw(10) << op.name << std::right
+            << std::setw(12) << h.count() << std::setw(9) << op.errors << std::setprecision(1)
+            << std::setw(11) << us(h.mean())
+            << std::setw(11) << us(static_cast<double>(h.valueAtPercentile(50.0)))
+            << std::setw(11) << us(static_cast<double>(h.valueAtPercentile(90.0)))
+            << std::setw(11) << us(static_cast<double>(h.valueAtPercentile(99.0)))
+            << std::setw(11) << us(static_cast<double>(h.valueAtPercentile(99.9)))
+            << std::setw(11) << us(static_cast<double>(h.max())) << "\n";
+    }
+    out.unsetf(std::ios::fixed);
+}
+
+} // namespace database
+} // namespace hftools
@@ -0,0 +1,93 @@
+#include "hftools/database/MockPostgreSQLDatabase.h"
+#include "hftools/database/ResultSet.h"
+#include "hftools/utils/Logger.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace hftools {
+namespace database {
+
+// MockPostgreSQLDatabase implementation
+
+std::shared_ptr<Connection> MockPostgreSQLDatabase::openConnection(const std::string& connectionString) {
+    HFTOOLS_LOG_INFO("Opening PostgreSQL connection: " << connectionString);
+    return std::make_shared<MockPostgreSQLConnection>(connectionString);
+}
+
+std::string MockPostgreSQLDatabase::getDatabaseType() const {
+    return "PostgreSQL (mock)";
+}
+
+// MockPostgreSQLConnection implementation
+
+MockPostgreSQLConnection::MockPostgreSQLConnection(const std::string& connectionString)
+    : Connection("PostgreSQL", connectionString) {
+    
+    HFTOOLS_LOG_INFO("PostgreSQL: Simulating connection to " << connectionString);
+    connected_ = true; // Simulate successful connection
+}
+
+MockPostgreSQLConnection::~MockPostgreSQLConnection() {
+    close();
+}
+
+std::shared_ptr<ResultSet> MockPostgreSQLConnection::execQuery(const std::string& query) {
+    if (!connected_) {
+        throw std::runtime_error("Not connected to database");
+    }
+
+    utils::StatementTrace trace(instrumentation_.get(), dbType_, query);
+    HFTOOLS_LOG_DEBUG("[PostgreSQL] Executing query: " << query);
+    
+    // Mock implementation - create a result set with sample data
+    auto rs = std::make_shared<ResultSet>();
+    
+    // Convert query to lowercase for case-insensitive comparison
+    std::string lowerQuery = query;
+    std::transform(lowerQuery.begin(), lowerQuery.end(), lowerQuery.begin(), ::tolower);
+    
+    // Parse simple SELECT queries and return mock data
+    if (lowerQuery.find("select") != std::string::npos) {
+        if (lowerQuery.find("users") != std::string::npos) {
+            rs->setColumnNames({"id", "username", "email", "role"});
+            rs->appendRow({"1", "trader1", "trader1@example.com", "TRADER"});
+            rs->appendRow({"2", "admin1", "admin1@example.com", "ADMIN"});
+        } else if (lowerQuery.find("fxinstruments") != std::string::npos) {
+            rs->setColumnNames({"id", "symbol", "base_currency", "quote_currency", "tick_size"});
+            rs->appendRow({"1", "EUR/USD", "EUR", "USD", "0.0001"});
+        } else if (lowerQuery.find("trades") != std::string::npos) {
+            rs->setColumnNames({"id", "user_id", "instrument_id", "side", "quantity", "price", "timestamp"});
+            rs->appendRow({"1", "1", "1", "BUY", "100000", "1.0850", "2024-01-28 12:00:00"});
+        }
+    }
+    
+    trace.finish(rs->getRowCount(), static_cast<int64_t>(rs->getDataSize()));
+    return rs;
+}
+
+int MockPostgreSQLConnection::execCommand(const std::string& command) {
+    if (!connected_) {
+        throw std::runtime_error("Not connected to database");
+    }
+
+    utils::StatementTrace trace(instrumentation_.get(), dbType_, command);
+    HFTOOLS_LOG_DEBUG("[PostgreSQL] Executing command: " << command);
+    
+    // Mock implementation - return 1 row affected
+    trace.finish(1);
+    return 1;
+}
+
+bool MockPostgreSQLConnection::isConnected() const {
+    return connected_;
+}
+
+void MockPostgreSQLConnection::close() {
+    if (connected_) {
+        HFTOOLS_LOG_INFO("[PostgreSQL] Closing connection");
+        connected_ = false;
+    }
+}
+
+} // namespace database
+} // namespace hftools
@@ -0,0 +1,88 @@
+#include "hftools/database/MockSybaseDatabase.h"
+#include "hftools/database/ResultSet.h"
+#include "hftools/utils/Logger.h"
+#include <stdexcept>
+
+namespace hftools {
+namespace database {
+
+// MockSybaseDatabase implementation
+
+std::shared_ptr<Connection> MockSybaseDatabase::openConnection(const std::string& connectionString) {
+    HFTOOLS_LOG_INFO("Opening Sybase connection: " << connectionString);
+    return std::make_shared<MockSybaseConnection>(connectionString);
+}
+
+std::string MockSybaseDatabase::getDatabaseType() const {
+    return "Sybase (mock)";
+}
+
+// MockSybaseConnection implementation
+
+MockSybaseConnection::MockSybaseConnection(const std::string& connectionString)
+    : Connection("Sybase", connectionString) {
+    
+    HFTOOLS_LOG_INFO("Sybase: Simulating connection to " << connectionString);
+    connected_ = true; // Simulate successful connection
+}
+
+MockSybaseConnection::~MockSybaseConnection() {
+    close();
+}
+
+std::shared_ptr<ResultSet> MockSybaseConnection::execQuery(const std::string& query) {
+    if (!connected_) {
+        throw std::runtime_error("Not connected to database");
+    }
+
+    utils::StatementTrace trace(instrumentation_.get(), dbType_, query);
+    HFTOOLS_LOG_DEBUG("[Sybase] Executing query: " << query);
+    
+    // Mock implementation - create a result set with sample data
+    auto rs = std::make_shared<ResultSet>();
+    
+    // Parse simple SELECT queries and return mock data
+    if (query.find("SELECT") != std::string::npos || query.find("select") != std::string::npos) {
+        if (query.find("users") != std::string::npos) {
+            rs->setColumnNames({"id", "username", "email", "role"});
+            rs->appendRow({"1", "trader1", "trader1@example.com", "TRADER"});
+            rs->appendRow({"2", "admin1", "admin1@example.com", "ADMIN"});
+        } else if (query.find("fxinstruments") != std::string::npos) {
+            rs->setColumnNames({"id", "symbol", "base_currency", "quote_currency", "tick_size"});
+            rs->appendRow({"1", "EUR/USD", "EUR", "USD", "0.0001"});
+        } else if (query.find("trades") != std::string::npos) {
+            rs->setColumnNames({"id", "user_id", "instrument_id", "side", "quantity", "price", "timestamp"});
+            rs->appendRow({"1", "1", "1", "BUY", "100000", "1.0850", "2024-01-28 12:00:00"});
+        }
+    }
+    
+    trace.finish(rs->getRowCount(), static_cast<int64_t>(rs->getDataSize()));
+    return rs;
+}
+
+int MockSybaseConnection::execCommand(const std::string& command) {
+    if (!connected_) {
+        throw std::runtime_error("Not connected to database");
+    }
+
+    utils::StatementTrace trace(instrumentation_.get(), dbType_, command);
+    HFTOOLS_LOG_DEBUG("[Sybase] Executing command: " << command);
+    
+    // Mock implementation - return 1 row affected
+    trace.finish(1);
+    return 1;
+}
+
+bool MockSybaseConnection::isConnected() const {
+    return connected_;
+}
+
+void MockSybaseConnection::close() {
+    if (connected_) {
+        HFTOOLS_LOG_INFO("[Sybase] Closing connection");
+        connected_ = false;
+    }
+}
+
+} // namespace database
+} // namespace hftools
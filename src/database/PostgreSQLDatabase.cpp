@@ -1,7 +1,22 @@
 #include "hftools/database/PostgreSQLDatabase.h"
 #include "hftools/database/ResultSet.h"
-#include <iostream>
-#include <algorithm>
+#include "hftools/utils/Logger.h"
+#include <stdexcept>
+
+#ifdef HFTOOLS_HAS_LIBPQ
+#include <libpq-fe.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <poll.h>
+#endif
+#endif
 
 namespace hftools {
 namespace database {
@@ -9,7 +24,6 @@ namespace database {
 // PostgreSQLDatabase implementation
 
 std::shared_ptr<Connection> PostgreSQLDatabase::openConnection(const std::string& connectionString) {
-    std::cout << "Opening PostgreSQL connection: " << connectionString << std::endl;
     return std::make_shared<PostgreSQLConnection>(connectionString);
 }
 
@@ -17,74 +31,422 @@ std::string PostgreSQLDatabase::getDatabaseType() const {
     return "PostgreSQL";
 }
 
+#ifdef HFTOOLS_HAS_LIBPQ
+
+namespace {
+
+// Built-in type OIDs (catalog/pg_type_d.h, which client installs don't always ship)
+const Oid kBoolOid = 16;
+const Oid kInt8Oid = 20;
+const Oid kInt2Oid = 21;
+const Oid kInt4Oid = 23;
+const Oid kOidOid = 26;
+const Oid kFloat4Oid = 700;
+const Oid kFloat8Oid = 701;
+const Oid kDateOid = 1082;
+const Oid kTimestampOid = 1114;
+const Oid kTimestampTzOid = 1184;
+const Oid kNumericOid = 1700;
+
+// PostgreSQL dates count from 2000-01-01
+const int64_t kPgEpochDays = 10957;   // days from 1970-01-01
+const int64_t kMicrosPerDay = 86400LL * 1000000LL;
+
+uint16_t readU16(const char* p) {
+    const auto* b = reinterpret_cast<const unsigned char*>(p);
+    return static_cast<uint16_t>(b[0] << 8 | b[1]);
+}
+
+uint32_t readU32(const char* p) {
+    return static_cast<uint32_t>(readU16(p)) << 16 | readU16(p + 2);
+}
+
+uint64_t readU64(const char* p) {
+    return static_cast<uint64_t>(readU32(p)) << 32 | readU32(p + 4);
+}
+
+void appendPadded(std::string& out, int value, int width) {
+    char buf[8];
+    int n = 0;
+    for (int i = 0; i < width; ++i) {
+        buf[width - 1 - i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+        ++n;
+    }
+    out.append(buf, n);
+}
+
+// Proleptic Gregorian date from days since 1970-01-01 (H. Hinnant's civil_from_days)
+void appendDate(std::string& out, int64_t days) {
+    days += 719468;
+    const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const int64_t doe = days - era * 146097;
+    const int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const int64_t mp = (5 * doy + 2) / 153;
+    const int64_t d = doy - (153 * mp + 2) / 5 + 1;
+    const int64_t m = mp < 10 ? mp + 3 : mp - 9;
+    const int64_t y = yoe + era * 400 + (m <= 2 ? 1 : 0);
+
+    appendPadded(out, static_cast<int>(y), 4);
+    out += '-';
+    appendPadded(out, static_cast<int>(m), 2);
+    out += '-';
+    appendPadded(out, static_cast<int>(d), 2);
+}
+
+// "YYYY-MM-DD HH:MM:SS[.ffffff]" from microseconds since 2000-01-01 (UTC for timestamptz)
+std::string formatTimestamp(int64_t pgMicros) {
+    if (pgMicros == INT64_MAX) return "infinity";
+    if (pgMicros == INT64_MIN) return "-infinity";
+
+    int64_t days = pgMicros / kMicrosPerDay;
+    int64_t micros = pgMicros % kMicrosPerDay;
+    if (micros < 0) {
+        micros += kMicrosPerDay;
+        --days;
+    }
+
+    std::string out;
+    out.reserve(26);
+    appendDate(out, days + kPgEpochDays);
+    const int64_t secs = micros / 1000000;
+    out += ' ';
+    appendPadded(out, static_cast<int>(secs / 3600), 2);
+    out += ':';
+    appendPadded(out, static_cast<int>(secs / 60 % 60), 2);
+    out += ':';
+    appendPadded(out, static_cast<int>(secs % 60), 2);
+    if (micros % 1000000 != 0) {
+        out += '.';
+        appendPadded(out, static_cast<int>(micros % 1000000), 6);
+    }
+    return out;
+}
+
+// Binary NUMERIC: ndigits, weight, sign, dscale, then base-10000 digits
+std::string formatNumeric(const char* p, int len) {
+    if (len < 8) {
+        throw std::runtime_error("Malformed binary numeric value");
+    }
+    const int ndigits = static_cast<int16_t>(readU16(p));
+    const int weight = static_cast<int16_t>(readU16(p + 2));
+    const uint16_t sign = readU16(p + 4);
+    const int dscale = static_cast<int16_t>(readU16(p + 6));
+    if (len < 8 + 2 * ndigits) {
+        throw std::runtime_error("Malformed binary numeric value");
+    }
+
+    if (sign == 0xC000) return "NaN";
+    if (sign == 0xD000) return "Infinity";
+    if (sign == 0xF000) return "-Infinity";
+
+    auto digit = [&](int i) { return i >= 0 && i < ndigits ? static_cast<int>(readU16(p + 8 + 2 * i)) : 0; };
+
+    std::string out;
+    if (sign == 0x4000) out += '-';
+    if (weight < 0) {
+        out += '0';
+    } else {
+        out += std::to_string(digit(0));
+        for (int i = 1; i <= weight; ++i) appendPadded(out, digit(i), 4);
+    }
+    if (dscale > 0) {
+        std::string frac;
+        for (int i = weight + 1; static_cast<int>(frac.size()) < dscale; ++i) appendPadded(frac, digit(i), 4);
+        frac.resize(dscale);
+        out += '.';
+        out += frac;
+    }
+    return out;
+}
+
+// Decode one binary-format field into the open row of rs
+void appendBinaryField(ResultSet& rs, int col, Oid type, const char* p, int len) {
+    switch (type) {
+    case kBoolOid:
+        rs.append(col, len > 0 && p[0] ? "t" : "f");
+        return;
+    case kInt2Oid:
+        rs.appendInt(col, static_cast<int16_t>(readU16(p)));
+        return;
+    case kInt4Oid:
+        rs.appendInt(col, static_cast<int32_t>(readU32(p)));
+        return;
+    case kOidOid:
+        rs.appendInt(col, readU32(p));
+        return;
+    case kInt8Oid:
+        rs.appendInt(col, static_cast<int64_t>(readU64(p)));
+        return;
+    case kFloat4Oid: {
+        uint32_t bits = readU32(p);
+        float f;
+        std::memcpy(&f, &bits, sizeof(f));
+        rs.appendDouble(col, f);
+        return;
+    }
+    case kFloat8Oid: {
+        uint64_t bits = readU64(p);
+        double d;
+        std::memcpy(&d, &bits, sizeof(d));
+        rs.appendDouble(col, d);
+        return;
+    }
+    case kNumericOid:
+        rs.append(col, formatNumeric(p, len));
+        return;
+    case kTimestampOid:
+    case kTimestampTzOid:
+        rs.append(col, formatTimestamp(static_cast<int64_t>(readU64(p))));
+        return;
+    case kDateOid: {
+        std::string out;
+        appendDate(out, static_cast<int32_t>(readU32(p)) + kPgEpochDays);
+        rs.append(col, out);
+        return;
+    }
+    default:
+        // text, varchar, bpchar, name, json, bytea, ...: the binary form is the raw bytes
+        rs.append(col, std::string_view(p, static_cast<size_t>(len)));
+        return;
+    }
+}
+
+} // namespace
+
 // PostgreSQLConnection implementation
 
-PostgreSQLConnection::PostgreSQLConnection(const std::string& connectionString)
+PostgreSQLConnection::PostgreSQLConnection(const std::string& connectionString, int connectTimeoutMs)
     : Connection("PostgreSQL", connectionString), pgConn_(nullptr) {
-    
-    // Mock implementation - in real code, this would call PQconnectdb()
-    std::cout << "PostgreSQL: Simulating connection to " << connectionString << std::endl;
-    connected_ = true; // Simulate successful connection
+
+    pgConn_ = PQconnectStart(connectionString.c_str());
+    if (!pgConn_) {
+        throw std::runtime_error("PostgreSQL: cannot allocate connection");
+    }
+    if (PQstatus(pgConn_) == CONNECTION_BAD) {
+        fail("PostgreSQL connection failed");
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(connectTimeoutMs);
+    PostgresPollingStatusType status = PGRES_POLLING_WRITING;
+    while (status != PGRES_POLLING_OK) {
+        if (status == PGRES_POLLING_FAILED) {
+            fail("PostgreSQL connection failed");
+        }
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (left.count() <= 0) {
+            fail("PostgreSQL connection timed out");
+        }
+        waitSocket(status == PGRES_POLLING_WRITING, static_cast<int>(left.count()));
+        status = PQconnectPoll(pgConn_);
+    }
+
+    if (PQsetnonblocking(pgConn_, 1) != 0) {
+        fail("PostgreSQL: cannot switch to non-blocking mode");
+    }
+    connected_ = true;
+    HFTOOLS_LOG_INFO("[PostgreSQL] Connected: " << connectionString);
 }
 
 PostgreSQLConnection::~PostgreSQLConnection() {
     close();
 }
 
-std::shared_ptr<ResultSet> PostgreSQLConnection::execQuery(const std::string& query) {
-    if (!connected_) {
+bool PostgreSQLConnection::isConnected() const {
+    return connected_ && pgConn_ && PQstatus(pgConn_) == CONNECTION_OK;
+}
+
+void PostgreSQLConnection::close() {
+    if (pgConn_) {
+        HFTOOLS_LOG_INFO("[" << dbType_ << "] Closing connection");
+        PQfinish(pgConn_);
+        pgConn_ = nullptr;
+    }
+    connected_ = false;
+}
+
+void PostgreSQLConnection::fail(const std::string& what) {
+    std::string message = what;
+    if (pgConn_) {
+        message += ": ";
+        message += PQerrorMessage(pgConn_);
+        PQfinish(pgConn_);
+        pgConn_ = nullptr;
+    }
+    connected_ = false;
+    throw std::runtime_error(message);
+}
+
+void PostgreSQLConnection::waitSocket(bool forWrite, int timeoutMs) {
+    const int fd = PQsocket(pgConn_);
+    if (fd < 0) {
+        fail("PostgreSQL: no socket");
+    }
+#ifdef _WIN32
+    WSAPOLLFD pfd{};
+    pfd.fd = static_cast<SOCKET>(fd);
+    pfd.events = forWrite ? (POLLWRNORM | POLLRDNORM) : POLLRDNORM;
+    int rc = WSAPoll(&pfd, 1, timeoutMs);
+#else
+    pollfd pfd{};
+    pfd.fd = fd;
+    // While flushing we must also drain input, or the server can deadlock on a full pipe
+    pfd.events = forWrite ? (POLLOUT | POLLIN) : POLLIN;
+    int rc;
+    do {
+        rc = ::poll(&pfd, 1, timeoutMs);
+    } while (rc < 0 && errno == EINTR);
+#endif
+    if (rc < 0) {
+        fail("PostgreSQL: poll failed");
+    }
+}
+
+void PostgreSQLConnection::send(const std::string& sql, bool singleRowMode) {
+    if (!isConnected()) {
         throw std::runtime_error("Not connected to database");
     }
 
-    std::cout << "[PostgreSQL] Executing query: " << query << std::endl;
-    
-    // Mock implementation - create a result set with sample data
+    // resultFormat 1 = binary: no server-side text formatting, no client-side parsing
+    if (!PQsendQueryParams(pgConn_, sql.c_str(), 0, nullptr, nullptr, nullptr, nullptr, 1)) {
+        throw std::runtime_error(std::string("PostgreSQL send failed: ") + PQerrorMessage(pgConn_));
+    }
+    // Must come right after the send; on failure the query still runs, and
+    // its results are read and dropped below so the connection stays usable
+    const bool rowModeFailed = singleRowMode && !PQsetSingleRowMode(pgConn_);
+
+    int rc;
+    while ((rc = PQflush(pgConn_)) == 1) {
+        waitSocket(true, -1);
+        if (!PQconsumeInput(pgConn_)) {
+            fail("PostgreSQL connection lost");
+        }
+    }
+    if (rc < 0) {
+        fail("PostgreSQL send failed");
+    }
+
+    if (rowModeFailed) {
+        discardResults();
+        throw std::runtime_error("PostgreSQL: cannot enter single-row mode");
+    }
+}
+
+void PostgreSQLConnection::discardResults() {
+    while (PGresult* res = nextResult()) {
+        PQclear(res);
+    }
+}
+
+PGresult* PostgreSQLConnection::nextResult() {
+    while (PQisBusy(pgConn_)) {
+        waitSocket(false, -1);
+        if (!PQconsumeInput(pgConn_)) {
+            fail("PostgreSQL connection lost");
+        }
+    }
+    return PQgetResult(pgConn_);
+}
+
+std::shared_ptr<ResultSet> PostgreSQLConnection::execQuery(const std::string& query) {
+    utils::StatementTrace trace(instrumentation_.get(), dbType_, query);
+    HFTOOLS_LOG_DEBUG("[" << dbType_ << "] Executing query: " << query);
+    send(query, true);
+
     auto rs = std::make_shared<ResultSet>();
-    
-    // Convert query to lowercase for case-insensitive comparison
-    std::string lowerQuery = query;
-    std::transform(lowerQuery.begin(), lowerQuery.end(), lowerQuery.begin(), ::tolower);
-    
-    // Parse simple SELECT queries and return mock data
-    if (lowerQuery.find("select") != std::string::npos) {
-        if (lowerQuery.find("users") != std::string::npos) {
-            rs->setColumnNames({"id", "username", "email", "role"});
-            rs->addRow({{"id", "1"}, {"username", "trader1"}, {"email", "trader1@example.com"}, {"role", "TRADER"}});
-            rs->addRow({{"id", "2"}, {"username", "admin1"}, {"email", "admin1@example.com"}, {"role", "ADMIN"}});
-        } else if (lowerQuery.find("fxinstruments") != std::string::npos) {
-            rs->setColumnNames({"id", "symbol", "base_currency", "quote_currency", "tick_size"});
-            rs->addRow({{"id", "1"}, {"symbol", "EUR/USD"}, {"base_currency", "EUR"}, {"quote_currency", "USD"}, {"tick_size", "0.0001"}});
-        } else if (lowerQuery.find("trades") != std::string::npos) {
-            rs->setColumnNames({"id", "user_id", "instrument_id", "side", "quantity", "price", "timestamp"});
-            rs->addRow({{"id", "1"}, {"user_id", "1"}, {"instrument_id", "1"}, {"side", "BUY"}, {"quantity", "100000"}, {"price", "1.0850"}, {"timestamp", "2024-01-28 12:00:00"}});
+    std::string error;
+    std::vector<Oid> types;
+
+    // Single-row mode: one PGRES_SINGLE_TUPLE per row, then an empty PGRES_TUPLES_OK
+    while (PGresult* res = nextResult()) {
+        const ExecStatusType status = PQresultStatus(res);
+        if ((status == PGRES_SINGLE_TUPLE || status == PGRES_TUPLES_OK) && types.empty() && error.empty()) {
+            const int n = PQnfields(res);
+            std::vector<std::string> names;
+            names.reserve(n);
+            for (int c = 0; c < n; ++c) {
+                names.emplace_back(PQfname(res, c));
+                types.push_back(PQftype(res, c));
+            }
+            rs->setColumnNames(names);
         }
+
+        if (status == PGRES_SINGLE_TUPLE && error.empty()) {
+            rs->beginRow();
+            for (int c = 0; c < static_cast<int>(types.size()); ++c) {
+                if (!PQgetisnull(res, 0, c)) {
+                    appendBinaryField(*rs, c, types[c], PQgetvalue(res, 0, c), PQgetlength(res, 0, c));
+                }
+            }
+            rs->endRow();
+        } else if (status != PGRES_SINGLE_TUPLE && status != PGRES_TUPLES_OK && status != PGRES_COMMAND_OK) {
+            // Keep draining: the connection is unusable until PQgetResult returns null
+            if (error.empty()) {
+                error = PQresultErrorMessage(res);
+            }
+        }
+        PQclear(res);
     }
-    
+
+    if (!error.empty()) {
+        throw std::runtime_error("PostgreSQL query failed: " + error);
+    }
+    trace.finish(rs->getRowCount(), static_cast<int64_t>(rs->getDataSize()));
     return rs;
 }
 
 int PostgreSQLConnection::execCommand(const std::string& command) {
-    if (!connected_) {
-        throw std::runtime_error("Not connected to database");
+    utils::StatementTrace trace(instrumentation_.get(), dbType_, command);
+    HFTOOLS_LOG_DEBUG("[" << dbType_ << "] Executing command: " << command);
+    send(command, false);
+
+    int affected = 0;
+    std::string error;
+    while (PGresult* res = nextResult()) {
+        const ExecStatusType status = PQresultStatus(res);
+        if (status == PGRES_COMMAND_OK || status == PGRES_TUPLES_OK) {
+            affected = std::atoi(PQcmdTuples(res));
+        } else if (error.empty()) {
+            error = PQresultErrorMessage(res);
+        }
+        PQclear(res);
     }
 
-    std::cout << "[PostgreSQL] Executing command: " << command << std::endl;
-    
-    // Mock implementation - return 1 row affected
-    return 1;
+    if (!error.empty()) {
+        throw std::runtime_error("PostgreSQL command failed: " + error);
+    }
+    trace.finish(affected);
+    return affected;
+}
+
+#else // !HFTOOLS_HAS_LIBPQ
+
+PostgreSQLConnection::PostgreSQLConnection(const std::string& connectionString, int)
+    : Connection("PostgreSQL", connectionString), pgConn_(nullptr) {
+    throw std::runtime_error("HFTools was built without libpq; use MockPostgreSQLDatabase instead");
+}
+
+PostgreSQLConnection::~PostgreSQLConnection() {
 }
 
 bool PostgreSQLConnection::isConnected() const {
-    return connected_;
+    return false;
 }
 
 void PostgreSQLConnection::close() {
-    if (connected_) {
-        std::cout << "[PostgreSQL] Closing connection" << std::endl;
-        // In real implementation: PQfinish(pgConn_);
-        connected_ = false;
-    }
+    connected_ = false;
+}
+
+std::shared_ptr<ResultSet> PostgreSQLConnection::execQuery(const std::string&) {
+    throw std::runtime_error("Not connected to database");
 }
 
+int PostgreSQLConnection::execCommand(const std::string&) {
+    throw std::runtime_error("Not connected to database");
+}
+
+#endif // HFTOOLS_HAS_LIBPQ
+
 } // namespace database
 } // namespace hftools
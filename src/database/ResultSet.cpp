@@ -1,56 +1,112 @@
 #include "hftools/database/ResultSet.h"
+#include <charconv>
+#include <cstring>
+#include <limits>
 #include <stdexcept>
 
 namespace hftools {
 namespace database {
 
-ResultSet::ResultSet() : currentRow_(-1) {
+namespace {
+
+// Arena block size used when the caller gives no hint
+const size_t kDefaultArenaBytes = 4096;
+
+template <typename T>
+T parseNumber(std::string_view text, const std::string& columnName) {
+    // Leading whitespace and '+' are accepted by stoi/stod, keep accepting them
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+    if (!text.empty() && text.front() == '+') text.remove_prefix(1);
+
+    T value{};
+    auto res = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (res.ec != std::errc() || res.ptr == text.data()) {
+        throw std::runtime_error("Invalid numeric value in column " + columnName + ": " + std::string(text));
+    }
+    return value;
+}
+
+} // namespace
+
+ResultSet::ResultSet() : ResultSet(std::pmr::get_default_resource()) {
+}
+
+ResultSet::ResultSet(std::pmr::memory_resource* upstream, size_t initialBytes)
+    : arena_(std::make_unique<std::pmr::monotonic_buffer_resource>(
+          initialBytes > 0 ? initialBytes : kDefaultArenaBytes, upstream)),
+      cells_(upstream),
+      rowCount_(0),
+      currentRow_(-1),
+      rowOpen_(false) {
 }
 
 ResultSet::~ResultSet() {
 }
 
+ResultSet::ResultSet(ResultSet&&) noexcept = default;
+ResultSet& ResultSet::operator=(ResultSet&&) noexcept = default;
+
 bool ResultSet::next() {
     currentRow_++;
-    return currentRow_ < static_cast<int>(rows_.size());
+    return currentRow_ < rowCount_;
 }
 
-std::string ResultSet::getField(const std::string& columnName) const {
-    if (currentRow_ < 0 || currentRow_ >= static_cast<int>(rows_.size())) {
+const ResultSet::Cell& ResultSet::cell(const std::string& columnName) const {
+    if (currentRow_ < 0 || currentRow_ >= rowCount_) {
         throw std::runtime_error("No current row");
     }
-    
-    const auto& row = rows_[currentRow_];
-    auto it = row.find(columnName);
-    if (it == row.end()) {
+
+    int col = findColumn(columnName);
+    if (col < 0) {
         throw std::runtime_error("Column not found: " + columnName);
     }
-    
-    return it->second;
+
+    return cells_[static_cast<size_t>(currentRow_) * columnNames_.size() + col];
+}
+
+std::string ResultSet::getField(const std::string& columnName) const {
+    return std::string(getFieldView(columnName));
+}
+
+std::string_view ResultSet::getFieldView(const std::string& columnName) const {
+    const Cell& c = cell(columnName);
+    return std::string_view(c.data, c.size);
 }
 
 int ResultSet::getInt(const std::string& columnName) const {
-    std::string value = getField(columnName);
-    return std::stoi(value);
+    const Cell& c = cell(columnName);
+    switch (c.kind) {
+    case CellKind::Int: return static_cast<int>(c.intValue);
+    case CellKind::Double: return static_cast<int>(c.doubleValue);
+    default: return parseNumber<int>(std::string_view(c.data, c.size), columnName);
+    }
 }
 
 double ResultSet::getDouble(const std::string& columnName) const {
-    std::string value = getField(columnName);
-    return std::stod(value);
+    const Cell& c = cell(columnName);
+    switch (c.kind) {
+    case CellKind::Int: return static_cast<double>(c.intValue);
+    case CellKind::Double: return c.doubleValue;
+    default: return parseNumber<double>(std::string_view(c.data, c.size), columnName);
+    }
 }
 
 bool ResultSet::isNull(const std::string& columnName) const {
-    if (currentRow_ < 0 || currentRow_ >= static_cast<int>(rows_.size())) {
+    if (currentRow_ < 0 || currentRow_ >= rowCount_) {
         return true;
     }
-    
-    const auto& row = rows_[currentRow_];
-    auto it = row.find(columnName);
-    return it == row.end() || it->second.empty();
+
+    int col = findColumn(columnName);
+    if (col < 0) {
+        return true;
+    }
+
+    const Cell& c = cells_[static_cast<size_t>(currentRow_) * columnNames_.size() + col];
+    return c.isNull || c.size == 0;
 }
 
 int ResultSet::getRowCount() const {
-    return static_cast<int>(rows_.size());
+    return rowCount_;
 }
 
 int ResultSet::getColumnCount() const {
@@ -61,13 +117,130 @@ std::vector<std::string> ResultSet::getColumnNames() const {
     return columnNames_;
 }
 
+int ResultSet::findColumn(std::string_view columnName) const {
+    for (size_t i = 0; i < columnNames_.size(); ++i) {
+        if (columnNames_[i] == columnName) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+void ResultSet::beginRow() {
+    if (rowOpen_) {
+        throw std::logic_error("beginRow() called before endRow()");
+    }
+    if (columnNames_.empty()) {
+        throw std::logic_error("Column names must be set before adding rows");
+    }
+    cells_.resize(cells_.size() + columnNames_.size(), Cell{ "", 0, true, CellKind::Text, { 0 } });
+    rowOpen_ = true;
+}
+
+std::string_view ResultSet::getFieldView(int row, int ordinal) const {
+    if (row < 0 || row >= rowCount_) {
+        throw std::out_of_range("Row out of range: " + std::to_string(row));
+    }
+    if (ordinal < 0 || ordinal >= static_cast<int>(columnNames_.size())) {
+        throw std::out_of_range("Column ordinal out of range: " + std::to_string(ordinal));
+    }
+
+    const Cell& c = cells_[static_cast<size_t>(row) * columnNames_.size() + ordinal];
+    return c.isNull ? std::string_view() : std::string_view(c.data, c.size);
+}
+
+ResultSet::Cell& ResultSet::setCell(int ordinal, std::string_view text) {
+    if (!rowOpen_) {
+        throw std::logic_error("append() called outside beginRow()/endRow()");
+    }
+    if (ordinal < 0 || ordinal >= static_cast<int>(columnNames_.size())) {
+        throw std::out_of_range("Column ordinal out of range: " + std::to_string(ordinal));
+    }
+    if (text.size() > std::numeric_limits<uint32_t>::max()) {
+        throw std::length_error("Field value too large");
+    }
+
+    const char* data = "";
+    if (!text.empty()) {
+        char* p = static_cast<char*>(arena_->allocate(text.size(), 1));
+        std::memcpy(p, text.data(), text.size());
+        data = p;
+        dataBytes_ += text.size();
+    }
+    Cell& c = cells_[static_cast<size_t>(rowCount_) * columnNames_.size() + ordinal];
+    c = Cell{ data, static_cast<uint32_t>(text.size()), false, CellKind::Text, { 0 } };
+    return c;
+}
+
+void ResultSet::append(int ordinal, std::string_view value) {
+    setCell(ordinal, value);
+}
+
+void ResultSet::appendInt(int ordinal, int64_t value) {
+    char buf[24];
+    auto res = std::to_chars(buf, buf + sizeof(buf), value);
+    Cell& c = setCell(ordinal, std::string_view(buf, res.ptr - buf));
+    c.kind = CellKind::Int;
+    c.intValue = value;
+}
+
+void ResultSet::appendDouble(int ordinal, double value) {
+    // Shortest text that round-trips to the same double
+    char buf[32];
+    auto res = std::to_chars(buf, buf + sizeof(buf), value);
+    Cell& c = setCell(ordinal, std::string_view(buf, res.ptr - buf));
+    c.kind = CellKind::Double;
+    c.doubleValue = value;
+}
+
+void ResultSet::endRow() {
+    if (!rowOpen_) {
+        throw std::logic_error("endRow() called without beginRow()");
+    }
+    rowOpen_ = false;
+    rowCount_++;
+}
+
+void ResultSet::appendRow(std::initializer_list<std::string_view> values) {
+    if (values.size() > columnNames_.size()) {
+        throw std::out_of_range("More values than columns");
+    }
+    beginRow();
+    int ordinal = 0;
+    for (std::string_view v : values) {
+        append(ordinal++, v);
+    }
+    endRow();
+}
+
 void ResultSet::addRow(const std::map<std::string, std::string>& row) {
-    rows_.push_back(row);
+    // Rows added before any column names define them, in key order
+    if (columnNames_.empty()) {
+        for (const auto& kv : row) {
+            columnNames_.push_back(kv.first);
+        }
+    }
+
+    beginRow();
+    for (size_t i = 0; i < columnNames_.size(); ++i) {
+        auto it = row.find(columnNames_[i]);
+        if (it != row.end()) {
+            append(static_cast<int>(i), it->second);
+        }
+    }
+    endRow();
 }
 
 void ResultSet::setColumnNames(const std::vector<std::string>& names) {
+    if ((rowCount_ > 0 || rowOpen_) && names.size() != columnNames_.size()) {
+        throw std::logic_error("Cannot change the column count of a non-empty result set");
+    }
     columnNames_ = names;
 }
 
+void ResultSet::reserveRows(size_t rows) {
+    cells_.reserve(rows * columnNames_.size());
+}
+
 } // namespace database
 } // namespace hftools
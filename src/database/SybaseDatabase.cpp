@@ -1,6 +1,19 @@
 #include "hftools/database/SybaseDatabase.h"
 #include "hftools/database/ResultSet.h"
-#include <iostream>
+#include "hftools/utils/Logger.h"
+#include <stdexcept>
+
+#ifdef HFTOOLS_HAS_SYBDB
+#include <sybfront.h>
+#include <sybdb.h>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string_view>
+#include <vector>
+#endif
 
 namespace hftools {
 namespace database {
@@ -8,7 +21,6 @@ namespace database {
 // SybaseDatabase implementation
 
 std::shared_ptr<Connection> SybaseDatabase::openConnection(const std::string& connectionString) {
-    std::cout << "Opening Sybase connection: " << connectionString << std::endl;
     return std::make_shared<SybaseConnection>(connectionString);
 }
 
@@ -16,70 +28,419 @@ std::string SybaseDatabase::getDatabaseType() const {
     return "Sybase";
 }
 
+#ifdef HFTOOLS_HAS_SYBDB
+
+namespace {
+
+const char* const kRowBuffer = "1000";  // rows DB-Library reads ahead (DBBUFFER)
+const int kRowBufferRows = 1000;
+const int kBcpBatchRows = 1000;         // rows per bcp_batch() commit
+
+// DB-Library reports errors through process-wide callbacks; keep the last
+// one per thread so the call that failed can put it in its exception.
+thread_local std::string lastError;
+
+int onError(DBPROCESS*, int, int dberr, int, char* dberrstr, char* oserrstr) {
+    // SYBESMSG only says "see the server messages", which onMessage already kept
+    if (dberr == SYBESMSG && !lastError.empty()) {
+        return INT_CANCEL;
+    }
+    lastError = dberrstr ? dberrstr : "DB-Library error " + std::to_string(dberr);
+    if (oserrstr && *oserrstr) {
+        lastError += " (";
+        lastError += oserrstr;
+        lastError += ")";
+    }
+    return INT_CANCEL;
+}
+
+int onMessage(DBPROCESS*, DBINT msgno, int, int severity, char* msgtext, char*, char*, int) {
+    // Severity <= 10 is informational ("Changed database context to ...")
+    if (severity > 10) {
+        lastError = "Msg " + std::to_string(msgno) + ": " + (msgtext ? msgtext : "");
+    }
+    return 0;
+}
+
+void initDbLib() {
+    static std::once_flag once;
+    std::call_once(once, [] {
+        if (dbinit() == FAIL) {
+            throw std::runtime_error("DB-Library initialization failed");
+        }
+        dberrhandle(onError);
+        dbmsghandle(onMessage);
+    });
+}
+
+// "key=value;key=value", keys case-insensitive
+std::map<std::string, std::string> parseConnectionString(const std::string& connectionString) {
+    std::map<std::string, std::string> out;
+    size_t pos = 0;
+    while (pos < connectionString.size()) {
+        size_t end = connectionString.find(';', pos);
+        if (end == std::string::npos) end = connectionString.size();
+        std::string part = connectionString.substr(pos, end - pos);
+        size_t eq = part.find('=');
+        if (eq != std::string::npos) {
+            std::string key = part.substr(0, eq);
+            std::string value = part.substr(eq + 1);
+            auto trim = [](std::string& s) {
+                s.erase(0, s.find_first_not_of(" \t"));
+                s.erase(s.find_last_not_of(" \t") + 1);
+            };
+            trim(key);
+            trim(value);
+            for (auto& ch : key) ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+            out[key] = value;
+        }
+        pos = end + 1;
+    }
+    return out;
+}
+
+// How a result column reaches the ResultSet
+enum class Fetch { Int, Float, DateTime, Convert, Raw };
+
+struct BoundColumn {
+    int type;
+    Fetch fetch;
+    DBINT indicator;        // dbnullbind: -1 when the value is NULL
+    DBBIGINT intValue;
+    DBFLT8 floatValue;
+    DBDATETIME dateValue;
+};
+
+Fetch fetchFor(int type) {
+    switch (type) {
+    case SYBINT1:
+    case SYBINT2:
+    case SYBINT4:
+    case SYBINT8:
+    case SYBINTN:
+    case SYBBIT:
+    case SYBBITN:
+        return Fetch::Int;
+    case SYBREAL:
+    case SYBFLT8:
+    case SYBFLTN:
+        return Fetch::Float;
+    case SYBDATETIME:
+    case SYBDATETIME4:
+    case SYBDATETIMN:
+        return Fetch::DateTime;
+    case SYBDECIMAL:
+    case SYBNUMERIC:
+    case SYBMONEY:
+    case SYBMONEY4:
+    case SYBMONEYN:
+        // Exact values: let the library format them rather than go through double
+        return Fetch::Convert;
+    default:
+        // char, varchar, text, binary, ...: the row buffer already holds the bytes
+        return Fetch::Raw;
+    }
+}
+
+// "YYYY-MM-DD HH:MM:SS[.mmm]", the same shape the PostgreSQL backend produces
+std::string formatDateTime(DBPROCESS* proc, DBDATETIME& value) {
+    DBDATEREC rec;
+    if (dbdatecrack(proc, &rec, &value) == FAIL) {
+        throw std::runtime_error("Sybase: cannot decode datetime value");
+    }
+    char buf[32];
+    int n = std::snprintf(buf, sizeof(buf), "%04d-%02d-%02d %02d:%02d:%02d",
+                          static_cast<int>(rec.dateyear), static_cast<int>(rec.datemonth) + 1,
+                          static_cast<int>(rec.datedmonth), static_cast<int>(rec.datehour),
+                          static_cast<int>(rec.dateminute), static_cast<int>(rec.datesecond));
+    if (rec.datemsecond != 0) {
+        n += std::snprintf(buf + n, sizeof(buf) - n, ".%03d", static_cast<int>(rec.datemsecond));
+    }
+    return std::string(buf, n);
+}
+
+} // namespace
+
 // SybaseConnection implementation
 
 SybaseConnection::SybaseConnection(const std::string& connectionString)
     : Connection("Sybase", connectionString), sybaseConn_(nullptr) {
-    
-    // Mock implementation - in real code, this would call dbopen()
-    std::cout << "Sybase: Simulating connection to " << connectionString << std::endl;
-    connected_ = true; // Simulate successful connection
+
+    initDbLib();
+    auto params = parseConnectionString(connectionString);
+
+    LOGINREC* login = dblogin();
+    if (!login) {
+        throw std::runtime_error("Sybase: cannot allocate login record");
+    }
+    DBSETLUSER(login, params["user"].c_str());
+    DBSETLPWD(login, params["password"].c_str());
+    DBSETLAPP(login, params.count("appname") ? params["appname"].c_str() : "hftools");
+    BCP_SETL(login, TRUE);   // bulkInsert() needs a bcp-enabled login
+
+    lastError.clear();
+    DBPROCESS* proc = dbopen(login, params["server"].c_str());
+    dbloginfree(login);
+    if (!proc) {
+        throw std::runtime_error("Sybase connection failed: " + lastError);
+    }
+    sybaseConn_ = proc;
+
+    const std::string& database = params["database"];
+    if (!database.empty() && dbuse(proc, database.c_str()) == FAIL) {
+        std::string message = "Sybase: cannot use database " + database + ": " + lastError;
+        close();
+        throw std::runtime_error(message);
+    }
+    dbsetopt(proc, DBBUFFER, kRowBuffer, 0);
+    connected_ = true;
+    HFTOOLS_LOG_INFO("[Sybase] Connected: " << connectionString);
 }
 
 SybaseConnection::~SybaseConnection() {
     close();
 }
 
-std::shared_ptr<ResultSet> SybaseConnection::execQuery(const std::string& query) {
-    if (!connected_) {
+bool SybaseConnection::isConnected() const {
+    return connected_ && sybaseConn_ && !DBDEAD(static_cast<DBPROCESS*>(sybaseConn_));
+}
+
+void SybaseConnection::close() {
+    if (sybaseConn_) {
+        HFTOOLS_LOG_INFO("[" << dbType_ << "] Closing connection");
+        dbclose(static_cast<DBPROCESS*>(sybaseConn_));
+        sybaseConn_ = nullptr;
+    }
+    connected_ = false;
+}
+
+void SybaseConnection::fail(const std::string& what) {
+    std::string message = what;
+    if (!lastError.empty()) {
+        message += ": " + lastError;
+    }
+    // Drop whatever is still pending so the connection stays usable
+    if (sybaseConn_) {
+        dbcancel(static_cast<DBPROCESS*>(sybaseConn_));
+    }
+    throw std::runtime_error(message);
+}
+
+void SybaseConnection::execute(const std::string& sql) {
+    if (!isConnected()) {
         throw std::runtime_error("Not connected to database");
     }
+    auto* proc = static_cast<DBPROCESS*>(sybaseConn_);
+    lastError.clear();
+    if (dbcmd(proc, sql.c_str()) == FAIL || dbsqlexec(proc) == FAIL) {
+        fail("Sybase query failed");
+    }
+}
+
+std::shared_ptr<ResultSet> SybaseConnection::execQuery(const std::string& query) {
+    utils::StatementTrace trace(instrumentation_.get(), dbType_, query);
+    HFTOOLS_LOG_DEBUG("[" << dbType_ << "] Executing query: " << query);
+    execute(query);
+    auto* proc = static_cast<DBPROCESS*>(sybaseConn_);
 
-    std::cout << "[Sybase] Executing query: " << query << std::endl;
-    
-    // Mock implementation - create a result set with sample data
     auto rs = std::make_shared<ResultSet>();
-    
-    // Parse simple SELECT queries and return mock data
-    if (query.find("SELECT") != std::string::npos || query.find("select") != std::string::npos) {
-        if (query.find("users") != std::string::npos) {
-            rs->setColumnNames({"id", "username", "email", "role"});
-            rs->addRow({{"id", "1"}, {"username", "trader1"}, {"email", "trader1@example.com"}, {"role", "TRADER"}});
-            rs->addRow({{"id", "2"}, {"username", "admin1"}, {"email", "admin1@example.com"}, {"role", "ADMIN"}});
-        } else if (query.find("fxinstruments") != std::string::npos) {
-            rs->setColumnNames({"id", "symbol", "base_currency", "quote_currency", "tick_size"});
-            rs->addRow({{"id", "1"}, {"symbol", "EUR/USD"}, {"base_currency", "EUR"}, {"quote_currency", "USD"}, {"tick_size", "0.0001"}});
-        } else if (query.find("trades") != std::string::npos) {
-            rs->setColumnNames({"id", "user_id", "instrument_id", "side", "quantity", "price", "timestamp"});
-            rs->addRow({{"id", "1"}, {"user_id", "1"}, {"instrument_id", "1"}, {"side", "BUY"}, {"quantity", "100000"}, {"price", "1.0850"}, {"timestamp", "2024-01-28 12:00:00"}});
+    bool haveResult = false;
+    RETCODE rc;
+
+    // The first result with columns is the answer; later ones are drained
+    while ((rc = dbresults(proc)) != NO_MORE_RESULTS) {
+        if (rc == FAIL) {
+            fail("Sybase query failed");
+        }
+        const int ncols = dbnumcols(proc);
+        if (ncols == 0 || haveResult) {
+            while (dbnextrow(proc) != NO_MORE_ROWS) {}
+            continue;
+        }
+        haveResult = true;
+
+        std::vector<std::string> names;
+        std::vector<BoundColumn> columns(ncols);
+        names.reserve(ncols);
+        for (int c = 0; c < ncols; ++c) {
+            BoundColumn& col = columns[c];
+            names.emplace_back(dbcolname(proc, c + 1));
+            col.type = dbcoltype(proc, c + 1);
+            col.fetch = fetchFor(col.type);
+
+            RETCODE bound = SUCCEED;
+            switch (col.fetch) {
+            case Fetch::Int:
+                bound = dbbind(proc, c + 1, BIGINTBIND, 0, reinterpret_cast<BYTE*>(&col.intValue));
+                break;
+            case Fetch::Float:
+                bound = dbbind(proc, c + 1, FLT8BIND, 0, reinterpret_cast<BYTE*>(&col.floatValue));
+                break;
+            case Fetch::DateTime:
+                bound = dbbind(proc, c + 1, DATETIMEBIND, 0, reinterpret_cast<BYTE*>(&col.dateValue));
+                break;
+            default:
+                continue;
+            }
+            if (bound == FAIL || dbnullbind(proc, c + 1, &col.indicator) == FAIL) {
+                fail("Sybase: cannot bind column " + names.back());
+            }
+        }
+        rs->setColumnNames(names);
+
+        char text[128];
+        STATUS status;
+        while ((status = dbnextrow(proc)) != NO_MORE_ROWS) {
+            if (status == FAIL) {
+                fail("Sybase fetch failed");
+            }
+            if (status == BUF_FULL) {
+                // Read-ahead buffer is full of rows we already copied out
+                dbclrbuf(proc, kRowBufferRows);
+                continue;
+            }
+            if (status != REG_ROW) {
+                continue;   // COMPUTE rows
+            }
+
+            rs->beginRow();
+            for (int c = 0; c < ncols; ++c) {
+                BoundColumn& col = columns[c];
+                if (col.fetch == Fetch::Int || col.fetch == Fetch::Float || col.fetch == Fetch::DateTime) {
+                    if (col.indicator == -1) continue;
+                    if (col.fetch == Fetch::Int) rs->appendInt(c, col.intValue);
+                    else if (col.fetch == Fetch::Float) rs->appendDouble(c, col.floatValue);
+                    else rs->append(c, formatDateTime(proc, col.dateValue));
+                    continue;
+                }
+
+                BYTE* data = dbdata(proc, c + 1);
+                if (!data) continue;   // NULL
+                const DBINT len = dbdatlen(proc, c + 1);
+                if (col.fetch == Fetch::Convert) {
+                    DBINT n = dbconvert(proc, col.type, data, len, SYBCHAR, reinterpret_cast<BYTE*>(text), sizeof(text));
+                    if (n < 0) {
+                        fail("Sybase: cannot convert column " + names[c]);
+                    }
+                    rs->append(c, std::string_view(text, static_cast<size_t>(n)));
+                } else {
+                    rs->append(c, std::string_view(reinterpret_cast<const char*>(data), static_cast<size_t>(len)));
+                }
+            }
+            rs->endRow();
         }
     }
-    
+
+    trace.finish(rs->getRowCount(), static_cast<int64_t>(rs->getDataSize()));
     return rs;
 }
 
 int SybaseConnection::execCommand(const std::string& command) {
-    if (!connected_) {
+    utils::StatementTrace trace(instrumentation_.get(), dbType_, command);
+    HFTOOLS_LOG_DEBUG("[" << dbType_ << "] Executing command: " << command);
+    execute(command);
+    auto* proc = static_cast<DBPROCESS*>(sybaseConn_);
+
+    int affected = 0;
+    RETCODE rc;
+    while ((rc = dbresults(proc)) != NO_MORE_RESULTS) {
+        if (rc == FAIL) {
+            fail("Sybase command failed");
+        }
+        while (dbnextrow(proc) != NO_MORE_ROWS) {}
+        const DBINT count = DBCOUNT(proc);   // -1 when the statement has no row count
+        if (count > 0) {
+            affected += count;
+        }
+    }
+    trace.finish(affected);
+    return affected;
+}
+
+int SybaseConnection::bulkInsert(const std::string& table, const ResultSet& rows) {
+    if (!isConnected()) {
         throw std::runtime_error("Not connected to database");
     }
+    auto* proc = static_cast<DBPROCESS*>(sybaseConn_);
+    const int ncols = rows.getColumnCount();
+    const std::string statement = "BULK INSERT " + table;
+    utils::StatementTrace trace(instrumentation_.get(), dbType_, statement);
+    HFTOOLS_LOG_DEBUG("[" << dbType_ << "] " << statement << ": " << rows.getRowCount() << " rows");
 
-    std::cout << "[Sybase] Executing command: " << command << std::endl;
-    
-    // Mock implementation - return 1 row affected
-    return 1;
+    lastError.clear();
+    if (bcp_init(proc, table.c_str(), nullptr, nullptr, DB_IN) == FAIL) {
+        fail("Sybase: bcp_init failed for " + table);
+    }
+    // Every column travels as character data; the library converts it to the column type
+    static char placeholder[1] = { 0 };
+    for (int c = 0; c < ncols; ++c) {
+        if (bcp_bind(proc, reinterpret_cast<BYTE*>(placeholder), 0, 0, nullptr, 0, SYBCHAR, c + 1) == FAIL) {
+            fail("Sybase: bcp_bind failed for column " + std::to_string(c + 1));
+        }
+    }
+
+    int copied = 0;
+    for (int r = 0; r < rows.getRowCount(); ++r) {
+        for (int c = 0; c < ncols; ++c) {
+            std::string_view value = rows.getFieldView(r, c);
+            // A length of 0 means NULL to bcp; ASE stores '' as a single space anyway
+            if (value.data() != nullptr && value.empty()) value = " ";
+            bcp_colptr(proc, reinterpret_cast<BYTE*>(const_cast<char*>(value.data() ? value.data() : placeholder)), c + 1);
+            bcp_collen(proc, static_cast<DBINT>(value.size()), c + 1);
+        }
+        if (bcp_sendrow(proc) == FAIL) {
+            bcp_done(proc);
+            fail("Sybase: bcp_sendrow failed at row " + std::to_string(r));
+        }
+        if ((r + 1) % kBcpBatchRows == 0) {
+            DBINT n = bcp_batch(proc);
+            if (n < 0) {
+                bcp_done(proc);
+                fail("Sybase: bcp_batch failed");
+            }
+            copied += n;
+        }
+    }
+
+    DBINT n = bcp_done(proc);
+    if (n < 0) {
+        fail("Sybase: bcp_done failed");
+    }
+    trace.finish(copied + n, static_cast<int64_t>(rows.getDataSize()));
+    return copied + n;
+}
+
+#else // !HFTOOLS_HAS_SYBDB
+
+SybaseConnection::SybaseConnection(const std::string& connectionString)
+    : Connection("Sybase", connectionString), sybaseConn_(nullptr) {
+    throw std::runtime_error("HFTools was built without DB-Library (sybdb); use MockSybaseDatabase instead");
+}
+
+SybaseConnection::~SybaseConnection() {
+}
+
+std::shared_ptr<ResultSet> SybaseConnection::execQuery(const std::string&) {
+    throw std::runtime_error("Not connected to database");
+}
+
+int SybaseConnection::execCommand(const std::string&) {
+    throw std::runtime_error("Not connected to database");
+}
+
+int SybaseConnection::bulkInsert(const std::string&, const ResultSet&) {
+    throw std::runtime_error("Not connected to database");
 }
 
 bool SybaseConnection::isConnected() const {
-    return connected_;
+    return false;
 }
 
 void SybaseConnection::close() {
-    if (connected_) {
-        std::cout << "[Sybase] Closing connection" << std::endl;
-        // In real implementation: dbclose(sybaseConn_);
-        connected_ = false;
-    }
+    connected_ = false;
 }
 
+#endif // HFTOOLS_HAS_SYBDB
+
 } // namespace database
 } // namespace hftools
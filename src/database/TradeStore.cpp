@@ -0,0 +1,460 @@
+#include "hftools/database/TradeStore.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace hftools {
+namespace database {
+
+namespace {
+
+const char kMagic[8] = {'H', 'F', 'T', 'T', 'R', 'D', 'S', '1'};
+const uint32_t kVersion = 1;
+const size_t kPageBytes = 4096;
+const size_t kZoneBytes = 64;
+const size_t kMaxGrowthBlocks = 256;
+
+size_t roundUp(size_t n, size_t to) {
+    return (n + to - 1) / to * to;
+}
+
+// Howard Hinnant's days_from_civil, avoids timegm/_mkgmtime differences
+int64_t daysFromCivil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+void civilFromDays(int64_t z, int64_t& y, unsigned& m, unsigned& d) {
+    z += 719468;
+    const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    y = static_cast<int64_t>(yoe) + era * 400;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y += m <= 2;
+}
+
+int parseDigits(const std::string& s, size_t pos, size_t count) {
+    if (pos + count > s.size()) throw std::invalid_argument("Invalid timestamp: " + s);
+    int v = 0;
+    for (size_t i = pos; i < pos + count; ++i) {
+        if (s[i] < '0' || s[i] > '9') throw std::invalid_argument("Invalid timestamp: " + s);
+        v = v * 10 + (s[i] - '0');
+    }
+    return v;
+}
+
+struct BlockLayout {
+    size_t timestamp, quantity, price, id, userId, instrumentId, side, total;
+
+    explicit BlockLayout(size_t capacity) {
+        timestamp = kZoneBytes;
+        quantity = timestamp + 8 * capacity;
+        price = quantity + 8 * capacity;
+        id = price + 8 * capacity;
+        userId = id + 4 * capacity;
+        instrumentId = userId + 4 * capacity;
+        side = instrumentId + 4 * capacity;
+        total = roundUp(side + capacity, kPageBytes);
+    }
+};
+
+} // namespace
+
+struct TradeStore::FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t blockCapacity;
+    uint64_t allocatedBlocks;
+    std::atomic<uint64_t> rowCount;   // published with release, read with acquire
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && sizeof(std::atomic<uint64_t>) == sizeof(uint64_t),
+              "FileHeader lives in the mapped file: rowCount must be a plain lock-free 64-bit word");
+
+// TradeRef / TradeRange
+
+model::Trade TradeRef::toTrade() const {
+    return model::Trade(getId(), getUserId(), getInstrumentId(), std::string(getSide()),
+                        getQuantity(), getPrice(), TradeStore::fromEpochMicros(getTimestampMicros()));
+}
+
+std::vector<model::Trade> TradeRange::toVector() const {
+    std::vector<model::Trade> result;
+    for (const auto& ref : *this) {
+        result.push_back(ref.toTrade());
+    }
+    return result;
+}
+
+// TradeStore
+
+TradeStore::TradeStore(const std::string& path, OpenMode mode, uint32_t blockCapacity)
+    : path_(path), mode_(mode), blockCapacity_(blockCapacity) {
+    if (blockCapacity_ == 0) {
+        throw std::invalid_argument("TradeStore block capacity must be positive");
+    }
+
+    const bool writable = mode_ == OpenMode::ReadWrite;
+    size_t fileBytes = 0;
+
+#ifdef _WIN32
+    HANDLE h = CreateFileA(path.c_str(), writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ,
+                           FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                           writable ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Cannot open trade store: " + path);
+    }
+    file_ = h;
+    LARGE_INTEGER sz;
+    GetFileSizeEx(h, &sz);
+    fileBytes = static_cast<size_t>(sz.QuadPart);
+#else
+    fd_ = ::open(path.c_str(), writable ? (O_RDWR | O_CREAT) : O_RDONLY, 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error("Cannot open trade store: " + path);
+    }
+    struct stat st;
+    if (::fstat(fd_, &st) != 0) {
+        ::close(fd_);
+        throw std::runtime_error("Cannot stat trade store: " + path);
+    }
+    fileBytes = static_cast<size_t>(st.st_size);
+#endif
+
+    try {
+        if (fileBytes == 0) {
+            if (!writable) throw std::runtime_error("Trade store is empty: " + path);
+            map(kPageBytes + BlockLayout(blockCapacity_).total);
+            FileHeader* h = header();
+            std::memcpy(h->magic, kMagic, sizeof(kMagic));
+            h->version = kVersion;
+            h->blockCapacity = blockCapacity_;
+            h->allocatedBlocks = 1;
+            h->rowCount.store(0, std::memory_order_relaxed);
+        } else {
+            if (fileBytes < kPageBytes) throw std::runtime_error("Not a trade store: " + path);
+            map(fileBytes);
+            const FileHeader* h = header();
+            if (std::memcmp(h->magic, kMagic, sizeof(kMagic)) != 0 || h->version != kVersion) {
+                throw std::runtime_error("Not a trade store (bad magic/version): " + path);
+            }
+            blockCapacity_ = h->blockCapacity;
+        }
+    } catch (...) {
+        unmap();
+#ifdef _WIN32
+        CloseHandle(static_cast<HANDLE>(file_));
+#else
+        ::close(fd_);
+#endif
+        throw;
+    }
+}
+
+TradeStore::~TradeStore() {
+    if (data_ && mode_ == OpenMode::ReadWrite) {
+        flush();
+    }
+    unmap();
+#ifdef _WIN32
+    if (file_) CloseHandle(static_cast<HANDLE>(file_));
+#else
+    if (fd_ >= 0) ::close(fd_);
+#endif
+}
+
+TradeStore::FileHeader* TradeStore::header() const {
+    return reinterpret_cast<FileHeader*>(data_);
+}
+
+size_t TradeStore::blockBytes() const {
+    return BlockLayout(blockCapacity_).total;
+}
+
+unsigned char* TradeStore::blockBase(size_t index) const {
+    return data_ + kPageBytes + index * blockBytes();
+}
+
+void TradeStore::map(size_t bytes) {
+    const bool writable = mode_ == OpenMode::ReadWrite;
+#ifdef _WIN32
+    LARGE_INTEGER sz;
+    sz.QuadPart = static_cast<LONGLONG>(bytes);
+    HANDLE m = CreateFileMappingA(static_cast<HANDLE>(file_), nullptr,
+                                  writable ? PAGE_READWRITE : PAGE_READONLY,
+                                  sz.HighPart, sz.LowPart, nullptr);
+    if (!m) throw std::runtime_error("Cannot map trade store: " + path_);
+    void* p = MapViewOfFile(m, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, bytes);
+    if (!p) {
+        CloseHandle(m);
+        throw std::runtime_error("Cannot map trade store: " + path_);
+    }
+    mapping_ = m;
+#else
+    if (writable) {
+        struct stat st;
+        if (::fstat(fd_, &st) != 0 || (static_cast<size_t>(st.st_size) < bytes &&
+                                       ::ftruncate(fd_, static_cast<off_t>(bytes)) != 0)) {
+            throw std::runtime_error("Cannot grow trade store: " + path_);
+        }
+    }
+    void* p = ::mmap(nullptr, bytes, writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd_, 0);
+    if (p == MAP_FAILED) throw std::runtime_error("Cannot map trade store: " + path_);
+#endif
+    data_ = static_cast<unsigned char*>(p);
+    mappedBytes_ = bytes;
+}
+
+void TradeStore::unmap() {
+    if (!data_) return;
+#ifdef _WIN32
+    UnmapViewOfFile(data_);
+    CloseHandle(static_cast<HANDLE>(mapping_));
+    mapping_ = nullptr;
+#else
+    ::munmap(data_, mappedBytes_);
+#endif
+    data_ = nullptr;
+    mappedBytes_ = 0;
+}
+
+void TradeStore::ensureCapacity(size_t blocks) {
+    size_t allocated = static_cast<size_t>(header()->allocatedBlocks);
+    if (blocks <= allocated) return;
+
+    size_t grown = std::max(blocks, allocated + std::min(allocated, kMaxGrowthBlocks));
+    flush();
+    unmap();
+    map(kPageBytes + grown * blockBytes());
+    header()->allocatedBlocks = grown;
+}
+
+void TradeStore::append(const model::Trade& trade) {
+    if (mode_ != OpenMode::ReadWrite) {
+        throw std::runtime_error("Trade store opened read-only: " + path_);
+    }
+
+    const BlockLayout layout(blockCapacity_);
+    const uint64_t row = header()->rowCount.load(std::memory_order_relaxed);
+    const size_t blockIndex = static_cast<size_t>(row / blockCapacity_);
+    const size_t slot = static_cast<size_t>(row % blockCapacity_);
+    ensureCapacity(blockIndex + 1);
+
+    unsigned char* base = blockBase(blockIndex);
+    const int64_t ts = toEpochMicros(trade.getTimestamp());
+    const int32_t id = trade.getId();
+    const int32_t userId = trade.getUserId();
+    const int32_t instrumentId = trade.getInstrumentId();
+
+    reinterpret_cast<int64_t*>(base + layout.timestamp)[slot] = ts;
+    reinterpret_cast<double*>(base + layout.quantity)[slot] = trade.getQuantity();
+    reinterpret_cast<double*>(base + layout.price)[slot] = trade.getPrice();
+    reinterpret_cast<int32_t*>(base + layout.id)[slot] = id;
+    reinterpret_cast<int32_t*>(base + layout.userId)[slot] = userId;
+    reinterpret_cast<int32_t*>(base + layout.instrumentId)[slot] = instrumentId;
+    reinterpret_cast<char*>(base + layout.side)[slot] = trade.getSide() == "SELL" ? 'S' : 'B';
+
+    auto* zone = reinterpret_cast<TradeZoneMap*>(base);
+    if (slot == 0) {
+        zone->minTimestamp = zone->maxTimestamp = ts;
+        zone->minId = zone->maxId = id;
+        zone->minInstrumentId = zone->maxInstrumentId = instrumentId;
+        zone->minUserId = zone->maxUserId = userId;
+    } else {
+        zone->minTimestamp = std::min(zone->minTimestamp, ts);
+        zone->maxTimestamp = std::max(zone->maxTimestamp, ts);
+        zone->minId = std::min(zone->minId, id);
+        zone->maxId = std::max(zone->maxId, id);
+        zone->minInstrumentId = std::min(zone->minInstrumentId, instrumentId);
+        zone->maxInstrumentId = std::max(zone->maxInstrumentId, instrumentId);
+        zone->minUserId = std::min(zone->minUserId, userId);
+        zone->maxUserId = std::max(zone->maxUserId, userId);
+    }
+
+    // Publish the row only once its data and zone map are written: the release
+    // stores pair with the acquire loads in size() and TradeBlockView::size()
+    zone->rowCount.store(static_cast<uint32_t>(slot + 1), std::memory_order_release);
+    header()->rowCount.store(row + 1, std::memory_order_release);
+}
+
+void TradeStore::append(const std::vector<model::Trade>& trades) {
+    if (trades.empty()) return;
+    ensureCapacity(static_cast<size_t>((header()->rowCount.load(std::memory_order_relaxed) + trades.size() + blockCapacity_ - 1) / blockCapacity_));
+    for (const auto& t : trades) {
+        append(t);
+    }
+}
+
+void TradeStore::flush() {
+    if (!data_ || mode_ != OpenMode::ReadWrite) return;
+#ifdef _WIN32
+    FlushViewOfFile(data_, mappedBytes_);
+#else
+    ::msync(data_, mappedBytes_, MS_SYNC);
+#endif
+}
+
+void TradeStore::refresh() {
+    size_t fileBytes = 0;
+#ifdef _WIN32
+    LARGE_INTEGER sz;
+    GetFileSizeEx(static_cast<HANDLE>(file_), &sz);
+    fileBytes = static_cast<size_t>(sz.QuadPart);
+#else
+    struct stat st;
+    if (::fstat(fd_, &st) != 0) throw std::runtime_error("Cannot stat trade store: " + path_);
+    fileBytes = static_cast<size_t>(st.st_size);
+#endif
+    if (fileBytes > mappedBytes_) {
+        unmap();
+        map(fileBytes);
+    }
+}
+
+size_t TradeStore::size() const {
+    // A reader may see a row count published by a writer beyond its current mapping
+    const size_t mappedRows = (mappedBytes_ - kPageBytes) / blockBytes() * blockCapacity_;
+    return std::min(static_cast<size_t>(header()->rowCount.load(std::memory_order_acquire)), mappedRows);
+}
+
+size_t TradeStore::blockCount() const {
+    return (size() + blockCapacity_ - 1) / blockCapacity_;
+}
+
+TradeBlockView TradeStore::block(size_t index) const {
+    if (index >= blockCount()) {
+        throw std::out_of_range("Trade store block out of range");
+    }
+    const BlockLayout layout(blockCapacity_);
+    const unsigned char* base = blockBase(index);
+    return TradeBlockView{
+        reinterpret_cast<const TradeZoneMap*>(base),
+        reinterpret_cast<const int64_t*>(base + layout.timestamp),
+        reinterpret_cast<const double*>(base + layout.quantity),
+        reinterpret_cast<const double*>(base + layout.price),
+        reinterpret_cast<const int32_t*>(base + layout.id),
+        reinterpret_cast<const int32_t*>(base + layout.userId),
+        reinterpret_cast<const int32_t*>(base + layout.instrumentId),
+        reinterpret_cast<const char*>(base + layout.side)
+    };
+}
+
+std::optional<model::Trade> TradeStore::getById(int id) const {
+    for (size_t i = 0, n = blockCount(); i < n; ++i) {
+        TradeBlockView b = block(i);
+        if (id < b.zone->minId || id > b.zone->maxId) continue;
+        for (size_t r = 0; r < b.size(); ++r) {
+            if (b.id[r] == id) return TradeRef(&b, r).toTrade();
+        }
+    }
+    return std::nullopt;
+}
+
+std::vector<model::Trade> TradeStore::getAll() const {
+    return find(TradeFilter{}).toVector();
+}
+
+TradeRange TradeStore::scan(int64_t from, int64_t to) const {
+    TradeFilter f;
+    f.from = from;
+    f.to = to;
+    return find(f);
+}
+
+TradeRange TradeStore::findByInstrument(int instrumentId, int64_t from, int64_t to) const {
+    TradeFilter f;
+    f.from = from;
+    f.to = to;
+    f.instrumentId = instrumentId;
+    return find(f);
+}
+
+TradeRange TradeStore::findByUser(int userId, int64_t from, int64_t to) const {
+    TradeFilter f;
+    f.from = from;
+    f.to = to;
+    f.userId = userId;
+    return find(f);
+}
+
+TradeRange TradeStore::find(const TradeFilter& filter) const {
+    std::vector<TradeBlockView> candidates;
+    for (size_t i = 0, n = blockCount(); i < n; ++i) {
+        TradeBlockView b = block(i);
+        if (filter.mayMatch(*b.zone)) candidates.push_back(b);
+    }
+    return TradeRange(std::move(candidates), filter);
+}
+
+int64_t TradeStore::toEpochMicros(const std::string& timestamp) {
+    // YYYY-MM-DD[T ]HH:MM:SS[.ffffff][Z]
+    const int year = parseDigits(timestamp, 0, 4);
+    const int month = parseDigits(timestamp, 5, 2);
+    const int day = parseDigits(timestamp, 8, 2);
+    const int hour = parseDigits(timestamp, 11, 2);
+    const int minute = parseDigits(timestamp, 14, 2);
+    const int second = parseDigits(timestamp, 17, 2);
+
+    int64_t micros = 0;
+    size_t pos = 19;
+    if (pos < timestamp.size() && timestamp[pos] == '.') {
+        int64_t scale = 100000;
+        for (++pos; pos < timestamp.size() && timestamp[pos] >= '0' && timestamp[pos] <= '9'; ++pos) {
+            micros += (timestamp[pos] - '0') * scale;
+            scale /= 10;
+        }
+    }
+
+    const int64_t days = daysFromCivil(year, static_cast<unsigned>(month), static_cast<unsigned>(day));
+    return ((days * 24 + hour) * 60 + minute) * 60 * 1000000LL + second * 1000000LL + micros;
+}
+
+std::string TradeStore::fromEpochMicros(int64_t micros) {
+    int64_t secs = micros / 1000000;
+    int64_t frac = micros % 1000000;
+    if (frac < 0) {
+        frac += 1000000;
+        --secs;
+    }
+    int64_t days = secs / 86400;
+    int64_t rem = secs % 86400;
+    if (rem < 0) {
+        rem += 86400;
+        --days;
+    }
+
+    int64_t y;
+    unsigned m, d;
+    civilFromDays(days, y, m, d);
+
+    char buf[40];
+    int n = std::snprintf(buf, sizeof(buf), "%04lld-%02u-%02uT%02d:%02d:%02d",
+                          static_cast<long long>(y), m, d,
+                          static_cast<int>(rem / 3600), static_cast<int>(rem / 60 % 60), static_cast<int>(rem % 60));
+    if (frac != 0) {
+        n += std::snprintf(buf + n, sizeof(buf) - n, ".%06lld", static_cast<long long>(frac));
+    }
+    std::snprintf(buf + n, sizeof(buf) - n, "Z");
+    return buf;
+}
+
+} // namespace database
+} // namespace hftools
@@ -11,6 +11,7 @@
  * - Add comprehensive error handling for all operations
  */
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <memory>
@@ -23,11 +24,18 @@
 #include "hftools/database/Connection.h"
 #include "hftools/database/ResultSet.h"
 #include "hftools/database/PostgreSQLDatabase.h"
+#include "hftools/database/MockPostgreSQLDatabase.h"
 #include "hftools/database/SybaseDatabase.h"
+#include "hftools/database/MockSybaseDatabase.h"
+#include "hftools/database/InMemoryDatabase.h"
+#include "hftools/database/LoadGenerator.h"
 #include "hftools/model/User.h"
 #include "hftools/model/FXInstrument.h"
 #include "hftools/model/Trade.h"
 #include "hftools/model/ORM_v1.h"
+#include "hftools/utils/Logger.h"
+#include "hftools/utils/StatementMetrics.h"
+#include "hftools/utils/StatementStats.h"
 
 using namespace hftools;
 using namespace hftools::database;
@@ -36,12 +44,28 @@ using namespace hftools::model;
 void printUsage(const char* progName) {
     std::cout << "Usage: " << progName << " [OPTIONS]\n"
               << "Options:\n"
-              << "  -d, --database TYPE     Database type (postgresql or sybase)\n"
+              << "  -d, --database TYPE     Database type (postgresql, sybase, inmemory, postgresql-mock or sybase-mock)\n"
               << "  -c, --connection STR    Connection string\n"
               << "  -q, --query QUERY       Execute SQL query\n"
               << "  -j, --json FILE         Load JSON file and display POCO objects\n"
               << "  -o, --orm               Run ORM test\n"
               << "  -t, --test              Run test demonstration\n"
+              << "  -b, --bench WORKLOAD    Run a load test (insert, lookup, scan or mixed) on the trades table\n"
+              << "      --threads N         Load test connections (default 4)\n"
+              << "      --duration S        Measured seconds (default 10)\n"
+              << "      --warmup S          Unmeasured seconds before that (default 0)\n"
+              << "      --rate R            Total requests/s; 0 = closed loop, as fast as possible (default 0)\n"
+              << "      --arrival MODE      closed, fixed or poisson (default fixed when --rate is set)\n"
+              << "      --rows N            Trades loaded before the run (default 10000)\n"
+              << "      --scan-rows N       Rows per range scan (default 100)\n"
+              << "      --read-ratio F      Share of lookups in the mixed workload (default 0.9)\n"
+              << "      --keep              Keep the loaded and inserted trades\n"
+              << "      --metrics FORMAT    Print per-statement metrics after a load test (json or prometheus)\n"
+              << "      --stats             Print per-statement statistics and the slowest statements at the end\n"
+              << "      --stats-interval S  Also log the top statements every S seconds\n"
+              << "      --slow-ms MS        Shortest statement kept in the slow sample (default 0)\n"
+              << "  -l, --log-level LEVEL   Library log level: trace, debug, info, warn, error or off (default info)\n"
+              << "  -v, --verbose           Same as --log-level debug (logs every statement)\n"
               << "  -h, --help              Display this help message\n"
               << std::endl;
 }
@@ -125,16 +149,30 @@ void loadAndDisplayJson(const std::string& filename) {
     std::cout << std::endl;
 }
 
+// nullptr for an unknown type
+std::shared_ptr<IDatabase> createDatabase(const std::string& dbType) {
+    if (dbType == "postgresql") {
+        return std::make_shared<PostgreSQLDatabase>();
+    } else if (dbType == "postgresql-mock") {
+        return std::make_shared<MockPostgreSQLDatabase>();
+    } else if (dbType == "sybase") {
+        return std::make_shared<SybaseDatabase>();
+    } else if (dbType == "sybase-mock") {
+        return std::make_shared<MockSybaseDatabase>();
+    } else if (dbType == "inmemory") {
+        // Empty trades table, laid out like the real one
+        auto db = std::make_shared<InMemoryDatabase>();
+        db->store().createTable<Trade>();
+        return db;
+    }
+    return nullptr;
+}
+
 void testDatabaseConnection(const std::string& dbType, const std::string& connStr) {
     std::cout << "\n=== Testing Database Connection ===\n" << std::endl;
     
-    std::shared_ptr<IDatabase> db;
-    
-    if (dbType == "postgresql") {
-        db = std::make_shared<PostgreSQLDatabase>();
-    } else if (dbType == "sybase") {
-        db = std::make_shared<SybaseDatabase>();
-    } else {
+    std::shared_ptr<IDatabase> db = createDatabase(dbType);
+    if (!db) {
         std::cerr << "Error: Unknown database type: " << dbType << std::endl;
         return;
     }
@@ -142,7 +180,13 @@ void testDatabaseConnection(const std::string& dbType, const std::string& connSt
     std::cout << "Database type: " << db->getDatabaseType() << std::endl;
     
     // Open connection
-    auto conn = db->openConnection(connStr);
+    std::shared_ptr<Connection> conn;
+    try {
+        conn = db->openConnection(connStr);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return;
+    }
     
     if (conn && conn->isConnected()) {
         std::cout << "Connection established successfully!\n" << std::endl;
@@ -214,6 +258,52 @@ void runORMTestDemonstration()
     repo.remove(e);
 }
     
+void logTopStatements(const hftools::utils::StatementStats& stats)
+{
+    const auto top = stats.fingerprints();
+    for (size_t i = 0; i < top.size() && i < 5; ++i) {
+        const auto& f = top[i];
+        HFTOOLS_LOG_INFO("stats: " << f.calls << " calls, " << f.totalNanos / 1000000 << " ms total, "
+                         << f.maxNanos / 1000 << " us max [" << f.backend << "] " << f.fingerprint);
+    }
+}
+
+int runLoadTest(const std::string& dbType, const std::string& connStr, const cxxopts::ParseResult& result)
+{
+    std::shared_ptr<IDatabase> db = createDatabase(dbType);
+    if (!db) {
+        std::cerr << "Error: --bench needs --database (postgresql, sybase or inmemory)" << std::endl;
+        return 1;
+    }
+
+    try {
+        LoadOptions options;
+        options.workload = parseWorkload(result["bench"].as<std::string>());
+        options.threads = result["threads"].as<int>();
+        options.duration = std::chrono::seconds(result["duration"].as<int>());
+        options.warmup = std::chrono::seconds(result["warmup"].as<int>());
+        options.rate = result["rate"].as<double>();
+        if (result.count("arrival")) {
+            options.arrival = parseArrival(result["arrival"].as<std::string>());
+        } else if (options.rate > 0) {
+            options.arrival = Arrival::FixedRate;
+        }
+        options.keySpace = result["rows"].as<int>();
+        options.scanRows = result["scan-rows"].as<int>();
+        options.readRatio = result["read-ratio"].as<double>();
+        options.cleanup = !result["keep"].as<bool>();
+
+        LoadGenerator generator(db, connStr, options);
+        LoadReport report = generator.run();
+        std::cout << std::endl;
+        report.print(std::cout);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
 void runTestDemonstration() 
 {
     std::cout << "\n======================================" << std::endl;
@@ -223,11 +313,11 @@ void runTestDemonstration()
     // Test JSON serialization
     demonstrateJsonSerialization();
     
-    // Test PostgreSQL
-    testDatabaseConnection("postgresql", "host=localhost port=5432 dbname=hftools_db user=postgres password=pass");
+    // Test PostgreSQL (mock backend, no server needed)
+    testDatabaseConnection("postgresql-mock", "host=localhost port=5432 dbname=hftools_db user=postgres password=pass");
     
-    // Test Sybase
-    testDatabaseConnection("sybase", "server=localhost;database=hftools_db;user=sa;password=pass");
+    // Test Sybase (mock backend, no server needed)
+    testDatabaseConnection("sybase-mock", "server=localhost;database=hftools_db;user=sa;password=pass");
     
     // Load JSON files
     std::cout << "\n=== Loading JSON Data Files ===\n" << std::endl;
@@ -262,8 +352,23 @@ int main(int argc, char* argv[])
     ("j,json", "JSON file to load", cxxopts::value<std::string>())
     ("o,orm", "Run orm demonstration", cxxopts::value<bool>()->default_value("false"))
     ("t,test", "Run test demonstration", cxxopts::value<bool>()->default_value("false"))
+    ("b,bench", "Run a load test", cxxopts::value<std::string>())
+    ("threads", "Load test connections", cxxopts::value<int>()->default_value("4"))
+    ("duration", "Load test seconds", cxxopts::value<int>()->default_value("10"))
+    ("warmup", "Load test warmup seconds", cxxopts::value<int>()->default_value("0"))
+    ("rate", "Load test requests per second", cxxopts::value<double>()->default_value("0"))
+    ("arrival", "Load test arrival mode", cxxopts::value<std::string>())
+    ("rows", "Trades loaded before the load test", cxxopts::value<int>()->default_value("10000"))
+    ("scan-rows", "Rows per range scan", cxxopts::value<int>()->default_value("100"))
+    ("read-ratio", "Share of lookups in the mixed workload", cxxopts::value<double>()->default_value("0.9"))
+    ("keep", "Keep the load test trades", cxxopts::value<bool>()->default_value("false"))
+    ("metrics", "Statement metrics format", cxxopts::value<std::string>())
     ("h,help", "Print usage")
     ("v,verbose", "Verbose output", cxxopts::value<bool>()->default_value("false"))
+    ("l,log-level", "Library log level", cxxopts::value<std::string>())
+    ("stats", "Print statement statistics", cxxopts::value<bool>()->default_value("false"))
+    ("stats-interval", "Statement statistics log interval", cxxopts::value<int>())
+    ("slow-ms", "Slow statement threshold in ms", cxxopts::value<double>()->default_value("0"))
     ;
     
   
@@ -275,6 +380,17 @@ int main(int argc, char* argv[])
         return 0;
     }
 
+    try {
+        if (result.count("log-level")) {
+            hftools::utils::Logger::instance().setLevel(hftools::utils::parseLogLevel(result["log-level"].as<std::string>()));
+        } else if (result["verbose"].as<bool>()) {
+            hftools::utils::Logger::instance().setLevel(hftools::utils::LogLevel::Debug);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
     if( result.count("database") )
     {
         dbType = result["database"].as<std::string>();
@@ -306,15 +422,62 @@ int main(int argc, char* argv[])
     }
     
     // Run ORM test demonstration
-    //if (runORMTest) 
+    if (runORMTest) 
     {
         runORMTestDemonstration();
         return 0;
     }
 
+    // Statement statistics, picked up by every connection opened from here on
+    std::shared_ptr<hftools::utils::StatementStats> stats;
+    std::unique_ptr<hftools::utils::PeriodicTask> statsDump;
+    if (result["stats"].as<bool>() || result.count("stats-interval")) {
+        const auto slow = std::chrono::microseconds(static_cast<int64_t>(result["slow-ms"].as<double>() * 1000.0));
+        stats = std::make_shared<hftools::utils::StatementStats>(20, slow);
+        hftools::utils::setDefaultInstrumentation(stats);
+        if (result.count("stats-interval")) {
+            statsDump = std::make_unique<hftools::utils::PeriodicTask>(
+                std::chrono::seconds(std::max(1, result["stats-interval"].as<int>())), [stats] { logTopStatements(*stats); });
+        }
+    }
+    auto printStats = [&] {
+        statsDump.reset();
+        if (stats && result["stats"].as<bool>()) {
+            std::cout << std::endl;
+            stats->print(std::cout);
+        }
+    };
+
+    // Run load test
+    if (result.count("bench"))
+    {
+        std::shared_ptr<hftools::utils::StatementMetrics> metrics;
+        std::string metricsFormat;
+        if (result.count("metrics")) {
+            metricsFormat = result["metrics"].as<std::string>();
+            if (metricsFormat != "json" && metricsFormat != "prometheus") {
+                std::cerr << "Error: --metrics must be json or prometheus" << std::endl;
+                return 1;
+            }
+            metrics = std::make_shared<hftools::utils::StatementMetrics>();
+            hftools::utils::setDefaultInstrumentation(std::make_shared<hftools::utils::InstrumentationFanout>(
+                std::vector<std::shared_ptr<hftools::utils::QueryInstrumentation>>{ metrics, stats }));
+        }
+
+        int rc = runLoadTest(dbType, connStr, result);
+        if (metrics) {
+            std::cout << std::endl;
+            if (metricsFormat == "json") std::cout << metrics->toJson().dump(2) << std::endl;
+            else std::cout << metrics->toPrometheus();
+        }
+        printStats();
+        return rc;
+    }
+
     // Run test demonstration
     if (runTest) {
         runTestDemonstration();
+        printStats();
         return 0;
     }
     
@@ -328,18 +491,19 @@ int main(int argc, char* argv[])
     if (!dbType.empty() && !connStr.empty()) {
         if (!query.empty()) {
             // Execute custom query
-            std::shared_ptr<IDatabase> db;
-            
-            if (dbType == "postgresql") {
-                db = std::make_shared<PostgreSQLDatabase>();
-            } else if (dbType == "sybase") {
-                db = std::make_shared<SybaseDatabase>();
-            } else {
+            std::shared_ptr<IDatabase> db = createDatabase(dbType);
+            if (!db) {
                 std::cerr << "Error: Unknown database type: " << dbType << std::endl;
                 return 1;
             }
             
-            auto conn = db->openConnection(connStr);
+            std::shared_ptr<Connection> conn;
+            try {
+                conn = db->openConnection(connStr);
+            } catch (const std::exception& e) {
+                std::cerr << "Error: " << e.what() << std::endl;
+                return 1;
+            }
             if (conn && conn->isConnected()) {
                 auto rs = conn->execQuery(query);
                 if (rs) {
@@ -353,6 +517,7 @@ int main(int argc, char* argv[])
                 }
                 conn->close();
             }
+            printStats();
         } else {
             // Just test connection
             testDatabaseConnection(dbType, connStr);
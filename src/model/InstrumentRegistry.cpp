@@ -0,0 +1,262 @@
+#include "hftools/model/InstrumentRegistry.h"
+#include "hftools/database/Connection.h"
+#include "hftools/database/ResultSet.h"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+
+namespace hftools {
+namespace model {
+
+namespace {
+
+const uint32_t kMaxSeedAttempts = 1u << 20;
+
+// Largest dense id index, in slots per instrument (plus a fixed allowance for
+// small tables); sparser id sets are looked up by binary search instead
+const int64_t kMaxDenseSlotsPerRecord = 4;
+const int64_t kMinDenseSlots = 1024;
+
+void copyCode(char* dst, size_t capacity, const std::string& src, const char* what) {
+    if (src.size() >= capacity) {
+        throw std::invalid_argument(std::string("Instrument ") + what + " too long: " + src);
+    }
+    std::memset(dst, 0, capacity);
+    std::memcpy(dst, src.data(), src.size());
+}
+
+} // namespace
+
+// InstrumentRecord
+
+FXInstrument InstrumentRecord::toFXInstrument() const {
+    return FXInstrument(id, symbol, baseCurrency, quoteCurrency, tickSize);
+}
+
+// InstrumentTable
+
+InstrumentTable::InstrumentTable(const std::vector<FXInstrument>& instruments) {
+    records_.reserve(instruments.size());
+    for (const auto& fx : instruments) {
+        InstrumentRecord r;
+        r.id = fx.getId();
+        r.tickSize = fx.getTickSize();
+        copyCode(r.symbol, sizeof(r.symbol), fx.getSymbol(), "symbol");
+        copyCode(r.baseCurrency, sizeof(r.baseCurrency), fx.getBaseCurrency(), "base currency");
+        copyCode(r.quoteCurrency, sizeof(r.quoteCurrency), fx.getQuoteCurrency(), "quote currency");
+        records_.push_back(r);
+    }
+    std::sort(records_.begin(), records_.end(),
+              [](const InstrumentRecord& a, const InstrumentRecord& b) { return a.id < b.id; });
+
+    const size_t n = records_.size();
+    if (n == 0) return;
+
+    for (size_t i = 1; i < n; ++i) {
+        if (records_[i].id == records_[i - 1].id) {
+            throw std::invalid_argument("Duplicate instrument id: " + std::to_string(records_[i].id));
+        }
+    }
+
+    // Dense id index, unless the ids are too sparse for it to pay off
+    minId_ = records_.front().id;
+    const int64_t span = static_cast<int64_t>(records_.back().id) - minId_ + 1;
+    if (span <= static_cast<int64_t>(n) * kMaxDenseSlotsPerRecord + kMinDenseSlots) {
+        denseIndex_.assign(static_cast<size_t>(span), -1);
+        for (size_t i = 0; i < n; ++i) {
+            denseIndex_[static_cast<size_t>(records_[i].id - minId_)] = static_cast<int32_t>(i);
+        }
+    }
+
+    // Perfect hash over symbols (hash and displace): place the largest buckets
+    // first, searching for a seed that sends all their keys to free slots.
+    size_t tableSize = 1;
+    while (tableSize < n + n / 4) tableSize <<= 1;
+    slotMask_ = tableSize - 1;
+    slots_.assign(tableSize, -1);
+
+    const size_t bucketCount = std::max<size_t>(1, (n + 1) / 2);
+    seeds_.assign(bucketCount, 0);
+    std::vector<std::vector<std::pair<int32_t, uint64_t>>> buckets(bucketCount);
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t h = hashSymbol(records_[i].getSymbol());
+        buckets[h % bucketCount].emplace_back(static_cast<int32_t>(i), h);
+    }
+
+    std::vector<size_t> order(bucketCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(),
+              [&](size_t a, size_t b) { return buckets[a].size() > buckets[b].size(); });
+
+    std::vector<uint64_t> trial;
+    for (size_t b : order) {
+        const auto& keys = buckets[b];
+        if (keys.empty()) break;
+
+        bool placed = false;
+        for (uint32_t seed = 1; seed < kMaxSeedAttempts && !placed; ++seed) {
+            trial.clear();
+            placed = true;
+            for (const auto& k : keys) {
+                uint64_t slot = mix(k.second, seed) & slotMask_;
+                if (slots_[slot] >= 0 || std::find(trial.begin(), trial.end(), slot) != trial.end()) {
+                    placed = false;
+                    break;
+                }
+                trial.push_back(slot);
+            }
+            if (placed) {
+                seeds_[b] = seed;
+                for (size_t k = 0; k < keys.size(); ++k) {
+                    slots_[trial[k]] = keys[k].first;
+                }
+            }
+        }
+        if (!placed) {
+            // Only happens with duplicate symbols: identical keys can never be separated
+            throw std::invalid_argument("Duplicate instrument symbol: " +
+                                        std::string(records_[keys.front().first].getSymbol()));
+        }
+    }
+
+    // Currency indexes
+    std::vector<std::pair<uint64_t, int32_t>> pairs;
+    std::vector<std::pair<uint32_t, int32_t>> bases, quotes;
+    for (const auto& r : records_) {
+        uint32_t base = currencyKey(r.getBaseCurrency());
+        uint32_t quote = currencyKey(r.getQuoteCurrency());
+        pairs.emplace_back(static_cast<uint64_t>(base) << 32 | quote, r.id);
+        bases.emplace_back(base, r.id);
+        quotes.emplace_back(quote, r.id);
+    }
+    std::sort(pairs.begin(), pairs.end());
+    std::sort(bases.begin(), bases.end());
+    std::sort(quotes.begin(), quotes.end());
+    for (const auto& p : pairs) { pairKeys_.push_back(p.first); pairIds_.push_back(p.second); }
+    for (const auto& p : bases) { baseKeys_.push_back(p.first); baseIds_.push_back(p.second); }
+    for (const auto& p : quotes) { quoteKeys_.push_back(p.first); quoteIds_.push_back(p.second); }
+}
+
+InstrumentTable InstrumentTable::fromResultSet(database::ResultSet& rs) {
+    std::vector<FXInstrument> instruments;
+    while (rs.next()) {
+        instruments.emplace_back(rs.getInt("id"), rs.getField("symbol"), rs.getField("base_currency"),
+                                 rs.getField("quote_currency"), rs.getDouble("tick_size"));
+    }
+    return InstrumentTable(instruments);
+}
+
+const InstrumentRecord* InstrumentTable::findBySymbol(std::string_view symbol) const {
+    if (records_.empty()) return nullptr;
+    uint64_t h = hashSymbol(symbol);
+    uint64_t slot = mix(h, seeds_[h % seeds_.size()]) & slotMask_;
+    int32_t idx = slots_[slot];
+    if (idx < 0 || records_[idx].getSymbol() != symbol) return nullptr;
+    return &records_[idx];
+}
+
+const InstrumentRecord* InstrumentTable::findById(int id) const {
+    if (denseIndex_.empty()) {
+        auto it = std::lower_bound(records_.begin(), records_.end(), id,
+                                   [](const InstrumentRecord& r, int key) { return r.id < key; });
+        return it == records_.end() || it->id != id ? nullptr : &*it;
+    }
+    int64_t offset = static_cast<int64_t>(id) - minId_;
+    if (offset < 0 || offset >= static_cast<int64_t>(denseIndex_.size())) return nullptr;
+    int32_t idx = denseIndex_[static_cast<size_t>(offset)];
+    return idx < 0 ? nullptr : &records_[idx];
+}
+
+const InstrumentRecord* InstrumentTable::findByPair(std::string_view base, std::string_view quote) const {
+    uint64_t key = static_cast<uint64_t>(currencyKey(base)) << 32 | currencyKey(quote);
+    auto it = std::lower_bound(pairKeys_.begin(), pairKeys_.end(), key);
+    if (it == pairKeys_.end() || *it != key) return nullptr;
+    return findById(pairIds_[static_cast<size_t>(it - pairKeys_.begin())]);
+}
+
+int InstrumentTable::idForSymbol(std::string_view symbol) const {
+    const InstrumentRecord* r = findBySymbol(symbol);
+    return r ? r->id : -1;
+}
+
+InstrumentIdSpan InstrumentTable::withBaseCurrency(std::string_view ccy) const {
+    return currencyRange(baseKeys_, baseIds_, ccy);
+}
+
+InstrumentIdSpan InstrumentTable::withQuoteCurrency(std::string_view ccy) const {
+    return currencyRange(quoteKeys_, quoteIds_, ccy);
+}
+
+InstrumentIdSpan InstrumentTable::currencyRange(const std::vector<uint32_t>& keys, const std::vector<int32_t>& ids,
+                                                std::string_view ccy) const {
+    auto range = std::equal_range(keys.begin(), keys.end(), currencyKey(ccy));
+    const int32_t* base = ids.data();
+    return InstrumentIdSpan{ base + (range.first - keys.begin()), base + (range.second - keys.begin()) };
+}
+
+uint64_t InstrumentTable::hashSymbol(std::string_view symbol) {
+    // FNV-1a
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (char c : symbol) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+uint64_t InstrumentTable::mix(uint64_t h, uint32_t seed) {
+    // splitmix64 finalizer
+    uint64_t z = h ^ (static_cast<uint64_t>(seed) * 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+uint32_t InstrumentTable::currencyKey(std::string_view ccy) {
+    uint32_t key = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        key = key << 8 | (i < ccy.size() ? static_cast<unsigned char>(ccy[i]) : 0u);
+    }
+    return key;
+}
+
+// InstrumentRegistry
+
+InstrumentRegistry::InstrumentRegistry()
+    : owned_(std::make_unique<const InstrumentTable>()) {
+    current_.store(owned_.get(), std::memory_order_release);
+}
+
+InstrumentRegistry::~InstrumentRegistry() = default;
+
+void InstrumentRegistry::publish(InstrumentTable table) {
+    auto next = std::make_unique<const InstrumentTable>(std::move(table));
+    std::lock_guard<std::mutex> lock(writerMutex_);
+    current_.store(next.get(), std::memory_order_release);
+    retired_.push_back(std::move(owned_));
+    owned_ = std::move(next);
+}
+
+void InstrumentRegistry::loadFrom(database::Connection& conn) {
+    auto rs = conn.execQuery("SELECT id, symbol, base_currency, quote_currency, tick_size FROM fxinstruments");
+    if (!rs) {
+        throw std::runtime_error("Failed to load fxinstruments");
+    }
+    publish(InstrumentTable::fromResultSet(*rs));
+}
+
+size_t InstrumentRegistry::reclaim() {
+    std::lock_guard<std::mutex> lock(writerMutex_);
+    size_t n = retired_.size();
+    retired_.clear();
+    return n;
+}
+
+size_t InstrumentRegistry::retiredCount() const {
+    std::lock_guard<std::mutex> lock(writerMutex_);
+    return retired_.size();
+}
+
+} // namespace model
+} // namespace hftools
@@ -0,0 +1,179 @@
+#include "hftools/utils/HdrHistogram.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace hftools {
+namespace utils {
+
+namespace {
+
+// Index of the highest set bit; value > 0
+int highestBit(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(value);
+#else
+    int bit = 0;
+    while (value >>= 1) ++bit;
+    return bit;
+#endif
+}
+
+} // namespace
+
+HdrHistogram::HdrHistogram(int64_t lowest, int64_t highest, int significantDigits)
+    : lowest_(lowest), highest_(highest), significantDigits_(significantDigits) {
+    if (lowest < 1) {
+        throw std::invalid_argument("HdrHistogram: lowest value must be >= 1");
+    }
+    if (highest < 2 * lowest) {
+        throw std::invalid_argument("HdrHistogram: highest value must be >= 2 * lowest");
+    }
+    if (significantDigits < 1 || significantDigits > 5) {
+        throw std::invalid_argument("HdrHistogram: significant digits must be between 1 and 5");
+    }
+
+    // Sub-buckets needed to resolve 10^digits values at the bottom of each bucket
+    const int64_t largestSingleUnitResolution = 2 * static_cast<int64_t>(std::pow(10, significantDigits));
+    const int subBucketCountMagnitude = highestBit(static_cast<uint64_t>(largestSingleUnitResolution - 1)) + 1;
+    subBucketHalfCountMagnitude_ = std::max(subBucketCountMagnitude, 1) - 1;
+    unitMagnitude_ = highestBit(static_cast<uint64_t>(lowest));
+    subBucketCount_ = int64_t{ 1 } << (subBucketHalfCountMagnitude_ + 1);
+    subBucketHalfCount_ = subBucketCount_ / 2;
+    subBucketMask_ = (subBucketCount_ - 1) << unitMagnitude_;
+
+    // Each bucket doubles the range covered by the one before it
+    int64_t smallestUntrackable = subBucketCount_ << unitMagnitude_;
+    int bucketCount = 1;
+    while (smallestUntrackable <= highest) {
+        if (smallestUntrackable > std::numeric_limits<int64_t>::max() / 2) {
+            ++bucketCount;
+            break;
+        }
+        smallestUntrackable <<= 1;
+        ++bucketCount;
+    }
+
+    counts_.assign(static_cast<size_t>((bucketCount + 1) * subBucketHalfCount_), 0);
+    minValue_ = std::numeric_limits<int64_t>::max();
+}
+
+size_t HdrHistogram::indexOf(int64_t value) const {
+    const int bucketIndex = highestBit(static_cast<uint64_t>(value | subBucketMask_)) - unitMagnitude_ - subBucketHalfCountMagnitude_;
+    const int64_t subBucketIndex = value >> (bucketIndex + unitMagnitude_);
+    return static_cast<size_t>((static_cast<int64_t>(bucketIndex + 1) << subBucketHalfCountMagnitude_)
+                               + (subBucketIndex - subBucketHalfCount_));
+}
+
+int64_t HdrHistogram::valueFromIndex(size_t index) const {
+    int bucketIndex = static_cast<int>(index >> subBucketHalfCountMagnitude_) - 1;
+    int64_t subBucketIndex = static_cast<int64_t>(index & static_cast<size_t>(subBucketHalfCount_ - 1)) + subBucketHalfCount_;
+    if (bucketIndex < 0) {
+        subBucketIndex -= subBucketHalfCount_;
+        bucketIndex = 0;
+    }
+    return subBucketIndex << (bucketIndex + unitMagnitude_);
+}
+
+int64_t HdrHistogram::lowestEquivalentValue(int64_t value) const {
+    return valueFromIndex(indexOf(value));
+}
+
+int64_t HdrHistogram::highestEquivalentValue(int64_t value) const {
+    const int bucketIndex = highestBit(static_cast<uint64_t>(value | subBucketMask_)) - unitMagnitude_ - subBucketHalfCountMagnitude_;
+    const int64_t subBucketIndex = value >> (bucketIndex + unitMagnitude_);
+    const int adjusted = bucketIndex + (subBucketIndex >= subBucketCount_ ? 1 : 0);
+    const int64_t rangeSize = int64_t{ 1 } << (unitMagnitude_ + adjusted);
+    return lowestEquivalentValue(value) + rangeSize - 1;
+}
+
+void HdrHistogram::record(int64_t value, int64_t count) {
+    if (value < 0) value = 0;
+    if (value > highest_) value = highest_;
+    counts_[indexOf(value)] += count;
+    totalCount_ += count;
+    minValue_ = std::min(minValue_, value);
+    maxValue_ = std::max(maxValue_, value);
+}
+
+void HdrHistogram::recordCorrected(int64_t value, int64_t expectedInterval) {
+    record(value);
+    if (expectedInterval <= 0) return;
+    for (int64_t missing = value - expectedInterval; missing >= expectedInterval; missing -= expectedInterval) {
+        record(missing);
+    }
+}
+
+size_t HdrHistogram::bucketIndex(int64_t value) const {
+    return indexOf(std::min(std::max<int64_t>(value, 0), highest_));
+}
+
+void HdrHistogram::addToBucket(size_t index, int64_t count) {
+    if (count <= 0) return;
+    if (index >= counts_.size()) {
+        throw std::out_of_range("HdrHistogram: bucket index out of range");
+    }
+    const int64_t value = valueFromIndex(index);
+    counts_[index] += count;
+    totalCount_ += count;
+    minValue_ = std::min(minValue_, value);
+    maxValue_ = std::max(maxValue_, value);
+}
+
+void HdrHistogram::add(const HdrHistogram& other) {
+    if (other.lowest_ != lowest_ || other.highest_ != highest_ || other.significantDigits_ != significantDigits_) {
+        throw std::invalid_argument("HdrHistogram: cannot add histograms with different parameters");
+    }
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    totalCount_ += other.totalCount_;
+    minValue_ = std::min(minValue_, other.minValue_);
+    maxValue_ = std::max(maxValue_, other.maxValue_);
+}
+
+void HdrHistogram::reset() {
+    std::fill(counts_.begin(), counts_.end(), 0);
+    totalCount_ = 0;
+    minValue_ = std::numeric_limits<int64_t>::max();
+    maxValue_ = 0;
+}
+
+int64_t HdrHistogram::min() const {
+    return totalCount_ == 0 ? 0 : lowestEquivalentValue(minValue_);
+}
+
+int64_t HdrHistogram::max() const {
+    return totalCount_ == 0 ? 0 : highestEquivalentValue(maxValue_);
+}
+
+double HdrHistogram::mean() const {
+    if (totalCount_ == 0) return 0.0;
+    double total = 0.0;
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        if (counts_[i] == 0) continue;
+        // Middle of the bucket, as HdrHistogram does
+        const int64_t low = valueFromIndex(i);
+        total += static_cast<double>(counts_[i]) * (static_cast<double>(low + highestEquivalentValue(low)) / 2.0);
+    }
+    return total / static_cast<double>(totalCount_);
+}
+
+int64_t HdrHistogram::valueAtPercentile(double percentile) const {
+    if (totalCount_ == 0) return 0;
+    percentile = std::min(std::max(percentile, 0.0), 100.0);
+
+    const int64_t target = std::max<int64_t>(1, static_cast<int64_t>(std::ceil(percentile / 100.0 * static_cast<double>(totalCount_))));
+    int64_t seen = 0;
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        seen += counts_[i];
+        if (seen >= target) {
+            return std::min(highestEquivalentValue(valueFromIndex(i)), max());
+        }
+    }
+    return max();
+}
+
+} // namespace utils
+} // namespace hftools
@@ -0,0 +1,228 @@
+#include "hftools/utils/Instrumentation.h"
+#include <algorithm>
+#include <cctype>
+#include <mutex>
+#include <vector>
+
+namespace hftools {
+namespace utils {
+
+namespace {
+
+bool isIdentChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '#' || c == '@' || c == '$';
+}
+
+// Placeholder token; views into the SQL text otherwise, so tokenizing copies nothing
+constexpr std::string_view kParam = "?";
+
+void tokenize(std::string_view sql, std::vector<std::string_view>& tokens) {
+    tokens.clear();
+    size_t i = 0;
+    const size_t n = sql.size();
+    while (i < n) {
+        const char c = sql[i];
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            ++i;
+        } else if (c == '-' && i + 1 < n && sql[i + 1] == '-') {
+            while (i < n && sql[i] != '\n') ++i;
+        } else if (c == '/' && i + 1 < n && sql[i + 1] == '*') {
+            const size_t end = sql.find("*/", i + 2);
+            i = end == std::string_view::npos ? n : end + 2;
+        } else if (c == '\'') {
+            // String literal, '' is an escaped quote
+            ++i;
+            while (i < n) {
+                if (sql[i] == '\'' && i + 1 < n && sql[i + 1] == '\'') i += 2;
+                else if (sql[i++] == '\'') break;
+            }
+            tokens.push_back(kParam);
+        } else if (c == '"' || c == '[') {
+            // Quoted identifier, kept as is
+            const char close = c == '"' ? '"' : ']';
+            const size_t end = sql.find(close, i + 1);
+            const size_t stop = end == std::string_view::npos ? n : end + 1;
+            tokens.push_back(sql.substr(i, stop - i));
+            i = stop;
+        } else if (std::isdigit(static_cast<unsigned char>(c)) ||
+                   (c == '.' && i + 1 < n && std::isdigit(static_cast<unsigned char>(sql[i + 1])))) {
+            while (i < n && (std::isalnum(static_cast<unsigned char>(sql[i])) || sql[i] == '.' ||
+                             ((sql[i] == '+' || sql[i] == '-') && (sql[i - 1] == 'e' || sql[i - 1] == 'E')))) {
+                ++i;
+            }
+            tokens.push_back(kParam);
+        } else if (c == '?' || ((c == '$' || c == ':') && i + 1 < n && std::isdigit(static_cast<unsigned char>(sql[i + 1])))) {
+            ++i;
+            while (i < n && std::isdigit(static_cast<unsigned char>(sql[i]))) ++i;
+            tokens.push_back(kParam);
+        } else if (c == ':' && i + 1 < n && std::isalpha(static_cast<unsigned char>(sql[i + 1]))) {
+            ++i;
+            while (i < n && isIdentChar(sql[i])) ++i;
+            tokens.push_back(kParam);
+        } else if (c == '@' && i + 1 < n && sql[i + 1] != '@') {
+            // @p1 style parameters (variables are left alone by DECLARE-style batches anyway)
+            ++i;
+            while (i < n && isIdentChar(sql[i])) ++i;
+            tokens.push_back(kParam);
+        } else if (isIdentChar(c)) {
+            const size_t start = i;
+            while (i < n && isIdentChar(sql[i])) ++i;
+            tokens.push_back(sql.substr(start, i - start));
+        } else {
+            // Two-character operators stay together
+            static const char* const pairs[] = { "<=", ">=", "<>", "!=", "::", "||" };
+            size_t len = 1;
+            for (const char* p : pairs) {
+                if (i + 1 < n && sql[i] == p[0] && sql[i + 1] == p[1]) len = 2;
+            }
+            tokens.push_back(sql.substr(i, len));
+            i += len;
+        }
+    }
+}
+
+// "? , ? , ?" -> "?", compacting in place
+void collapseValueLists(std::vector<std::string_view>& tokens) {
+    size_t out = 0;
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        if (tokens[i] == kParam && out >= 2 && tokens[out - 1] == "," && tokens[out - 2] == kParam) {
+            --out;
+            continue;
+        }
+        tokens[out++] = tokens[i];
+    }
+    tokens.resize(out);
+}
+
+// "( a ) , ( a ) , ( a )" -> "( a )", for multi-row VALUES, compacting in
+// place: the write position never passes the read position
+void collapseRepeatedGroups(std::vector<std::string_view>& tokens) {
+    size_t out = 0;
+    size_t lastGroupStart = std::string::npos;   // of a group closed right before a ","
+    size_t i = 0;
+    while (i < tokens.size()) {
+        if (tokens[i] == "(") {
+            size_t depth = 0;
+            size_t j = i;
+            for (; j < tokens.size(); ++j) {
+                if (tokens[j] == "(") ++depth;
+                else if (tokens[j] == ")" && --depth == 0) break;
+            }
+            if (j < tokens.size()) {
+                const size_t len = j - i + 1;
+                const bool repeat = lastGroupStart != std::string::npos && out >= 1 && tokens[out - 1] == "," &&
+                                    out - 1 - lastGroupStart == len &&
+                                    std::equal(tokens.begin() + i, tokens.begin() + j + 1, tokens.begin() + lastGroupStart);
+                if (repeat) {
+                    --out;   // the ","
+                } else {
+                    lastGroupStart = out;
+                    std::copy(tokens.begin() + i, tokens.begin() + j + 1, tokens.begin() + out);
+                    out += len;
+                }
+                i = j + 1;
+                if (!(i < tokens.size() && tokens[i] == ",")) lastGroupStart = std::string::npos;
+                continue;
+            }
+        }
+        if (tokens[i] != ",") lastGroupStart = std::string::npos;
+        tokens[out++] = tokens[i];
+        ++i;
+    }
+    tokens.resize(out);
+}
+
+// Only read when a connection or database is created, so a mutex is fine
+std::mutex defaultMutex;
+std::shared_ptr<QueryInstrumentation> defaultValue;
+
+} // namespace
+
+std::string fingerprintSql(std::string_view sql) {
+    // Reused per thread: after warm-up the output string is the only allocation
+    thread_local std::vector<std::string_view> tokens;
+    tokenize(sql, tokens);
+    collapseValueLists(tokens);
+    collapseRepeatedGroups(tokens);
+
+    size_t length = 0;
+    for (const std::string_view t : tokens) length += t.size() + 1;
+    std::string out;
+    out.reserve(length);
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        const std::string_view t = tokens[i];
+        const bool glue = i == 0 || t == "," || t == ")" || t == "." || t == ";" || t == "::" ||
+                          tokens[i - 1] == "(" || tokens[i - 1] == "." || tokens[i - 1] == "::";
+        if (!glue) out += ' ';
+        out += t;
+    }
+    return out;
+}
+
+InstrumentationFanout::InstrumentationFanout(std::vector<std::shared_ptr<QueryInstrumentation>> targets)
+    : targets_(std::move(targets)) {
+    targets_.erase(std::remove(targets_.begin(), targets_.end(), nullptr), targets_.end());
+}
+
+void InstrumentationFanout::onStart(const StatementEvent& event) {
+    for (const auto& target : targets_) target->onStart(event);
+}
+
+void InstrumentationFanout::onFinish(const StatementEvent& event) {
+    for (const auto& target : targets_) target->onFinish(event);
+}
+
+void InstrumentationFanout::onPoolWait(std::string_view pool, std::chrono::nanoseconds waited) {
+    for (const auto& target : targets_) target->onPoolWait(pool, waited);
+}
+
+void setDefaultInstrumentation(std::shared_ptr<QueryInstrumentation> instrumentation) {
+    std::lock_guard<std::mutex> lock(defaultMutex);
+    defaultValue = std::move(instrumentation);
+}
+
+std::shared_ptr<QueryInstrumentation> defaultInstrumentation() {
+    std::lock_guard<std::mutex> lock(defaultMutex);
+    return defaultValue;
+}
+
+StatementTrace::StatementTrace(QueryInstrumentation* instrumentation, std::string_view backend, std::string_view sql,
+                               const std::vector<std::string>* params)
+    : instrumentation_(instrumentation) {
+    if (!instrumentation_) return;
+    fingerprint_ = fingerprintSql(sql);
+    event_.backend = backend;
+    event_.sql = sql;
+    event_.fingerprint = fingerprint_;
+    event_.params = params;
+    try {
+        instrumentation_->onStart(event_);
+    } catch (...) {
+    }
+    start_ = std::chrono::steady_clock::now();
+}
+
+StatementTrace::~StatementTrace() {
+    if (instrumentation_) report(true);
+}
+
+void StatementTrace::finish(int64_t rows, int64_t bytes) {
+    if (!instrumentation_) return;
+    event_.rows = rows;
+    event_.bytes = bytes;
+    report(false);
+}
+
+void StatementTrace::report(bool failed) {
+    event_.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_);
+    event_.failed = failed;
+    QueryInstrumentation* instrumentation = instrumentation_;
+    instrumentation_ = nullptr;
+    try {
+        instrumentation->onFinish(event_);
+    } catch (...) {
+    }
+}
+
+} // namespace utils
+} // namespace hftools
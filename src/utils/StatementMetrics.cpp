@@ -0,0 +1,355 @@
+#include "hftools/utils/StatementMetrics.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <map>
+#include <sstream>
+#include <unordered_map>
+#include <utility>
+
+namespace hftools {
+namespace utils {
+
+namespace {
+
+constexpr int64_t kLowestNanos = 1000;
+constexpr int64_t kHighestNanos = 3'600'000'000'000;
+constexpr int kSignificantDigits = 2;
+
+std::atomic<uint64_t> nextMetricsId{ 1 };
+
+// Single writer: a plain load + store is enough and avoids a locked instruction
+inline void bump(std::atomic<int64_t>& counter, int64_t by) {
+    counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+}
+
+uint64_t fnv1a(std::string_view a, std::string_view b) {
+    uint64_t h = 14695981039346656037ull;
+    for (char c : a) h = (h ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+    h = (h ^ 0xff) * 1099511628211ull;
+    for (char c : b) h = (h ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+    return h;
+}
+
+std::string escapeLabel(const std::string& value) {
+    std::string out;
+    out.reserve(value.size());
+    for (char c : value) {
+        if (c == '\\') out += "\\\\";
+        else if (c == '"') out += "\\\"";
+        else if (c == '\n') out += "\\n";
+        else out += c;
+    }
+    return out;
+}
+
+std::string seconds(int64_t nanos) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.9g", static_cast<double>(nanos) / 1e9);
+    return buf;
+}
+
+double micros(double nanos) {
+    return nanos / 1000.0;
+}
+
+} // namespace
+
+// One fingerprint (or pool) as seen by one thread
+struct StatementMetrics::Series {
+    std::string backend;
+    std::string name;
+    std::atomic<int64_t> count{ 0 };
+    std::atomic<int64_t> errors{ 0 };
+    std::atomic<int64_t> rows{ 0 };
+    std::atomic<int64_t> bytes{ 0 };
+    std::atomic<int64_t> totalNanos{ 0 };
+    std::atomic<int64_t> successNanos{ 0 };
+    std::unique_ptr<std::atomic<int64_t>[]> buckets;
+
+    Series(std::string b, std::string n, size_t bucketCount)
+        : backend(std::move(b)), name(std::move(n)), buckets(new std::atomic<int64_t>[bucketCount]) {
+        for (size_t i = 0; i < bucketCount; ++i) buckets[i].store(0, std::memory_order_relaxed);
+    }
+};
+
+// Everything recorded by the thread currently owning the shard. Only the
+// owner inserts into the maps (under mutex); it looks entries up without the
+// lock, which is safe because nobody else modifies them. Ownership passes to
+// another thread only through Registry::idle, under the registry mutex.
+struct StatementMetrics::Shard {
+    std::mutex mutex;
+    std::unordered_map<uint64_t, std::unique_ptr<Series>> statements;
+    std::unordered_map<std::string, std::unique_ptr<Series>> pools;
+    std::atomic<int64_t> started{ 0 };
+    std::atomic<int64_t> finished{ 0 };
+};
+
+struct StatementMetrics::Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Shard>> shards;   // every shard, owned or idle
+    std::vector<Shard*> idle;                     // left behind by exited threads
+};
+
+HdrHistogram StatementMetrics::makeHistogram() {
+    return HdrHistogram(kLowestNanos, kHighestNanos, kSignificantDigits);
+}
+
+StatementMetrics::StatementMetrics()
+    : id_(nextMetricsId.fetch_add(1, std::memory_order_relaxed)),
+      layout_(makeHistogram()),
+      registry_(std::make_shared<Registry>()) {
+}
+
+StatementMetrics::~StatementMetrics() = default;
+
+StatementMetrics::Shard& StatementMetrics::localShard() {
+    struct Lease {
+        uint64_t id;
+        std::weak_ptr<Registry> registry;
+        Shard* shard;
+    };
+    // Shards this thread owns, one per instance; given back on thread exit
+    // unless the instance is already gone
+    struct Leases {
+        std::vector<Lease> held;
+        ~Leases() {
+            for (const Lease& lease : held) {
+                if (auto registry = lease.registry.lock()) {
+                    std::lock_guard<std::mutex> lock(registry->mutex);
+                    registry->idle.push_back(lease.shard);
+                }
+            }
+        }
+    };
+    thread_local Leases leases;
+
+    for (const Lease& lease : leases.held) {
+        if (lease.id == id_) return *lease.shard;
+    }
+    leases.held.erase(std::remove_if(leases.held.begin(), leases.held.end(),
+                                     [](const Lease& lease) { return lease.registry.expired(); }),
+                      leases.held.end());
+
+    std::lock_guard<std::mutex> lock(registry_->mutex);
+    Shard* shard;
+    if (!registry_->idle.empty()) {
+        shard = registry_->idle.back();
+        registry_->idle.pop_back();
+    } else {
+        registry_->shards.push_back(std::make_unique<Shard>());
+        shard = registry_->shards.back().get();
+    }
+    leases.held.push_back(Lease{ id_, registry_, shard });
+    return *shard;
+}
+
+void StatementMetrics::onStart(const StatementEvent&) {
+    bump(localShard().started, 1);
+}
+
+void StatementMetrics::onFinish(const StatementEvent& event) {
+    Shard& shard = localShard();
+    bump(shard.finished, 1);
+
+    const uint64_t key = fnv1a(event.backend, event.fingerprint);
+    auto it = shard.statements.find(key);
+    if (it == shard.statements.end()) {
+        auto series = std::make_unique<Series>(std::string(event.backend), std::string(event.fingerprint), layout_.bucketCount());
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        it = shard.statements.emplace(key, std::move(series)).first;
+    }
+    Series& s = *it->second;
+
+    const int64_t nanos = event.duration.count();
+    bump(s.totalNanos, nanos);
+    if (event.failed) {
+        bump(s.errors, 1);
+        return;
+    }
+    bump(s.count, 1);
+    bump(s.successNanos, nanos);
+    bump(s.rows, event.rows);
+    bump(s.bytes, event.bytes);
+    bump(s.buckets[layout_.bucketIndex(nanos)], 1);
+}
+
+void StatementMetrics::onPoolWait(std::string_view pool, std::chrono::nanoseconds waited) {
+    Shard& shard = localShard();
+    auto it = shard.pools.find(std::string(pool));
+    if (it == shard.pools.end()) {
+        auto series = std::make_unique<Series>(std::string(), std::string(pool), layout_.bucketCount());
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        it = shard.pools.emplace(std::string(pool), std::move(series)).first;
+    }
+    Series& s = *it->second;
+    bump(s.count, 1);
+    bump(s.totalNanos, waited.count());
+    bump(s.buckets[layout_.bucketIndex(waited.count())], 1);
+}
+
+std::vector<StatementMetrics::StatementSummary> StatementMetrics::statements() const {
+    std::map<std::pair<std::string, std::string>, StatementSummary> merged;
+    std::lock_guard<std::mutex> lock(registry_->mutex);
+    for (const auto& shard : registry_->shards) {
+        std::lock_guard<std::mutex> shardLock(shard->mutex);
+        for (const auto& entry : shard->statements) {
+            const Series& s = *entry.second;
+            auto it = merged.find({ s.backend, s.name });
+            if (it == merged.end()) {
+                StatementSummary summary{ s.backend, s.name, 0, 0, 0, 0, 0, 0, makeHistogram() };
+                it = merged.emplace(std::make_pair(s.backend, s.name), std::move(summary)).first;
+            }
+            StatementSummary& m = it->second;
+            m.count += s.count.load(std::memory_order_relaxed);
+            m.errors += s.errors.load(std::memory_order_relaxed);
+            m.rows += s.rows.load(std::memory_order_relaxed);
+            m.bytes += s.bytes.load(std::memory_order_relaxed);
+            m.totalNanos += s.totalNanos.load(std::memory_order_relaxed);
+            m.successNanos += s.successNanos.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < layout_.bucketCount(); ++i) {
+                m.latency.addToBucket(i, s.buckets[i].load(std::memory_order_relaxed));
+            }
+        }
+    }
+
+    std::vector<StatementSummary> out;
+    out.reserve(merged.size());
+    for (auto& entry : merged) out.push_back(std::move(entry.second));
+    std::sort(out.begin(), out.end(), [](const StatementSummary& a, const StatementSummary& b) {
+        return a.totalNanos > b.totalNanos;
+    });
+    return out;
+}
+
+std::vector<StatementMetrics::PoolSummary> StatementMetrics::pools() const {
+    std::map<std::string, PoolSummary> merged;
+    std::lock_guard<std::mutex> lock(registry_->mutex);
+    for (const auto& shard : registry_->shards) {
+        std::lock_guard<std::mutex> shardLock(shard->mutex);
+        for (const auto& entry : shard->pools) {
+            const Series& s = *entry.second;
+            auto it = merged.find(s.name);
+            if (it == merged.end()) {
+                it = merged.emplace(s.name, PoolSummary{ s.name, 0, 0, makeHistogram() }).first;
+            }
+            PoolSummary& m = it->second;
+            m.waits += s.count.load(std::memory_order_relaxed);
+            m.totalNanos += s.totalNanos.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < layout_.bucketCount(); ++i) {
+                m.wait.addToBucket(i, s.buckets[i].load(std::memory_order_relaxed));
+            }
+        }
+    }
+
+    std::vector<PoolSummary> out;
+    for (auto& entry : merged) out.push_back(std::move(entry.second));
+    return out;
+}
+
+int64_t StatementMetrics::inFlight() const {
+    int64_t started = 0;
+    int64_t finished = 0;
+    std::lock_guard<std::mutex> lock(registry_->mutex);
+    for (const auto& shard : registry_->shards) {
+        // finished first: a statement finishing in between is then not counted as negative
+        finished += shard->finished.load(std::memory_order_relaxed);
+        started += shard->started.load(std::memory_order_relaxed);
+    }
+    return std::max<int64_t>(0, started - finished);
+}
+
+nlohmann::json StatementMetrics::toJson() const {
+    nlohmann::json statementsJson = nlohmann::json::array();
+    for (const auto& s : statements()) {
+        statementsJson.push_back({
+            { "backend", s.backend },
+            { "fingerprint", s.fingerprint },
+            { "count", s.count },
+            { "errors", s.errors },
+            { "rows", s.rows },
+            { "bytes", s.bytes },
+            { "total_us", micros(static_cast<double>(s.totalNanos)) },
+            { "mean_us", micros(s.latency.mean()) },
+            { "p50_us", micros(static_cast<double>(s.latency.valueAtPercentile(50.0))) },
+            { "p90_us", micros(static_cast<double>(s.latency.valueAtPercentile(90.0))) },
+            { "p99_us", micros(static_cast<double>(s.latency.valueAtPercentile(99.0))) },
+            { "p999_us", micros(static_cast<double>(s.latency.valueAtPercentile(99.9))) },
+            { "max_us", micros(static_cast<double>(s.latency.max())) }
+        });
+    }
+
+    nlohmann::json poolsJson = nlohmann::json::array();
+    for (const auto& p : pools()) {
+        poolsJson.push_back({
+            { "pool", p.pool },
+            { "waits", p.waits },
+            { "total_us", micros(static_cast<double>(p.totalNanos)) },
+            { "p50_us", micros(static_cast<double>(p.wait.valueAtPercentile(50.0))) },
+            { "p99_us", micros(static_cast<double>(p.wait.valueAtPercentile(99.0))) },
+            { "max_us", micros(static_cast<double>(p.wait.max())) }
+        });
+    }
+
+    return nlohmann::json{
+        { "in_flight", inFlight() },
+        { "statements", statementsJson },
+        { "pools", poolsJson }
+    };
+}
+
+std::string StatementMetrics::toPrometheus() const {
+    static const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+    std::ostringstream out;
+
+    out << "# HELP hftools_statements_in_flight Statements started and not yet finished\n"
+        << "# TYPE hftools_statements_in_flight gauge\n"
+        << "hftools_statements_in_flight " << inFlight() << "\n";
+
+    const auto stmts = statements();
+    out << "# HELP hftools_statement_duration_seconds Latency of successful statements, by fingerprint\n"
+        << "# TYPE hftools_statement_duration_seconds summary\n";
+    for (const auto& s : stmts) {
+        const std::string labels = "backend=\"" + escapeLabel(s.backend) + "\",fingerprint=\"" + escapeLabel(s.fingerprint) + "\"";
+        for (double q : quantiles) {
+            out << "hftools_statement_duration_seconds{" << labels << ",quantile=\"" << q << "\"} "
+                << seconds(s.latency.valueAtPercentile(q * 100.0)) << "\n";
+        }
+        out << "hftools_statement_duration_seconds_sum{" << labels << "} " << seconds(s.successNanos) << "\n"
+            << "hftools_statement_duration_seconds_count{" << labels << "} " << s.count << "\n";
+    }
+
+    const struct {
+        const char* name;
+        const char* help;
+        int64_t StatementSummary::*field;
+    } counters[] = {
+        { "hftools_statement_errors_total", "Failed statements", &StatementSummary::errors },
+        { "hftools_statement_rows_total", "Rows returned or affected", &StatementSummary::rows },
+        { "hftools_statement_bytes_total", "Result bytes returned", &StatementSummary::bytes },
+    };
+    for (const auto& c : counters) {
+        out << "# HELP " << c.name << " " << c.help << ", by fingerprint\n"
+            << "# TYPE " << c.name << " counter\n";
+        for (const auto& s : stmts) {
+            out << c.name << "{backend=\"" << escapeLabel(s.backend) << "\",fingerprint=\"" << escapeLabel(s.fingerprint)
+                << "\"} " << s.*(c.field) << "\n";
+        }
+    }
+
+    out << "# HELP hftools_pool_wait_seconds Time spent waiting for a pooled connection\n"
+        << "# TYPE hftools_pool_wait_seconds summary\n";
+    for (const auto& p : pools()) {
+        const std::string labels = "pool=\"" + escapeLabel(p.pool) + "\"";
+        for (double q : quantiles) {
+            out << "hftools_pool_wait_seconds{" << labels << ",quantile=\"" << q << "\"} "
+                << seconds(p.wait.valueAtPercentile(q * 100.0)) << "\n";
+        }
+        out << "hftools_pool_wait_seconds_sum{" << labels << "} " << seconds(p.totalNanos) << "\n"
+            << "hftools_pool_wait_seconds_count{" << labels << "} " << p.waits << "\n";
+    }
+    return out.str();
+}
+
+} // namespace utils
+} // namespace hftools
@@ -0,0 +1,235 @@
+#include "hftools/utils/StatementStats.h"
+#include "hftools/utils/Logger.h"
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <iomanip>
+#include <limits>
+
+namespace hftools {
+namespace utils {
+
+namespace {
+
+constexpr size_t kMaxSqlBytes = 4096;
+constexpr size_t kMaxParamBytes = 256;
+
+std::string truncated(std::string_view text, size_t limit) {
+    if (text.size() <= limit) return std::string(text);
+    return std::string(text.substr(0, limit)) + "...";
+}
+
+bool slower(const StatementStats::SlowStatement& a, const StatementStats::SlowStatement& b) {
+    return a.nanos > b.nanos;
+}
+
+double micros(int64_t nanos) {
+    return static_cast<double>(nanos) / 1000.0;
+}
+
+std::string formatTime(std::chrono::system_clock::time_point time) {
+    const std::time_t seconds = std::chrono::system_clock::to_time_t(time);
+    std::tm utc{};
+#ifdef _WIN32
+    gmtime_s(&utc, &seconds);
+#else
+    gmtime_r(&seconds, &utc);
+#endif
+    char buf[32];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", &utc);
+    return buf;
+}
+
+} // namespace
+
+StatementStats::StatementStats(size_t slowestSamples, std::chrono::nanoseconds slowThreshold)
+    : slowestSamples_(slowestSamples),
+      slowThresholdNanos_(slowThreshold.count()),
+      admitNanos_(slowestSamples == 0 ? std::numeric_limits<int64_t>::max() : slowThreshold.count()) {
+}
+
+void StatementStats::onFinish(const StatementEvent& event) {
+    const int64_t nanos = event.duration.count();
+
+    std::string key;
+    key.reserve(event.backend.size() + 1 + event.fingerprint.size());
+    key.append(event.backend).append(1, '\x1f').append(event.fingerprint);
+    Stripe& stripe = stripes_[std::hash<std::string>{}(key) % kStripes];
+    {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        auto it = stripe.entries.find(key);
+        if (it == stripe.entries.end()) {
+            FingerprintStats fresh;
+            fresh.backend = std::string(event.backend);
+            fresh.fingerprint = std::string(event.fingerprint);
+            it = stripe.entries.emplace(std::move(key), std::move(fresh)).first;
+        }
+        FingerprintStats& stats = it->second;
+        ++stats.calls;
+        if (event.failed) ++stats.errors;
+        stats.rows += event.rows;
+        stats.totalNanos += nanos;
+        stats.maxNanos = std::max(stats.maxNanos, nanos);
+    }
+
+    if (nanos >= admitNanos_.load(std::memory_order_relaxed)) {
+        sample(event, nanos);
+    }
+}
+
+void StatementStats::sample(const StatementEvent& event, int64_t nanos) {
+    std::lock_guard<std::mutex> lock(slowMutex_);
+    const bool full = slow_.size() >= slowestSamples_;
+    if (full && nanos <= slow_.front().nanos) return;
+
+    SlowStatement entry;
+    entry.backend = std::string(event.backend);
+    entry.fingerprint = std::string(event.fingerprint);
+    // The sample is printed and exported: mask credentials as the logger does
+    entry.sql = truncated(redactCredentials(event.sql), kMaxSqlBytes);
+    if (event.params) {
+        entry.params.reserve(event.params->size());
+        for (const auto& p : *event.params) entry.params.push_back(truncated(redactCredentials(p), kMaxParamBytes));
+    }
+    entry.nanos = nanos;
+    entry.rows = event.rows;
+    entry.failed = event.failed;
+    entry.finishedAt = std::chrono::system_clock::now();
+
+    if (full) {
+        std::pop_heap(slow_.begin(), slow_.end(), slower);
+        slow_.back() = std::move(entry);
+    } else {
+        slow_.push_back(std::move(entry));
+    }
+    std::push_heap(slow_.begin(), slow_.end(), slower);
+
+    if (slow_.size() >= slowestSamples_) {
+        admitNanos_.store(std::max(slowThresholdNanos_, slow_.front().nanos + 1), std::memory_order_relaxed);
+    }
+}
+
+std::vector<StatementStats::FingerprintStats> StatementStats::fingerprints() const {
+    std::vector<FingerprintStats> out;
+    for (const Stripe& stripe : stripes_) {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        for (const auto& entry : stripe.entries) out.push_back(entry.second);
+    }
+    std::sort(out.begin(), out.end(), [](const FingerprintStats& a, const FingerprintStats& b) {
+        return a.totalNanos > b.totalNanos;
+    });
+    return out;
+}
+
+std::vector<StatementStats::SlowStatement> StatementStats::slowest() const {
+    std::vector<SlowStatement> out;
+    {
+        std::lock_guard<std::mutex> lock(slowMutex_);
+        out = slow_;
+    }
+    std::sort(out.begin(), out.end(), slower);
+    return out;
+}
+
+void StatementStats::reset() {
+    for (Stripe& stripe : stripes_) {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        stripe.entries.clear();
+    }
+    std::lock_guard<std::mutex> lock(slowMutex_);
+    slow_.clear();
+    admitNanos_.store(slowestSamples_ == 0 ? std::numeric_limits<int64_t>::max() : slowThresholdNanos_,
+                      std::memory_order_relaxed);
+}
+
+nlohmann::json StatementStats::toJson() const {
+    nlohmann::json fingerprintsJson = nlohmann::json::array();
+    for (const auto& f : fingerprints()) {
+        fingerprintsJson.push_back({
+            { "backend", f.backend },
+            { "fingerprint", f.fingerprint },
+            { "calls", f.calls },
+            { "errors", f.errors },
+            { "rows", f.rows },
+            { "total_us", micros(f.totalNanos) },
+            { "mean_us", f.calls ? micros(f.totalNanos) / static_cast<double>(f.calls) : 0.0 },
+            { "max_us", micros(f.maxNanos) }
+        });
+    }
+
+    nlohmann::json slowJson = nlohmann::json::array();
+    for (const auto& s : slowest()) {
+        slowJson.push_back({
+            { "backend", s.backend },
+            { "fingerprint", s.fingerprint },
+            { "sql", s.sql },
+            { "params", s.params },
+            { "duration_us", micros(s.nanos) },
+            { "rows", s.rows },
+            { "failed", s.failed },
+            { "finished_at", formatTime(s.finishedAt) }
+        });
+    }
+
+    return nlohmann::json{
+        { "fingerprints", fingerprintsJson },
+        { "slowest", slowJson }
+    };
+}
+
+void StatementStats::print(std::ostream& out, size_t topFingerprints) const {
+    const auto all = fingerprints();
+    out << "Statements by total time (" << std::min(topFingerprints, all.size()) << " of " << all.size() << ")\n";
+    out << std::right << std::setw(10) << "calls" << std::setw(8) << "errors" << std::setw(12) << "total ms"
+        << std::setw(12) << "mean us" << std::setw(12) << "max us" << std::setw(10) << "rows" << "  statement\n";
+    char line[96];
+    for (size_t i = 0; i < all.size() && i < topFingerprints; ++i) {
+        const auto& f = all[i];
+        std::snprintf(line, sizeof(line), "%10lld%8lld%12.1f%12.1f%12.1f%10lld  ",
+                      static_cast<long long>(f.calls), static_cast<long long>(f.errors),
+                      static_cast<double>(f.totalNanos) / 1e6,
+                      f.calls ? micros(f.totalNanos) / static_cast<double>(f.calls) : 0.0,
+                      micros(f.maxNanos), static_cast<long long>(f.rows));
+        out << line << "[" << f.backend << "] " << f.fingerprint << "\n";
+    }
+
+    const auto slow = slowest();
+    if (slow.empty()) return;
+    out << "\nSlowest executions\n";
+    for (const auto& s : slow) {
+        std::snprintf(line, sizeof(line), "%12.1f us %8lld rows  ", micros(s.nanos), static_cast<long long>(s.rows));
+        out << line << formatTime(s.finishedAt) << "  [" << s.backend << "] " << s.sql;
+        if (!s.params.empty()) {
+            out << "  params:";
+            for (size_t p = 0; p < s.params.size(); ++p) out << (p ? ", " : " ") << "'" << s.params[p] << "'";
+        }
+        if (s.failed) out << "  (failed)";
+        out << "\n";
+    }
+}
+
+PeriodicTask::PeriodicTask(std::chrono::milliseconds interval, std::function<void()> task) {
+    thread_ = std::thread([this, interval, task = std::move(task)] {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!wake_.wait_for(lock, interval, [this] { return stop_; })) {
+            lock.unlock();
+            try {
+                task();
+            } catch (...) {
+            }
+            lock.lock();
+        }
+    });
+}
+
+PeriodicTask::~PeriodicTask() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+}
+
+} // namespace utils
+} // namespace hftools